@@ -6,6 +6,7 @@
 #include <sandbox/rendering/sprite.h>
 #include <sandbox/rendering/line.h>
 #include <sandbox/rendering/model.h>
+#include <sandbox/rendering/staticBatch.h>
 #include <sandbox/rendering/string.h>
 #include <sandbox/rendering/terrain.h>
 #include <sandbox/rendering/text.h>
@@ -66,6 +67,9 @@ public:
 
 struct Scene
 {
+    static constexpr size_t NUM_LANDMARKS = 8;
+    static constexpr float LANDMARK_DISTANCE = 60.f;
+
     std::shared_ptr<sb::Shader> colorShader;
     std::shared_ptr<sb::Shader> textureShader;
     std::shared_ptr<sb::Shader> textureLightShader;
@@ -76,17 +80,20 @@ struct Scene
     sb::Line zaxis;
 
     sb::Sprite crosshair;
-    sb::Model skybox;
-    sb::Terrain terrain;
+    // never change but for the skybox following the camera, so they are
+    // drawn by the static batch
+    std::shared_ptr<sb::Model> skybox;
+    std::shared_ptr<sb::Terrain> terrain;
+    std::vector<std::shared_ptr<sb::Model>> landmarks;
 
     sb::Light pointLight = sb::Light::point(sb::Vec3(10.0, 10.0, 0.0), 100.0f);
     sb::Light parallelLight = sb::Light::parallel(sb::Vec3(5.0f, -10.0f, 5.0f), 100.0f);
 
     Scene():
-        colorShader(gResourceMgr.getShader("proj_basic.vert", "color.frag")),
-        textureShader(gResourceMgr.getShader("proj_texture.vert", "texture.frag")),
-        textureLightShader(gResourceMgr.getShader("proj_texture_normal.vert", "texture_normal.frag")),
-        shadowShader(gResourceMgr.getShader("proj_shadow.vert", "shadow.frag")),
+        colorShader(gResourceMgr.getShaderAsync("proj_basic.vert", "color.frag")),
+        textureShader(gResourceMgr.getShaderAsync("proj_texture.vert", "texture.frag")),
+        textureLightShader(gResourceMgr.getShaderAsync("proj_texture_normal.vert", "texture_normal.frag")),
+        shadowShader(gResourceMgr.getShaderAsync("proj_shadow.vert", "shadow.frag")),
         xaxis(sb::Vec3(1000.f, 0.f, 0.f),
               sb::Color::Red, colorShader),
         yaxis(sb::Vec3(0.f, 1000.f, 0.f),
@@ -94,22 +101,38 @@ struct Scene
         zaxis(sb::Vec3(0.f, 0.f, 1000.f),
               sb::Color::Green, colorShader),
         crosshair("dot.png", textureShader),
-        skybox("skybox.obj", textureShader,
-               gResourceMgr.getTexture("miramar.jpg")),
-        terrain("hmap_flat.jpg", "ground.jpg", shadowShader),
+        skybox(std::make_shared<sb::Model>(
+                gResourceMgr.getMeshAsync("skybox.obj"), textureShader,
+                gResourceMgr.getTextureStreamed("miramar.jpg"))),
+        terrain(std::make_shared<sb::Terrain>(
+                gResourceMgr.getTerrainAsync("hmap_flat.jpg"),
+                gResourceMgr.getTextureStreamed("ground.jpg"), shadowShader)),
+        landmarks(),
         pointLight(sb::Light::point(sb::Vec3(10.0, 10.0, 0.0), 100.0f)),
         parallelLight(sb::Light::parallel(sb::Vec3(5.0f, -10.0f, 5.0f), 100.0f))
     {
         crosshair.setPosition(0.f, 0.f, 0.f);
         crosshair.setScale(0.01f, 0.01f * 1.33f, 1.f);
 
-        skybox.setScale(1000.f);
+        skybox->setScale(1000.f);
+
+        terrain->setScale(10.f, 1.f, 10.f);
+        terrain->setPosition(-640.f, 0.f, -640.f);
+        terrain->setTexture("tex2", gResourceMgr.getTextureStreamed("blue_marble.jpg"));
 
-        terrain.setScale(10.f, 1.f, 10.f);
-        terrain.setPosition(-640.f, 0.f, -640.f);
-        terrain.setTexture("tex2", gResourceMgr.getTexture("blue_marble.jpg"));
+        for (size_t i = 0; i < NUM_LANDMARKS; ++i) {
+            auto landmark = std::make_shared<sb::Model>(
+                    gResourceMgr.getMeshAsync("sphere.obj"), textureLightShader,
+                    gResourceMgr.getTextureStreamed("ground.jpg"));
 
-        gLog.info("all data loaded!\n");
+            const float angle = 2.f * PI * (float)i / (float)NUM_LANDMARKS;
+            landmark->setPosition(LANDMARK_DISTANCE * std::cos(angle), 5.f,
+                                  LANDMARK_DISTANCE * std::sin(angle));
+            landmark->setScale(2.f, 10.f, 2.f);
+            landmarks.push_back(landmark);
+        }
+
+        gLog.info("scene created, resources still loading\n");
     }
 };
 
@@ -142,6 +165,8 @@ public:
     bool displaySimInfo;
     bool displayBallInfo;
 
+    sb::StaticBatch::Handle skyboxHandle;
+
     Game():
         wnd(1280, 1024),
         scene(),
@@ -157,7 +182,8 @@ public:
         windVelocity(0.5f, 0.5f),
         displayHelp(false),
         displaySimInfo(false),
-        displayBallInfo(false)
+        displayBallInfo(false),
+        skyboxHandle(0)
     {
         wnd.setTitle("Sandbox");
         wnd.lockCursor();
@@ -166,6 +192,15 @@ public:
 
         sim.setThrowStart(sb::Vec3d(0., 1., 0.), sb::Vec3d(30., 30., 0.));
 
+        // the skybox and terrain keep their own shaders; landmarks use plain
+        // textured lighting, which the batch shader reproduces
+        sb::StaticBatch& staticBatch = wnd.getRenderer().getStaticBatch();
+        skyboxHandle = staticBatch.add(scene.skybox);
+        staticBatch.add(scene.terrain);
+        for (const std::shared_ptr<sb::Model>& landmark: scene.landmarks) {
+            staticBatch.add(landmark, true);
+        }
+
         deltaTime.reset();
         fpsDeltaTime.reset();
     }
@@ -181,6 +216,7 @@ public:
             "f2 - show/hide simulation info\n"
             "f3 - show/hide ball info\n"
             "f4 - show/hide ball launcher lines\n"
+            "f5 - log resource memory usage\n"
             "f8 - exit + display debug info\n"
             "print screen - save screenshot\n"
             "p - pause simulation\n"
@@ -260,10 +296,7 @@ public:
         wnd.addLight(scene.pointLight);
         wnd.addLight(scene.parallelLight);
 
-        // environment
-        wnd.draw(scene.skybox);
-        wnd.draw(scene.terrain);
-
+        // skybox, terrain and landmarks are drawn by the static batch
         drawBoids();
 
         // axes - disable edpth test to prevent blinking
@@ -277,7 +310,7 @@ public:
         sim.drawAll(wnd.getRenderer());
 
         // crosshair
-        wnd.draw(scene.crosshair);
+        wnd.getRenderer().getSpriteBatch().add(scene.crosshair);
 
         drawStrings();
 
@@ -341,7 +374,8 @@ public:
         wnd.getCamera().moveRelative(speed);
 
         // move skybox, so player won't go out of it
-        scene.skybox.setPosition(wnd.getCamera().getEye());
+        scene.skybox->setPosition(wnd.getCamera().getEye());
+        wnd.getRenderer().getStaticBatch().updateTransform(skyboxHandle);
     }
 
     void handleMousePressed(const sb::Event& e)
@@ -545,6 +579,17 @@ public:
         case sb::Key::F4:
             sim.toggleShowLauncherLines();
             break;
+        case sb::Key::F5:
+            for (const sb::ResourceMgr::CategoryStats& stats:
+                    gResourceMgr.getStats()) {
+                gLog.info("%s: %lu resident, %lu KiB CPU, %lu KiB GPU, "
+                          "budget %lu KiB, %lu evicted",
+                          stats.name, stats.numResources,
+                          stats.resident.cpuBytes / 1024,
+                          stats.resident.gpuBytes / 1024,
+                          stats.budgetBytes / 1024, stats.numEvicted);
+            }
+            break;
         case sb::Key::PrintScreen:
             {
 #ifdef PLATFORM_WIN32
@@ -183,32 +183,18 @@ namespace Sim
     {
         r.draw(*mModel);
 
-        // temporarily disable depth testing, to make lines fully visible
-        r.enableFeature(sb::Renderer::Feature::DepthTest, false);
-        if (mPath.size() > 1)
-        {
-            static sb::Line line(sb::Vec3(1.f, 1.f, 1.f),
-                                 sb::Color(ColorPath, 0.6f),
-                                 mLineShader);
-
-            std::list<sb::Vec3d>::iterator it, next;
-            for (it = mPath.begin(), next = ++it; next != mPath.end(); it = next++)
-            {
-                line.setPosition(*it);
-                line.setScale(*next - *it);
-                r.draw(line);
-            }
+        // no depth testing, to make lines fully visible
+        sb::DebugDraw& debug = r.getDebugDraw();
+        debug.polyline(mPath.begin(), mPath.end(),
+                       sb::Color(ColorPath, 0.6f), false);
+
+        for (const ColVec* vec: { &mVelocity, &mAccGravity, &mAccDrag,
+                                  &mAccWind, &mAccBuoyancy, &mAccNet }) {
+            const sb::Line& line = vec->second;
+            debug.arrow(line.getPosition(),
+                        line.getPosition() + line.getScale(),
+                        line.getColor(), false);
         }
-
-        r.draw(mVelocity.second);
-
-        r.draw(mAccGravity.second);
-        r.draw(mAccDrag.second);
-        r.draw(mAccWind.second);
-        r.draw(mAccBuoyancy.second);
-        r.draw(mAccNet.second);
-
-        r.enableFeature(sb::Renderer::Feature::DepthTest);
     }
 
     void Ball::attachLines()
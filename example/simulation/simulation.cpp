@@ -137,9 +137,14 @@ namespace Sim
     void Simulation::drawAll(sb::Renderer& renderer)
     {
         if (mShowLauncherLines) {
-            renderer.draw(*mThrowStartLine);
-            renderer.draw(*mGravityLine);
-            renderer.draw(*mWindVelocityLine);
+            sb::DebugDraw& debug = renderer.getDebugDraw();
+            for (const sb::Line* line: { mThrowStartLine.get(),
+                                         mGravityLine.get(),
+                                         mWindVelocityLine.get() }) {
+                debug.arrow(line->getPosition(),
+                            line->getPosition() + line->getScale(),
+                            line->getColor());
+            }
         }
 
         for (auto &ball_ptr: mBalls) {
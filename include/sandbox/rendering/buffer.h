@@ -8,8 +8,21 @@ namespace sb
     class Buffer
     {
     public:
+        enum class WriteMode {
+            // glBufferSubData; the driver may stall until draws reading the
+            // buffer are done
+            SubData,
+            // mapped write invalidating the written range, so that the
+            // driver may hand out fresh memory instead of waiting
+            InvalidateRange,
+            // mapped write without any synchronization; only safe if no
+            // pending draw reads the written range
+            Unsynchronized
+        };
+
         Buffer(const void* data,
-               size_t bytes);
+               size_t bytes,
+               GLenum usage = GL_DYNAMIC_DRAW);
 
         Buffer(const Buffer&) = delete;
         Buffer& operator =(const Buffer&) = delete;
@@ -23,13 +36,33 @@ namespace sb
                   GLuint bufferBinding) const;
         void unbind() const;
 
+        // replaces buffer contents, orphaning the old storage so that the
+        // driver does not have to wait for draws still using it; grows the
+        // buffer if needed
+        void upload(const void* data,
+                    size_t bytes);
+
+        // replaces part of the buffer contents, without orphaning
+        void write(size_t offsetBytes,
+                   const void* data,
+                   size_t bytes,
+                   WriteMode mode = WriteMode::SubData);
+
         BufferId getId() const { return id; }
+        size_t getSize() const { return sizeBytes; }
 
     private:
         BufferId id;
+        size_t sizeBytes;
+        GLenum usage;
 
         mutable GLuint bufferType;
         mutable BufferId prevId;
+
+        void mapAndCopy(size_t offsetBytes,
+                        const void* data,
+                        size_t bytes,
+                        GLbitfield extraAccess);
     };
 } // namespace sb
 
@@ -0,0 +1,90 @@
+#ifndef RENDERING_DEBUGDRAW_H
+#define RENDERING_DEBUGDRAW_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/color.h>
+#include <sandbox/rendering/vertexBuffer.h>
+#include <sandbox/utils/types.h>
+
+namespace sb {
+
+class Camera;
+class Shader;
+
+// Immediate-mode line drawing for debug visualizations. Primitives are
+// collected during the frame and drawn in one GL_LINES call per depth test
+// setting when the renderer flushes them.
+class DebugDraw
+{
+public:
+    DebugDraw();
+
+    DebugDraw(const DebugDraw&) = delete;
+    DebugDraw& operator =(const DebugDraw&) = delete;
+
+    void line(const Vec3& from,
+              const Vec3& to,
+              const Color& color,
+              bool depthTest = true);
+    void arrow(const Vec3& from,
+               const Vec3& to,
+               const Color& color,
+               bool depthTest = true);
+    void polyline(const std::vector<Vec3>& points,
+                  const Color& color,
+                  bool depthTest = true);
+    // any range of points convertible to Vec3, e.g. a std::list<Vec3d>,
+    // without copying it first
+    template<typename Iterator>
+    void polyline(Iterator begin,
+                  Iterator end,
+                  const Color& color,
+                  bool depthTest = true)
+    {
+        if (begin == end) {
+            return;
+        }
+
+        Vec3 prev = *begin;
+        for (++begin; begin != end; ++begin) {
+            Vec3 next = *begin;
+            line(prev, next, color, depthTest);
+            prev = next;
+        }
+    }
+    void sphere(const Vec3& center,
+                float radius,
+                const Color& color,
+                bool depthTest = true);
+    void aabb(const Vec3& min,
+              const Vec3& max,
+              const Color& color,
+              bool depthTest = true);
+
+    // draws everything added since last flush
+    void flush(Camera& camera);
+
+private:
+    struct Bucket
+    {
+        std::vector<Vec3> positions;
+        std::vector<Color> colors;
+    };
+
+    // indexed by depthTest
+    std::array<Bucket, 2> mBuckets;
+    std::shared_ptr<Shader> mShader;
+    std::unique_ptr<VertexBuffer> mVertexBuffer;
+
+    // staging area for all buckets, kept to avoid reallocating every frame
+    std::vector<Vec3> mPositions;
+    std::vector<Color> mColors;
+};
+
+} // namespace sb
+
+#endif // RENDERING_DEBUGDRAW_H
@@ -5,6 +5,7 @@
 #include <sandbox/rendering/color.h>
 #include <sandbox/rendering/shader.h>
 #include <sandbox/rendering/renderer.h>
+#include <sandbox/rendering/textureArray.h>
 #include <sandbox/resources/resourceMgr.h>
 
 #include <vector>
@@ -49,9 +50,18 @@ namespace sb
         void setTexture(const std::string& uniformName,
                         const std::shared_ptr<const Texture>& tex);
 
+        // binds layer.array to sampler2DArray uniformName and sets the
+        // float uniform <uniformName>Layer to the layer index
+        void setTextureLayer(const std::string& uniformName,
+                             const TextureLayer& layer);
+
+        // orders draws so that ones sharing shader and textures are adjacent
+        bool operator <(const Drawable& d) const;
+
     protected:
         std::shared_ptr<Mesh> mMesh;
         std::map<std::string, std::shared_ptr<const Texture>> mTextures;
+        std::map<std::string, TextureLayer> mTextureLayers;
         std::shared_ptr<Shader> mShader;
         Color mColor;
 
@@ -80,10 +90,20 @@ namespace sb
                  const std::shared_ptr<Shader>& shader);
 
         void recalculateMatrices() const;
+        const void* getTextureKey() const;
+
+        // light and shadow uniforms of state, for shaders that declare them
+        static void setLightUniforms(const Renderer::State& state,
+                                     const std::shared_ptr<Shader>& shader);
+        static void setShadowUniforms(Renderer::State& state,
+                                      const std::shared_ptr<const Shader>& shader,
+                                      size_t firstTextureUnit,
+                                      std::vector<bind_guard<Texture>>& outBinds);
 
         virtual void draw(Renderer::State& rendererState) const;
 
         friend class Renderer;
+        friend class StaticBatch;
     };
 } // namespace sb
 
@@ -0,0 +1,62 @@
+#ifndef RENDERING_DYNAMICRESOLUTION_H
+#define RENDERING_DYNAMICRESOLUTION_H
+
+#include <array>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/framebuffer.h>
+#include <sandbox/utils/types.h>
+#include <sandbox/utils/rect.h>
+
+namespace sb {
+
+// Picks a 3D scene render scale between MIN_SCALE and MAX_SCALE so that
+// the GPU frame time stays below the configured budget. GPU time is
+// measured with GL_TIME_ELAPSED queries, read back a few frames late to
+// avoid stalling the pipeline.
+class DynamicResolution
+{
+public:
+    static constexpr float MIN_SCALE = 0.5f;
+    static constexpr float MAX_SCALE = 1.0f;
+
+    DynamicResolution(float frameTimeBudgetMs);
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator =(const DynamicResolution&) = delete;
+
+    void beginFrame();
+    void endFrame();
+
+    void setFrameTimeBudget(float ms) { mBudgetMs = ms; }
+    float getFrameTimeBudget() const { return mBudgetMs; }
+    float getAverageFrameTime() const { return mAverageMs; }
+    float getScale() const { return mScale; }
+
+    Vec2i getScaledSize(const Vec2i& fullSize) const;
+
+    // upscales the scaled region of a color target as big as target into
+    // target rectangle of the currently bound draw framebuffer
+    void blit(const Framebuffer& source,
+              const IntRect& target) const;
+
+private:
+    static const size_t NUM_QUERIES = 4;
+
+    std::array<GLuint, NUM_QUERIES> mQueries;
+    std::array<bool, NUM_QUERIES> mQueryPending;
+    size_t mCurrentQuery;
+
+    float mBudgetMs;
+    float mAverageMs;
+    float mScale;
+    uint32_t mFramesSinceRescale;
+
+    void collectResults();
+    void updateScale();
+};
+
+} // namespace sb
+
+#endif // RENDERING_DYNAMICRESOLUTION_H
@@ -13,8 +13,14 @@ namespace sb {
 class Framebuffer
 {
 public:
+    enum class Attachments {
+        Depth,
+        ColorDepth
+    };
+
     Framebuffer(uint32_t width,
-                uint32_t height);
+                uint32_t height,
+                Attachments attachments = Attachments::Depth);
 
     Framebuffer(const Framebuffer&) = delete;
     Framebuffer& operator =(const Framebuffer&) = delete;
@@ -26,11 +32,19 @@ public:
     void bind() const;
     void unbind() const;
 
+    // regenerates depth texture mipmaps after rendering
+    void generateMipmaps() const;
+
     BufferId getId() const { return id; }
     std::shared_ptr<const Texture> getTexture() const
     {
         return texture;
     }
+    // null unless created with Attachments::ColorDepth
+    std::shared_ptr<const Texture> getColorTexture() const
+    {
+        return colorTexture;
+    }
 
     const Vec2i& getSize() const { return sizePixels; }
 
@@ -41,6 +55,7 @@ private:
     BufferId renderbufferId;
 #endif
     std::shared_ptr<Texture> texture;
+    std::shared_ptr<Texture> colorTexture;
 };
 
 } // namespace sb
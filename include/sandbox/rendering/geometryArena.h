@@ -0,0 +1,109 @@
+#ifndef RENDERING_GEOMETRYARENA_H
+#define RENDERING_GEOMETRYARENA_H
+
+#include <memory>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/buffer.h>
+#include <sandbox/rendering/vertexBuffer.h>
+#include <sandbox/utils/rangeAllocator.h>
+
+namespace sb {
+
+// Shared vertex and index storage for all meshes with the same vertex layout
+// and attribute set. Meshes are sub-allocated from two large buffers and
+// drawn with glDrawElementsBaseVertex, so all of them share a single VAO.
+// Buffers are doubled in size when full; the arena is released together
+// with the last mesh using it.
+class GeometryArena
+{
+public:
+    static const size_t INITIAL_VERTICES = 64 * 1024;
+    static const size_t INITIAL_INDEX_BYTES = 256 * 1024;
+
+    struct Allocation
+    {
+        size_t baseVertex;
+        size_t numVertices;
+        size_t indexOffsetBytes;
+        size_t indexSizeBytes;
+        size_t numIndices;
+        GLenum indexType;
+    };
+
+    // returns existing arena for given layout and attributes if there is one
+    static std::shared_ptr<GeometryArena> get(const VertexLayout& layout,
+                                              const std::vector<Attrib::Kind>& attribs);
+
+    GeometryArena(const VertexLayout& layout,
+                  const std::vector<Attrib::Kind>& attribs);
+    ~GeometryArena();
+
+    GeometryArena(const GeometryArena&) = delete;
+    GeometryArena& operator =(const GeometryArena&) = delete;
+
+    bool matches(const VertexLayout& layout,
+                 const std::vector<Attrib::Kind>& attribs) const
+    {
+        return mLayout == layout && mAttribs == attribs;
+    }
+
+    // vertexData must be interleaved according to the arena layout;
+    // indices are relative to the first vertex of the allocation
+    Allocation allocate(const std::vector<uint8_t>& vertexData,
+                        const std::vector<uint32_t>& indices);
+    // same, with indices already packed as indexType; data is uploaded
+    // straight from given pointers, which may point into a mapped file
+    Allocation allocate(const void* vertexData,
+                        size_t numVertices,
+                        const void* indexData,
+                        size_t numIndices,
+                        GLenum indexType);
+    void free(const Allocation& allocation);
+
+    // true if allocation is big enough to hold numVertices and indices
+    bool fits(const Allocation& allocation,
+              size_t numVertices,
+              const std::vector<uint32_t>& indices) const;
+    // in-place updates; data must fit within the allocation
+    void writeVertices(const Allocation& allocation,
+                       size_t firstVertex,
+                       const std::vector<uint8_t>& vertexData,
+                       Buffer::WriteMode mode = Buffer::WriteMode::SubData);
+    void writeIndices(const Allocation& allocation,
+                      size_t firstIndex,
+                      const std::vector<uint32_t>& indices,
+                      Buffer::WriteMode mode = Buffer::WriteMode::SubData);
+
+    // binds the shared VAO, with the index buffer attached
+    void bind() const;
+    void unbind() const;
+
+    const std::vector<Attrib::Kind>& getAttribs() const { return mAttribs; }
+    const VertexLayout& getLayout() const { return mLayout; }
+
+private:
+    VertexLayout mLayout;
+    std::vector<Attrib::Kind> mAttribs;
+    size_t mStride;
+
+    BufferId mVAO;
+    std::unique_ptr<Buffer> mVertexBuffer;
+    std::unique_ptr<Buffer> mIndexBuffer;
+
+    // vertex allocator works in vertices, index allocator in bytes
+    RangeAllocator mVertexAllocator;
+    RangeAllocator mIndexAllocator;
+
+    size_t allocateFrom(RangeAllocator& allocator,
+                        std::unique_ptr<Buffer>& buffer,
+                        size_t unitBytes,
+                        size_t size,
+                        size_t alignment);
+    void setupVertexArray();
+};
+
+} // namespace sb
+
+#endif // RENDERING_GEOMETRYARENA_H
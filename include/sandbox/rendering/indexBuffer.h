@@ -7,18 +7,46 @@
 
 namespace sb
 {
+    // GL_UNSIGNED_SHORT if all indices fit in 16 bits, GL_UNSIGNED_INT
+    // otherwise
+    GLenum chooseIndexType(const std::vector<uint32_t>& indices);
+    size_t getIndexSize(GLenum indexType);
+    // raw bytes of indices stored as given type
+    std::vector<uint8_t> packIndices(const std::vector<uint32_t>& indices,
+                                     GLenum type);
+
+    // stores indices using the type returned by chooseIndexType
     class IndexBuffer: public Buffer
     {
     public:
-        IndexBuffer(const std::vector<uint32_t>& indices):
-            Buffer(&indices[0], indices.size() * sizeof(uint32_t))
-        {}
+        IndexBuffer(const std::vector<uint32_t>& indices);
 
         void bind() const
         {
             Buffer::bind(GL_ELEMENT_ARRAY_BUFFER,
                          GL_ELEMENT_ARRAY_BUFFER_BINDING);
         }
+
+        // replaces all indices, growing the buffer if needed; the index
+        // type may change
+        void setIndices(const std::vector<uint32_t>& indices);
+        // overwrites indices [firstIndex, firstIndex + indices.size());
+        // all of them must fit in the current index type
+        void writeIndices(size_t firstIndex,
+                          const std::vector<uint32_t>& indices,
+                          WriteMode mode = WriteMode::SubData);
+
+        GLenum getType() const { return mType; }
+        size_t getIndexSize() const;
+        size_t getNumIndices() const { return mNumIndices; }
+
+    private:
+        GLenum mType;
+        size_t mNumIndices;
+
+        // shortIndices is empty if indices do not fit in 16 bits
+        IndexBuffer(const std::vector<uint32_t>& indices,
+                    const std::vector<uint16_t>& shortIndices);
     };
 } // namespace sb
 
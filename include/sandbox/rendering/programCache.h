@@ -0,0 +1,60 @@
+#ifndef RENDERING_PROGRAMCACHE_H
+#define RENDERING_PROGRAMCACHE_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/shader.h>
+
+namespace sb {
+
+// On-disk cache of linked shader programs (ARB_get_program_binary), stored
+// together with the interface metadata that Shader would otherwise parse
+// from sources. Entries are keyed by a hash of all program sources and of
+// GL_RENDERER/GL_VERSION, so that editing a shader or updating the driver
+// simply misses the cache.
+class ProgramCache
+{
+public:
+    struct Entry
+    {
+        GLenum binaryFormat;
+        std::vector<uint8_t> binary;
+
+        std::vector<std::string> filenames;
+        std::map<Attrib::Kind, Input> inputs;
+        std::set<Uniform> uniforms;
+    };
+
+    // creates the directory if needed; an empty path, or a context without
+    // program binary support, disables the cache
+    explicit ProgramCache(const std::string& directory);
+
+    // $XDG_CACHE_HOME/sandbox/programs, or ~/.cache/sandbox/programs
+    static std::string getDefaultDirectory();
+
+    bool isEnabled() const { return !mDirectory.empty(); }
+
+    uint64_t makeKey(const std::vector<std::string>& sources) const;
+
+    // false if there is no valid entry for given key
+    bool load(uint64_t key,
+              Entry& outEntry) const;
+    void store(uint64_t key,
+               const Entry& entry) const;
+    // drops an entry, e.g. one the driver refused to load
+    void remove(uint64_t key) const;
+
+private:
+    std::string mDirectory;
+    uint64_t mDriverHash;
+
+    std::string getPath(uint64_t key) const;
+};
+
+} // namespace sb
+
+#endif // RENDERING_PROGRAMCACHE_H
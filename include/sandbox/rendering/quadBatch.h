@@ -0,0 +1,67 @@
+#ifndef RENDERING_QUADBATCH_H
+#define RENDERING_QUADBATCH_H
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/color.h>
+#include <sandbox/rendering/vertexBuffer.h>
+#include <sandbox/rendering/indexBuffer.h>
+#include <sandbox/utils/types.h>
+
+namespace sb {
+
+class Camera;
+class Shader;
+class Texture;
+
+// Streams textured, per-vertex tinted quads into one vertex buffer. All
+// quads share a static index pattern; flush() issues one draw call per
+// texture, in order of first use.
+class QuadBatch
+{
+public:
+    // corner order: (x0, y0), (x1, y0), (x0, y1), (x1, y1)
+    typedef std::array<Vec3, 4> Positions;
+    typedef std::array<Vec2, 4> Texcoords;
+
+    QuadBatch();
+
+    QuadBatch(const QuadBatch&) = delete;
+    QuadBatch& operator =(const QuadBatch&) = delete;
+
+    void add(const std::shared_ptr<const Texture>& texture,
+             const Positions& positions,
+             const Texcoords& texcoords,
+             const Color& color);
+
+    void flush(Camera& camera);
+
+private:
+    struct Page
+    {
+        std::shared_ptr<const Texture> texture;
+        std::vector<Vec3> positions;
+        std::vector<Vec2> texcoords;
+        std::vector<Color> colors;
+    };
+
+    std::vector<Page> mPages;
+    std::shared_ptr<Shader> mShader;
+    std::unique_ptr<VertexBuffer> mVertexBuffer;
+    std::unique_ptr<IndexBuffer> mIndexBuffer;
+    size_t mIndexCapacityQuads;
+
+    std::vector<Vec3> mPositions;
+    std::vector<Vec2> mTexcoords;
+    std::vector<Color> mColors;
+
+    Page& getPage(const std::shared_ptr<const Texture>& texture);
+    void reserveQuads(size_t numQuads);
+};
+
+} // namespace sb
+
+#endif // RENDERING_QUADBATCH_H
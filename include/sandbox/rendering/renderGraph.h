@@ -0,0 +1,135 @@
+#ifndef RENDERING_RENDERGRAPH_H
+#define RENDERING_RENDERGRAPH_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/framebuffer.h>
+
+namespace sb {
+
+// Per-frame list of render passes. Each pass declares which targets it
+// reads and which single target it renders into; execute() then:
+// - culls passes that do not contribute to the backbuffer,
+// - orders the rest so that consecutive passes share a target if possible,
+// - assigns transient targets from a pool, reusing a framebuffer once its
+//   previous user is done with it,
+// - generates mipmaps only for targets that a later pass asked for.
+class RenderGraph
+{
+public:
+    typedef size_t ResourceHandle;
+    typedef std::function<void(const RenderGraph&)> ExecuteFunc;
+
+    // framebuffers not used for this many frames are released
+    static const uint32_t MAX_UNUSED_FRAMES = 60;
+
+    class PassBuilder
+    {
+    public:
+        PassBuilder& read(ResourceHandle resource,
+                          bool needsMipmaps = false);
+        PassBuilder& write(ResourceHandle resource);
+        // never cull this pass, even if nothing reads its output
+        PassBuilder& sideEffect();
+
+    private:
+        RenderGraph& mGraph;
+        size_t mPass;
+
+        PassBuilder(RenderGraph& graph, size_t pass):
+            mGraph(graph),
+            mPass(pass)
+        {}
+
+        friend class RenderGraph;
+    };
+
+    RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator =(const RenderGraph&) = delete;
+
+    ResourceHandle getBackbuffer() const { return BACKBUFFER; }
+
+    // target that lives across frames, e.g. a shadow map
+    ResourceHandle import(const std::string& name,
+                          const std::shared_ptr<Framebuffer>& framebuffer,
+                          Framebuffer::Attachments attachments);
+    // target that only lives between its first and last use in this frame
+    ResourceHandle createTarget(const std::string& name,
+                                const Vec2i& size,
+                                Framebuffer::Attachments attachments);
+
+    PassBuilder addPass(const std::string& name,
+                        ExecuteFunc execute);
+
+    // valid only for resources used by the currently executing pass
+    const Framebuffer& getFramebuffer(ResourceHandle resource) const;
+
+    void execute();
+    // drops all passes and resources, keeps pooled framebuffers
+    void reset();
+    // frees pooled framebuffers; must be called while the GL context exists
+    void releaseTargets();
+
+private:
+    static const ResourceHandle BACKBUFFER = 0;
+
+    struct Resource
+    {
+        std::string name;
+        Vec2i size;
+        Framebuffer::Attachments attachments;
+        std::shared_ptr<Framebuffer> framebuffer;
+        bool imported;
+        bool mipmapsDirty;
+    };
+
+    struct Read
+    {
+        ResourceHandle resource;
+        bool needsMipmaps;
+    };
+
+    struct Pass
+    {
+        std::string name;
+        ExecuteFunc execute;
+        std::vector<Read> reads;
+        std::vector<ResourceHandle> writes;
+        bool hasSideEffects;
+    };
+
+    struct PooledTarget
+    {
+        std::shared_ptr<Framebuffer> framebuffer;
+        Framebuffer::Attachments attachments;
+        bool inUse;
+        bool usedThisFrame;
+        uint32_t unusedFrames;
+    };
+
+    std::vector<Resource> mResources;
+    std::vector<Pass> mPasses;
+    std::vector<PooledTarget> mPool;
+
+    bool writes(const Pass& pass, ResourceHandle resource) const;
+    bool reads(const Pass& pass, ResourceHandle resource) const;
+
+    std::vector<std::vector<size_t>> findDependencies() const;
+    std::vector<bool> cull(const std::vector<std::vector<size_t>>& deps) const;
+    std::vector<size_t> order(const std::vector<std::vector<size_t>>& deps,
+                              const std::vector<bool>& needed) const;
+
+    std::shared_ptr<Framebuffer> acquire(const Resource& resource);
+    void release(const std::shared_ptr<Framebuffer>& framebuffer);
+    void trimPool();
+};
+
+} // namespace sb
+
+#endif // RENDERING_RENDERGRAPH_H
@@ -9,6 +9,11 @@
 #include <sandbox/rendering/camera.h>
 #include <sandbox/rendering/light.h>
 #include <sandbox/rendering/framebuffer.h>
+#include <sandbox/rendering/dynamicResolution.h>
+#include <sandbox/rendering/renderGraph.h>
+#include <sandbox/rendering/debugDraw.h>
+#include <sandbox/rendering/textBatch.h>
+#include <sandbox/rendering/spriteBatch.h>
 
 #include <sandbox/utils/rect.h>
 
@@ -20,6 +25,8 @@
 namespace sb
 {
     class Drawable;
+    class StaticBatch;
+    class UploadContext;
 
     class Renderer
     {
@@ -94,6 +101,21 @@ namespace sb
         void draw(const std::shared_ptr<Drawable>& d) { draw(*d); }
         void drawAll();
 
+        // group draws by shader and texture instead of submission order;
+        // off by default, as it breaks back-to-front ordering of blended
+        // geometry
+        void setDrawableSorting(bool enable) { mSortDrawables = enable; }
+
+        // lines drawn with the perspective camera on next drawAll()
+        DebugDraw& getDebugDraw();
+        // screen-space text drawn on top of everything on next drawAll()
+        TextBatch& getTextBatch();
+        // atlas-packed sprites drawn in the HUD pass, below text
+        SpriteBatch& getSpriteBatch();
+        // persistent set of static scenery, drawn every frame before other
+        // perspective drawables
+        StaticBatch& getStaticBatch();
+
         enum class Feature {
             BackfaceCulling = RENDERER_BACKFACE_CULLING,
             DepthTest = RENDERER_DEPTH_TEST,
@@ -102,20 +124,38 @@ namespace sb
         };
 
         void enableFeature(Feature feature, bool enable = true);
+
+        // renders the 3D scene into an offscreen target scaled to keep GPU
+        // frame time under the budget; orthographic drawables are drawn
+        // afterwards at full window resolution
+        void enableDynamicResolution(float frameTimeBudgetMs = 1000.0f / 60.0f);
+        void disableDynamicResolution();
+        float getResolutionScale() const;
         void saveScreenshot(const std::string& filename, int width, int height);
 
     private:
         Color mClearColor;
         IntRect mViewport;
+        Vec2i mViewportSize;
         Camera mCamera;
         Camera mSpriteCamera;
         GLXContext mGLContext;
         ::Display* mDisplay;
+        // shares objects with mGLContext; null if it could not be created
+        std::unique_ptr<UploadContext> mUploadContext;
 
         std::vector<std::shared_ptr<Drawable>> mDrawablesBuffer;
+        bool mSortDrawables;
         Color mAmbientLightColor;
         std::vector<Light> mLights;
 
+        std::unique_ptr<DynamicResolution> mDynamicResolution;
+        RenderGraph mRenderGraph;
+        std::unique_ptr<DebugDraw> mDebugDraw;
+        std::unique_ptr<TextBatch> mTextBatch;
+        std::unique_ptr<SpriteBatch> mSpriteBatch;
+        std::unique_ptr<StaticBatch> mStaticBatch;
+
         bool initGLEW();
 
         enum Filter {
@@ -126,8 +166,14 @@ namespace sb
             ShaderTextureProjectionDepth
         };
 
-        void drawTo(Framebuffer& framebuffer,
-                    Camera& camera) const;
+        // back to mViewport, offset included, after rendering offscreen
+        void restoreViewport() const;
+        void drawShadowMap(Camera& camera) const;
+        void drawStaticBatch(State& rendererState) const;
+        void drawProjected(State& rendererState,
+                           ProjectionType projectionType);
+        void flushDebugDraw();
+        void flushHudBatches();
     };
 } // namespace sb
 
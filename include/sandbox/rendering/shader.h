@@ -72,32 +72,25 @@ namespace sb
     public:
         ConcreteShader(GLuint shaderType,
                        const std::string& path):
-            mShader(0),
-            mFilename(path)
-        {
-            std::string code = utils::readFile(path);
-            GL_CHECK(mShader = glCreateShader(shaderType));
-
-            const GLchar* codePtr = (const GLchar*)&code[0];
-            GL_CHECK(glShaderSource(mShader, 1, &codePtr, NULL));
-
-            static std::map<GLuint, std::string> SHADERS {
-                { GL_VERTEX_SHADER, "vertex" },
-                { GL_FRAGMENT_SHADER, "fragment" },
-                { GL_GEOMETRY_SHADER, "geometry" }
-            };
-
-            gLog.trace("compiling %s shader: %s",
-                       SHADERS[shaderType].c_str(), path.c_str());
-            GL_CHECK(glCompileShader(mShader));
-            if (!shaderCompilationSucceeded(code)) {
-                sbFail("shader compilation failed");
-            }
+            ConcreteShader(shaderType, path, utils::readFile(path))
+        {}
 
-            mInputs = parseInputs(code, shaderType == GL_VERTEX_SHADER);
-            mOutputs = parseOutputs(code);
-            mUniforms = parseUniforms(code);
-        }
+        // name is only used in logs; compilation and parsing are deferred
+        // until first needed, so that shaders of programs loaded from the
+        // binary cache are never compiled
+        ConcreteShader(GLuint shaderType,
+                       const std::string& name,
+                       const std::string& code):
+            mShader(0),
+            mShaderType(shaderType),
+            mStatusChecked(false),
+            mFilename(name),
+            mCode(code),
+            mParsed(false),
+            mInputs(),
+            mOutputs(),
+            mUniforms()
+        {}
 
         ~ConcreteShader()
         {
@@ -106,16 +99,26 @@ namespace sb
             }
         }
 
-        GLuint getShader() const { return mShader; }
-        const std::set<Input>& getInputs() const { return mInputs; }
-        const std::set<Output> getOutputs() const { return mOutputs; }
-        const std::set<Uniform> getUniforms() const { return mUniforms; }
+        // starts compilation without waiting for the result
+        void submit() const;
+        // true once compilation started by submit() finished; always true
+        // without parallel shader compile support, as the check would block
+        bool isCompiled() const;
+        // compiles the shader if needed, failing on compilation errors
+        GLuint getShader() const;
+        const std::set<Input>& getInputs() const { parse(); return mInputs; }
+        const std::set<Output>& getOutputs() const { parse(); return mOutputs; }
+        const std::set<Uniform>& getUniforms() const { parse(); return mUniforms; }
         const std::string& getFilename() const { return mFilename; }
+        const std::string& getCode() const { return mCode; }
+        GLuint getType() const { return mShaderType; }
+        // true if the source mentions given identifier, e.g. a feature define
+        bool references(const std::string& identifier) const;
 
         std::map<Attrib::Kind, Input> makeInputsMap() const {
             std::map<Attrib::Kind, Input> ret;
 
-            for (const Input& input: mInputs) {
+            for (const Input& input: getInputs()) {
                 if (input.kind == Attrib::Kind::Unspecified) {
                     sbFail("input %s is missing a kind annotation in shader %s",
                            input.name.c_str(), mFilename.c_str());
@@ -128,17 +131,23 @@ namespace sb
         }
 
     private:
-        bool shaderCompilationSucceeded(const std::string& source);
+        bool shaderCompilationSucceeded(const std::string& source) const;
+        void parse() const;
         static std::set<Input> parseInputs(const std::string& code,
                                            bool warnOnUntagged);
         static std::set<Output> parseOutputs(const std::string& code);
         static std::set<Uniform> parseUniforms(const std::string& code);
 
-        GLuint mShader;
+        mutable GLuint mShader;
+        GLuint mShaderType;
+        mutable bool mStatusChecked;
         std::string mFilename;
-        std::set<Input> mInputs;
-        std::set<Output> mOutputs;
-        std::set<Uniform> mUniforms;
+        std::string mCode;
+
+        mutable bool mParsed;
+        mutable std::set<Input> mInputs;
+        mutable std::set<Output> mOutputs;
+        mutable std::set<Uniform> mUniforms;
     };
 
     class Shader
@@ -200,17 +209,41 @@ namespace sb
             SamplerShadowmap = 2
         };
 
-        void bind(const VertexBuffer& vb) const;
+        // binds shader inputs to attribute locations of given vertex layout
+        void bind(const std::vector<Attrib::Kind>& attribs) const;
+        void bind(const VertexBuffer& vb) const
+        {
+            bind(vb.getAttribs());
+        }
+        // for compute programs, which have no inputs
+        void bind() const
+        {
+            bind(std::vector<Attrib::Kind>());
+        }
         void unbind() const;
 
+        // inputs and uniforms of the placeholder until ready
         const std::map<Attrib::Kind, Input>& getInputs() const {
-            return mInputs;
+            return mPending ? mPending->placeholder->getInputs() : mInputs;
+        }
+        const std::set<Uniform>& getUniforms() const {
+            return mPending ? mPending->placeholder->getUniforms() : mUniforms;
         }
 
         bool hasUniform(const std::string& name) const {
-            return mUniforms.count(name) > 0;
+            return mPending ? mPending->placeholder->hasUniform(name)
+                            : mUniforms.count(name) > 0;
         }
 
+        // false while an asynchronously created program is compiling; it
+        // draws with a placeholder and ignores its own uniforms until then
+        bool isReady() const { return !mPending; }
+        // advances asynchronous compilation without blocking; returns
+        // isReady()
+        bool poll();
+        // blocks until the program is ready
+        void wait();
+
         Shader(Shader&& prev) { *this = std::move(prev); }
         Shader& operator =(Shader&& prev)
         {
@@ -218,7 +251,9 @@ namespace sb
             prev.mProgram = 0;
             mFilenames.swap(prev.mFilenames);
             mInputs.swap(prev.mInputs);
+            std::swap(mInputMask, prev.mInputMask);
             mUniforms.swap(prev.mUniforms);
+            mPending.swap(prev.mPending);
             return *this;
         }
 
@@ -227,25 +262,77 @@ namespace sb
             if (mProgram) {
                 GL_CHECK(glDeleteProgram(mProgram));
             }
+            if (mPending && mPending->program) {
+                GL_CHECK(glDeleteProgram(mPending->program));
+            }
         }
 
         std::string getName() const {
             return utils::join(mFilenames, ", ");
         }
 
+        // linked program binary, for ProgramCache; false if the driver
+        // does not provide one
+        bool getBinary(GLenum& outFormat,
+                       std::vector<uint8_t>& outBinary) const;
+
     private:
+        struct PendingLink
+        {
+            std::shared_ptr<ConcreteShader> vertex;
+            std::shared_ptr<ConcreteShader> fragment;
+            std::shared_ptr<ConcreteShader> geometry;
+            std::shared_ptr<Shader> placeholder;
+            // 0 until all stages are compiled
+            ProgramId program;
+        };
+
         ProgramId mProgram;
         std::vector<std::string> mFilenames;
         std::map<Attrib::Kind, Input> mInputs;
+        // Attrib::getMask of all inputs
+        uint32_t mInputMask;
         std::set<Uniform> mUniforms;
+        std::unique_ptr<PendingLink> mPending;
 
         Shader(const std::shared_ptr<ConcreteShader>& vertex,
                const std::shared_ptr<ConcreteShader>& fragment,
                const std::shared_ptr<ConcreteShader>& geometry);
+        // submits all stages for compilation and returns immediately;
+        // placeholder is used until poll() finds the program linked
+        Shader(const std::shared_ptr<ConcreteShader>& vertex,
+               const std::shared_ptr<ConcreteShader>& fragment,
+               const std::shared_ptr<ConcreteShader>& geometry,
+               const std::shared_ptr<Shader>& placeholder);
+        // compute-only program
+        explicit Shader(const std::shared_ptr<ConcreteShader>& compute);
+        // program loaded with loadBinary, with metadata from ProgramCache
+        Shader(ProgramId program,
+               const std::vector<std::string>& filenames,
+               const std::map<Attrib::Kind, Input>& inputs,
+               const std::set<Uniform>& uniforms);
+
+        // returns 0 if the driver rejects the binary
+        static ProgramId loadBinary(GLenum format,
+                                    const std::vector<uint8_t>& binary);
 
         ProgramId linkShader(const std::shared_ptr<ConcreteShader>& vertex,
                              const std::shared_ptr<ConcreteShader>& fragment,
                              const std::shared_ptr<ConcreteShader>& geometry);
+        // glLinkProgram without waiting for the result; vertex inputs are
+        // bound to Attrib::getLocation of their kinds first
+        static ProgramId startLink(const std::shared_ptr<ConcreteShader>& vertex,
+                                   const std::shared_ptr<ConcreteShader>& fragment,
+                                   const std::shared_ptr<ConcreteShader>& geometry);
+        // takes ownership of a successfully linked program
+        void finishLink(const std::shared_ptr<ConcreteShader>& vertex,
+                        const std::shared_ptr<ConcreteShader>& fragment,
+                        const std::shared_ptr<ConcreteShader>& geometry,
+                        ProgramId program);
+        bool advance(bool block);
+        ProgramId getActiveProgram() const {
+            return mPending ? mPending->placeholder->mProgram : mProgram;
+        }
 
         static bool shaderLinkSucceeded(ProgramId program);
 
@@ -0,0 +1,66 @@
+#ifndef RENDERING_SHADERFEATURES_H
+#define RENDERING_SHADERFEATURES_H
+
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <string>
+
+namespace sb {
+
+// Set of preprocessor defines selecting one permutation of a shader, e.g.
+// ShaderFeatures{ { "SHADOWS", 1 }, { "POINT_LIGHTS", 4 }, "TEXTURED" }.
+// Defines are injected right after the #version line, so that constant
+// light counts let the compiler unroll loops and strip unused paths.
+class ShaderFeatures
+{
+public:
+    struct Define
+    {
+        std::string name;
+        // empty for plain "#define NAME"
+        std::string value;
+
+        Define(const char* name): name(name), value() {}
+        Define(const std::string& name): name(name), value() {}
+        Define(const std::string& name,
+               int value);
+    };
+
+    ShaderFeatures() {}
+    ShaderFeatures(std::initializer_list<Define> defines);
+
+    ShaderFeatures& set(const std::string& name);
+    ShaderFeatures& set(const std::string& name,
+                        int value);
+
+    bool empty() const { return mDefines.empty(); }
+    bool isDefined(const std::string& name) const {
+        return mDefines.count(name) > 0;
+    }
+
+    // defines of both sets; ones from other override those already set
+    ShaderFeatures merged(const ShaderFeatures& other) const;
+    // only the defines for which pred(name) returns true
+    ShaderFeatures filtered(
+            const std::function<bool(const std::string&)>& pred) const;
+
+    // source with "#define" lines inserted after #version
+    std::string apply(const std::string& code) const;
+    // "NAME=VALUE,NAME", used in logs and shader names
+    std::string toString() const;
+
+    bool operator <(const ShaderFeatures& f) const {
+        return mDefines < f.mDefines;
+    }
+    bool operator ==(const ShaderFeatures& f) const {
+        return mDefines == f.mDefines;
+    }
+
+private:
+    std::map<std::string, std::string> mDefines;
+};
+
+} // namespace sb
+
+#endif // RENDERING_SHADERFEATURES_H
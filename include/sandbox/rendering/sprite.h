@@ -14,6 +14,10 @@ namespace sb
                const std::shared_ptr<Shader>& shader);
 
         void setImage(const std::string& image);
+        const std::string& getImage() const { return mImage; }
+
+    private:
+        std::string mImage;
     };
 } // namespace sb
 
@@ -0,0 +1,43 @@
+#ifndef RENDERING_SPRITEBATCH_H
+#define RENDERING_SPRITEBATCH_H
+
+#include <string>
+
+#include <sandbox/rendering/quadBatch.h>
+#include <sandbox/utils/types.h>
+
+namespace sb {
+
+class Sprite;
+
+// Draws sprites packed into ResourceMgr atlas pages, one draw call per
+// page. Transforms are applied on the CPU, so sprites of any size, angle
+// and color can share a draw.
+class SpriteBatch
+{
+public:
+    SpriteBatch();
+
+    SpriteBatch(const SpriteBatch&) = delete;
+    SpriteBatch& operator =(const SpriteBatch&) = delete;
+
+    // transform maps the unit quad (-1, -1)..(1, 1), as with Sprite
+    void add(const std::string& image,
+             const Mat44& transform,
+             const Color& color = Color::White);
+    void add(const std::string& image,
+             const Vec2& center,
+             const Vec2& halfSize,
+             Radians rotation = Radians(0.0f),
+             const Color& color = Color::White);
+    void add(const Sprite& sprite);
+
+    void flush(Camera& camera) { mQuads.flush(camera); }
+
+private:
+    QuadBatch mQuads;
+};
+
+} // namespace sb
+
+#endif // RENDERING_SPRITEBATCH_H
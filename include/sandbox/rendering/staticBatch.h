@@ -0,0 +1,165 @@
+#ifndef RENDERING_STATICBATCH_H
+#define RENDERING_STATICBATCH_H
+
+#include <memory>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/buffer.h>
+#include <sandbox/rendering/renderer.h>
+#include <sandbox/rendering/geometryArena.h>
+
+namespace sb {
+
+class Drawable;
+class Mesh;
+class Texture;
+class TextureArray;
+
+// Drawables that rarely change, submitted with one glMultiDrawElementsIndirect
+// per (geometry arena, primitive type, texture). Draw commands and per-draw
+// data (model matrix, color, texture layer, bounding sphere) live in GPU
+// buffers rebuilt only when the set changes; each command carries the index
+// of its per-draw data in baseInstance.
+//
+// If compute shaders are available, a compute pass culls draws against the
+// camera frustum before each draw and compacts visible commands of every
+// multi-draw at its start, so the CPU never touches individual objects.
+// With ARB_indirect_parameters the draw count is read from the GPU as well;
+// without it culled slots are left as empty draws.
+//
+// Batched drawables are rendered with a built-in shader instead of their own:
+// texture * color * ambient light, plus diffuse point and parallel lights and
+// shadows for drawables whose shader uses lights. Since that changes how they
+// look, batching is opt-in per drawable (see add()). Drawables that did not
+// opt in, ones the built-in shader cannot stand in for - custom uniforms or
+// samplers other than "tex", meshes outside of an arena, without texcoords
+// or, for lit ones, normals - and all drawables on contexts without GL
+// 4.3-level indirect drawing are drawn one by one with their own shader.
+// Drawables whose shader is still compiling are drawn one by one until it is
+// ready, and meshes that were updated or replaced by an asynchronous load are
+// picked up on the next draw.
+class StaticBatch
+{
+public:
+    typedef size_t Handle;
+
+    StaticBatch();
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator =(const StaticBatch&) = delete;
+
+    // true if the current context can do indirect multi-draws
+    static bool isSupported();
+    // true if the current context can cull draws with a compute shader
+    static bool isCullingSupported();
+
+    // useBatchShader: allow drawing the drawable with the built-in shader
+    // described above; otherwise it is only drawn one by one with its own
+    Handle add(const std::shared_ptr<Drawable>& drawable,
+               bool useBatchShader = false);
+    void remove(Handle handle);
+    void clear();
+    // must be called after recoloring or retexturing any of added drawables
+    void invalidate() { mDirty = true; }
+    // cheaper than invalidate() after moving a single drawable, e.g. one
+    // that follows the camera
+    void updateTransform(Handle handle);
+
+    size_t size() const { return mEntries.size(); }
+
+    // enabled by default where supported
+    void setCullingEnabled(bool enabled) { mCullingEnabled = enabled; }
+    bool isCullingEnabled() const { return mCullShader && mCullingEnabled; }
+
+    void draw(Renderer::State& state);
+
+private:
+    enum class Shading {
+        Unlit,
+        Lit,
+        // drawn one by one with its own shader
+        Unsupported,
+        // unsupported until its shader finishes compiling
+        Pending
+    };
+
+    struct Entry
+    {
+        Handle handle;
+        std::shared_ptr<Drawable> drawable;
+        bool useBatchShader;
+        // set by rebuild(); NO_DRAW if not batched
+        size_t drawIndex;
+        Shading shading;
+        // mesh the draw command and bounding sphere were built from
+        const Mesh* mesh;
+        uint32_t meshRevision;
+    };
+
+    static const size_t NO_DRAW = (size_t)-1;
+
+    // matches DrawElementsIndirectCommand
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // std430 layout of DrawData in the static batch and culling shaders
+    struct DrawData
+    {
+        Mat44 matModel;
+        Color color;
+        // xyz - center in model space, w - radius
+        Vec4 boundingSphere;
+        float layer;
+        GLuint group;
+        GLuint groupFirstCommand;
+        GLuint padding;
+    };
+
+    struct Group
+    {
+        std::shared_ptr<GeometryArena> arena;
+        GLenum shape;
+        GLenum indexType;
+        bool lit;
+        std::shared_ptr<const Texture> texture;
+        std::shared_ptr<TextureArray> textureArray;
+        size_t firstCommand;
+        size_t numCommands;
+    };
+
+    std::shared_ptr<Shader> mShader;
+    std::shared_ptr<Shader> mLitShader;
+    std::shared_ptr<Shader> mCullShader;
+    bool mCullingEnabled;
+    std::vector<Entry> mEntries;
+    Handle mNextHandle;
+    bool mDirty;
+
+    std::vector<Group> mGroups;
+    std::vector<std::shared_ptr<Drawable>> mUnbatched;
+    size_t mNumCommands;
+    std::unique_ptr<Buffer> mCommandBuffer;
+    std::unique_ptr<Buffer> mDrawDataBuffer;
+    // compacted by the culling pass
+    std::unique_ptr<Buffer> mCulledCommandBuffer;
+    // number of visible draws in each group
+    std::unique_ptr<Buffer> mCounterBuffer;
+
+    Shading getShading(const Drawable& drawable) const;
+    // true if a shader finished compiling or a mesh was changed or replaced
+    // since the last rebuild
+    bool isStale() const;
+    void rebuild();
+    void cull(const Mat44& viewProjection);
+};
+
+} // namespace sb
+
+#endif // RENDERING_STATICBATCH_H
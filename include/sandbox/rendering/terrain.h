@@ -11,6 +11,10 @@ namespace sb
         Terrain(const std::string& heightmap,
                 const std::string& texture,
                 const std::shared_ptr<Shader>& shader);
+        // e.g. with ResourceMgr::getTerrainAsync
+        Terrain(const std::shared_ptr<Mesh>& mesh,
+                const std::shared_ptr<Texture>& texture,
+                const std::shared_ptr<Shader>& shader);
     };
 } // namespace sb
 
@@ -0,0 +1,37 @@
+#ifndef RENDERING_TEXTBATCH_H
+#define RENDERING_TEXTBATCH_H
+
+#include <memory>
+#include <string>
+
+#include <sandbox/rendering/quadBatch.h>
+
+namespace sb {
+
+class Font;
+
+// Collects glyph quads of all strings drawn in a frame, so that flush()
+// issues a single draw call per font atlas.
+class TextBatch
+{
+public:
+    TextBatch();
+
+    TextBatch(const TextBatch&) = delete;
+    TextBatch& operator =(const TextBatch&) = delete;
+
+    // topLeft in pixels, for use with the sprite camera
+    void add(const std::shared_ptr<Font>& font,
+             const std::string& text,
+             const Vec2& topLeft,
+             const Color& color);
+
+    void flush(Camera& camera) { mQuads.flush(camera); }
+
+private:
+    QuadBatch mQuads;
+};
+
+} // namespace sb
+
+#endif // RENDERING_TEXTBATCH_H
@@ -5,6 +5,7 @@
 
 #include <sandbox/rendering/types.h>
 #include <sandbox/resources/image.h>
+#include <sandbox/resources/compressedImage.h>
 
 namespace sb
 {
@@ -19,11 +20,26 @@ namespace sb
     public:
         static const uint32_t MAX_TEXTURE_UNITS = 4;
 
-        // depth texture only!
+        enum class Format {
+            Depth,
+            RGBA
+        };
+
+        // render target texture, no initial data
         Texture(unsigned width,
-                unsigned height);
+                unsigned height,
+                Format format = Format::Depth);
 
         Texture(std::shared_ptr<Image> image);
+        // uploads all precomputed mip levels as they are, nothing is
+        // generated at runtime; the format must be supported
+        explicit Texture(const CompressedImage& image);
+        // immutable storage for numLevels levels of internalFormat, contents
+        // undefined; requires ARB_texture_storage
+        Texture(uint32_t width,
+                uint32_t height,
+                uint32_t numLevels,
+                GLenum internalFormat);
         ~Texture();
 
         Texture(Texture&&) = delete;
@@ -35,11 +51,31 @@ namespace sb
         void unbind() const;
 
         TextureId getId() const { return mId; }
+        // video memory taken by all levels, approximately
+        size_t getSizeBytes() const { return mSizeBytes; }
 
         void setMagFilter(MagFilter filter) const;
+        // levels below baseLevel are not sampled, so they may be undefined
+        void setBaseLevel(uint32_t baseLevel) const;
+
+        // exchanges GL objects, so that a placeholder handed out by
+        // ResourceMgr::getTextureAsync becomes the loaded texture
+        void swap(Texture& other)
+        {
+            std::swap(mId, other.mId);
+            std::swap(mSizeBytes, other.mSizeBytes);
+        }
+
+        // replaces a region of level 0 with tightly packed RGBA8 data
+        void upload(uint32_t x,
+                    uint32_t y,
+                    uint32_t width,
+                    uint32_t height,
+                    const void* rgbaData);
 
     private:
         TextureId mId;
+        size_t mSizeBytes;
     };
 } // namespace sb
 
@@ -0,0 +1,55 @@
+#ifndef RENDERING_TEXTUREARRAY_H
+#define RENDERING_TEXTUREARRAY_H
+
+#include <memory>
+
+#include <sandbox/rendering/types.h>
+
+namespace sb {
+
+// GL_TEXTURE_2D_ARRAY of same-sized RGBA8 layers. Lets draws that differ
+// only by texture share one texture binding and select a layer by uniform.
+class TextureArray
+{
+public:
+    TextureArray(uint32_t width,
+                 uint32_t height,
+                 uint32_t numLayers);
+    ~TextureArray();
+
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator =(const TextureArray&) = delete;
+
+    // uploads tightly packed RGBA8 data into the next free layer and
+    // returns its index; mipmaps are regenerated on the next bind
+    uint32_t addLayer(const void* rgbaData);
+    bool isFull() const { return mUsedLayers == mNumLayers; }
+
+    uint32_t getWidth() const { return mWidth; }
+    uint32_t getHeight() const { return mHeight; }
+
+    void bind(uint32_t textureUnit) const;
+    void unbind() const;
+
+    TextureId getId() const { return mId; }
+
+private:
+    TextureId mId;
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mNumLayers;
+    uint32_t mUsedLayers;
+    // set by addLayer, cleared by bind
+    mutable bool mMipmapsDirty;
+};
+
+// layer of a texture array page, as handed out by ResourceMgr
+struct TextureLayer
+{
+    std::shared_ptr<TextureArray> array;
+    uint32_t layer;
+};
+
+} // namespace sb
+
+#endif // RENDERING_TEXTUREARRAY_H
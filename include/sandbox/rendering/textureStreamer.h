@@ -0,0 +1,122 @@
+#ifndef RENDERING_TEXTURESTREAMER_H
+#define RENDERING_TEXTURESTREAMER_H
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include <sandbox/rendering/buffer.h>
+#include <sandbox/rendering/texture.h>
+#include <sandbox/resources/compressedImage.h>
+
+namespace sb {
+
+// Every mip level of a texture, level 0 first, in CPU memory or a mapped
+// file. Built on loader threads, consumed by TextureStreamer.
+struct TextureMips
+{
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        const void* data;
+        size_t sizeBytes;
+    };
+
+    // GL_RGBA8 for raw images, a compressed format otherwise
+    GLenum internalFormat;
+    bool compressed;
+    std::vector<Level> levels;
+    // owns the memory levels point to
+    std::shared_ptr<const void> storage;
+
+    // levels point into the image mapping, which storage keeps alive
+    static TextureMips fromCompressed(const std::shared_ptr<CompressedImage>& image);
+    // copies tightly packed RGBA8 pixels and builds the rest of the chain
+    // with a 2x2 box filter; odd edges repeat the last row or column
+    static TextureMips fromRGBA(const void* rgba,
+                                uint32_t width,
+                                uint32_t height);
+};
+
+// Makes textures resident progressively. add() allocates storage for the
+// whole mip chain, uploads the smallest levels right away and clamps
+// GL_TEXTURE_BASE_LEVEL to them, so the texture can be sampled, blurry, on
+// the same frame. update() then streams the larger levels through a ring of
+// pixel unpack buffers, a few rows at a time within a per-frame byte budget,
+// lowering the base level whenever a level is complete.
+//
+// Must only be used on the render thread.
+class TextureStreamer
+{
+public:
+    static const size_t STAGING_BUFFER_BYTES = 1024 * 1024;
+    static const size_t NUM_STAGING_BUFFERS = 8;
+    // smallest levels totalling at most this many bytes are uploaded by
+    // add() itself; the 1x1 level always is
+    static const size_t RESIDENT_TAIL_BYTES = 64 * 1024;
+
+    TextureStreamer();
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator =(const TextureStreamer&) = delete;
+
+    // immutable texture storage (ARB_texture_storage) is required, as base
+    // levels are raised past undefined levels
+    static bool isSupported();
+
+    // replaces contents of texture with the mip chain; texture is not kept
+    // alive by the streamer, streaming stops once it is released
+    void add(const std::shared_ptr<Texture>& texture,
+             const TextureMips& mips);
+    // copies up to budgetBytes of queued levels, smallest first; stops
+    // early rather than wait for the GPU to release a staging buffer
+    void update(size_t budgetBytes);
+    // uploads everything queued, waiting for staging buffers if needed
+    void finish();
+    // drops queued uploads and staging buffers
+    void clear();
+
+    bool isBusy() const { return !mStreams.empty(); }
+
+private:
+    struct Stream
+    {
+        std::weak_ptr<Texture> texture;
+        TextureMips mips;
+        // level being uploaded, counting down to 0
+        size_t level;
+        // first row not uploaded yet; rows of 4x4 blocks for compressed
+        // levels
+        uint32_t row;
+    };
+
+    struct StagingBuffer
+    {
+        std::unique_ptr<Buffer> buffer;
+        // signaled once the GPU is done reading the buffer
+        GLsync fence;
+    };
+
+    std::deque<Stream> mStreams;
+    // used in order, so that the oldest one is always reused first
+    std::vector<StagingBuffer> mStagingBuffers;
+    size_t mNextStagingBuffer;
+
+    // null if the next buffer of the ring is still read by the GPU and wait
+    // is not set
+    StagingBuffer* acquireStagingBuffer(bool wait);
+    // uploads the next rows of stream's current level and advances it;
+    // returns bytes copied, 0 if no staging buffer was available
+    size_t uploadRows(Stream& stream,
+                      bool wait);
+    // uploads the whole level from client memory
+    void uploadLevel(const Texture& texture,
+                     const TextureMips& mips,
+                     size_t level);
+};
+
+} // namespace sb
+
+#endif // RENDERING_TEXTURESTREAMER_H
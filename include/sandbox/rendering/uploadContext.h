@@ -0,0 +1,94 @@
+#ifndef RENDERING_UPLOADCONTEXT_H
+#define RENDERING_UPLOADCONTEXT_H
+
+#include <sandbox/rendering/includeGL.h>
+
+#include <X11/Xlib.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace sb {
+
+// GL context sharing objects with the render context, current on a thread of
+// its own. Jobs create textures and buffers there; each is followed by a
+// fence, and its completion callback runs on the render thread only once the
+// GPU is done with it, so uploads never stall frame submission.
+//
+// VAOs, FBOs and program pipelines are not shared between contexts, so jobs
+// must only create objects that are.
+class UploadContext
+{
+public:
+    // shareContext must be created from fbc with given version; Xlib must
+    // have been initialized with XInitThreads
+    UploadContext(::Display* display,
+                  GLXFBConfig fbc,
+                  GLXContext shareContext,
+                  int versionMajor,
+                  int versionMinor);
+    // drops jobs that have not started yet and destroys the context
+    ~UploadContext();
+
+    UploadContext(const UploadContext&) = delete;
+    UploadContext& operator =(const UploadContext&) = delete;
+
+    // false if the shared context could not be created; submit must not be
+    // used then
+    bool isValid() const { return mContext != NULL; }
+
+    // runs job on the upload thread, then onComplete on the render thread
+    // during poll(), once the GPU has executed all commands issued by job
+    void submit(std::function<void()> job,
+                std::function<void()> onComplete);
+    // runs onComplete of jobs whose fences are signaled; never blocks. Must
+    // be called on the render thread
+    void poll();
+    // blocks until all submitted jobs are done and runs their onComplete
+    void finish();
+    // true until onComplete of every submitted job has run
+    bool isBusy() const { return mNumInFlight > 0; }
+
+private:
+    struct Job
+    {
+        std::function<void()> run;
+        std::function<void()> onComplete;
+    };
+
+    struct Completion
+    {
+        GLsync fence;
+        std::function<void()> onComplete;
+    };
+
+    ::Display* mDisplay;
+    GLXContext mContext;
+    GLXPbuffer mPbuffer;
+
+    std::mutex mMutex;
+    std::condition_variable mJobAdded;
+    std::condition_variable mJobDone;
+    std::deque<Job> mJobs;
+    // fenced jobs waiting for poll(), in submission order
+    std::deque<Completion> mCompletions;
+    bool mStopping;
+    // submitted jobs whose onComplete has not run yet; only modified on the
+    // render thread
+    size_t mNumInFlight;
+    // started last, so that everything above is initialized before it runs
+    std::thread mThread;
+
+    void run();
+    // onComplete of completions with signaled fences; if wait is set, blocks
+    // until each fence is signaled instead of stopping at the first one
+    // that is not
+    void runCompletions(bool wait);
+};
+
+} // namespace sb
+
+#endif // RENDERING_UPLOADCONTEXT_H
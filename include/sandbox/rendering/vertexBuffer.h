@@ -24,14 +24,91 @@ namespace sb
             Normal,
         };
 
+        // how a single attribute is stored in the GL buffer
+        enum class Format {
+            Float,
+            HalfFloat,
+            // GL_INT_2_10_10_10_REV, normalized, only for unit vectors
+            PackedNormal,
+            // 4x GL_UNSIGNED_BYTE, normalized, only for colors
+            UNorm8
+        };
+
         std::string kindAsString;
         GLuint componentType;
         size_t numComponents;
         size_t elemSizeBytes;
+
+        // every attribute kind has the same location in all VAOs and all
+        // programs: position 0, texcoord 1, color 2, normal 3
+        static GLuint getLocation(Kind kind) { return (GLuint)kind - 1; }
+        // single bit identifying given kind in a set of attributes
+        static uint32_t getMask(Kind kind) { return 1u << (unsigned)kind; }
+        static uint32_t getMask(const std::vector<Kind>& kinds)
+        {
+            uint32_t mask = 0;
+            for (Kind kind: kinds) {
+                mask |= getMask(kind);
+            }
+            return mask;
+        }
     };
 
     extern const std::map<Attrib::Kind, Attrib> ATTRIBS;
 
+    // unpacked vertex attributes, in the order of attribute locations:
+    // position, texcoord, color, normal (only those present)
+    struct VertexSources {
+        std::vector<Attrib::Kind> attribs;
+        std::vector<const void*> data;
+        std::vector<size_t> numElements;
+        size_t numVertices;
+
+        VertexSources(const std::vector<Vec3>& vertices,
+                      const std::vector<Vec2>& texcoords,
+                      const std::vector<Color>& colors,
+                      const std::vector<Vec3>& normals);
+    };
+
+    struct VertexLayout {
+        enum class Storage {
+            // one buffer per attribute
+            Separate,
+            // all attributes of a vertex next to each other in one buffer
+            Interleaved
+        };
+
+        Storage storage;
+        GLenum usage;
+        // attributes not listed here are stored as floats
+        std::map<Attrib::Kind, Attrib::Format> formats;
+
+        Attrib::Format getFormat(Attrib::Kind kind) const;
+
+        // size of a single interleaved vertex with given attributes
+        size_t getStride(const std::vector<Attrib::Kind>& attribs) const;
+        // packs attributes into interleaved vertices; attributes with fewer
+        // elements than vertices are zero-filled
+        std::vector<uint8_t> interleave(const VertexSources& sources) const;
+        // sets up interleaved attribute pointers for the currently bound VAO
+        // and GL_ARRAY_BUFFER
+        void setAttribPointers(const std::vector<Attrib::Kind>& attribs) const;
+
+        bool operator ==(const VertexLayout& other) const
+        {
+            return storage == other.storage
+                   && usage == other.usage
+                   && formats == other.formats;
+        }
+
+        // float attributes in separate GL_DYNAMIC_DRAW buffers; the only
+        // layout that supports VertexBuffer::update
+        static VertexLayout dynamic();
+        // single interleaved GL_STATIC_DRAW buffer with half-float texcoords,
+        // 2_10_10_10 normals and RGBA8 colors
+        static VertexLayout packed();
+    };
+
     struct BufferKindPair {
         Buffer buffer;
         Attrib::Kind kind;
@@ -49,7 +126,8 @@ namespace sb
         VertexBuffer(const std::vector<Vec3>& vertices,
                      const std::vector<Vec2>& texcoords,
                      const std::vector<Color>& colors,
-                     const std::vector<Vec3>& normals);
+                     const std::vector<Vec3>& normals,
+                     const VertexLayout& layout = VertexLayout::dynamic());
         VertexBuffer(const VertexBuffer& copy) = delete;
         ~VertexBuffer();
 
@@ -58,18 +136,45 @@ namespace sb
             return mBuffers;
         }
 
+        // attribute kinds in the order of attribute locations
+        const std::vector<Attrib::Kind>& getAttribs() const
+        {
+            return mAttribs;
+        }
+
+        const VertexLayout& getLayout() const { return mLayout; }
+
         void bind() const;
         void unbind() const;
 
+        // replaces contents of the attribute buffer of given kind; data must
+        // be in the same (unpacked) format as passed to the constructor
+        void update(Attrib::Kind kind,
+                    const void* data,
+                    size_t numElements);
+        // replaces contents of all attribute buffers, growing them if needed;
+        // sources must have the same attributes as passed to the constructor
+        void update(const VertexSources& sources);
+        // overwrites vertices [firstVertex, firstVertex + numVertices) in
+        // place; sources must have the same attributes as passed to the
+        // constructor
+        void write(size_t firstVertex,
+                   const VertexSources& sources,
+                   Buffer::WriteMode mode = Buffer::WriteMode::SubData);
+
         void debug();
 
     private:
         BufferId mVAO;
+        VertexLayout mLayout;
+        std::vector<Attrib::Kind> mAttribs;
+        // for interleaved layout: a single buffer of Unspecified kind
         std::vector<BufferKindPair> mBuffers;
 
-    void addBuffer(const Attrib::Kind& kind,
-                   const void* data,
-                   size_t numElements);
+        void addBuffer(const Attrib::Kind& kind,
+                       const void* data,
+                       size_t numElements);
+        void addInterleavedBuffer(const VertexSources& sources);
     };
 } // namespace sb
 
@@ -0,0 +1,37 @@
+#ifndef RESOURCES_BUILTINSHADERS_H
+#define RESOURCES_BUILTINSHADERS_H
+
+namespace sb {
+namespace builtin {
+
+// GLSL sources of shaders used by the engine itself, registered in
+// ResourceMgr as special resources ("*<name>")
+
+// per-vertex colored geometry, used by DebugDraw
+extern const char* const DEBUG_VERT;
+extern const char* const DEBUG_FRAG;
+
+// textured, per-vertex tinted screen-space quads, used by TextBatch
+extern const char* const BATCH2D_VERT;
+extern const char* const BATCH2D_FRAG;
+
+// flat-colored geometry, drawn while the real shader of a drawable is still
+// compiling asynchronously
+extern const char* const PLACEHOLDER_VERT;
+extern const char* const PLACEHOLDER_FRAG;
+
+// indirect multi-draws with per-draw data fetched by gl_BaseInstanceARB,
+// used by StaticBatch; GLSL 4.30, so compiled only when first requested.
+// With LIT defined, adds diffuse point and parallel lights and shadow map
+// lookups, using the same uniforms Drawable sets for its own shaders.
+extern const char* const STATIC_VERT;
+extern const char* const STATIC_FRAG;
+
+// frustum culling of StaticBatch draws, compacting visible draw commands of
+// each multi-draw; GLSL 4.30, compiled only when first requested
+extern const char* const CULL_COMP;
+
+} // namespace builtin
+} // namespace sb
+
+#endif // RESOURCES_BUILTINSHADERS_H
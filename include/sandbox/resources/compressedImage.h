@@ -0,0 +1,81 @@
+#ifndef RESOURCES_COMPRESSEDIMAGE_H
+#define RESOURCES_COMPRESSEDIMAGE_H
+
+#include <string>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/utils/mappedFile.h>
+
+namespace sb {
+
+// Image already in a GPU block-compressed format (BC1-5, BC7 or ETC2), with
+// its mip chain precomputed, read from a KTX 1.1 or DDS container. The file
+// is mmap'ed and levels point straight into the mapping, ready to be passed
+// to glCompressedTexImage2D.
+//
+// Rows are uploaded in file order; files written by tools/texconv keep the
+// row order DevIL decodes the source image with, so they map the same way.
+class CompressedImage
+{
+public:
+    struct Level
+    {
+        uint32_t width;
+        uint32_t height;
+        const void* data;
+        size_t sizeBytes;
+    };
+
+    CompressedImage();
+
+    // false if the file cannot be read, or if its format is not supported;
+    // missing files fail silently
+    bool loadFromFile(const std::string& path);
+    // same as loadFromFile, with the file already in memory; levels point
+    // into data, so it must outlive the image. name is only used in logs
+    bool loadFromMemory(const void* data,
+                        size_t sizeBytes,
+                        const std::string& name);
+
+    // GL internal format, e.g. GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    GLenum getFormat() const { return mFormat; }
+    const std::vector<Level>& getLevels() const { return mLevels; }
+    uint32_t getWidth() const { return mLevels.empty() ? 0 : mLevels[0].width; }
+    uint32_t getHeight() const { return mLevels.empty() ? 0 : mLevels[0].height; }
+
+    // true if the GL implementation can sample textures of given format.
+    // Only reads flags set by glewInit, so any thread may call it.
+    static bool isFormatSupported(GLenum format);
+    // true for .ktx and .dds files
+    static bool isCompressedFile(const std::string& path);
+    // bytes of a width x height level of format; 0 if format is not one of
+    // the block-compressed formats listed above
+    static size_t getLevelSizeBytes(GLenum format,
+                                    uint32_t width,
+                                    uint32_t height);
+
+private:
+    // only open if loaded from a file
+    MappedFile mFile;
+    const uint8_t* mData;
+    size_t mSize;
+    GLenum mFormat;
+    std::vector<Level> mLevels;
+
+    bool parse(const uint8_t* data,
+               size_t sizeBytes,
+               const std::string& name);
+    bool parseKTX();
+    bool parseDDS();
+    // appends numLevels levels stored one after another from offset on;
+    // false if they do not fit in the file
+    bool addLevels(uint32_t width,
+                   uint32_t height,
+                   uint32_t numLevels,
+                   size_t offset);
+};
+
+} // namespace sb
+
+#endif // RESOURCES_COMPRESSEDIMAGE_H
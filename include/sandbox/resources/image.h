@@ -1,6 +1,7 @@
 #ifndef IMAGE_H
 #define IMAGE_H
 
+#include <mutex>
 #include <string>
 
 #include <IL/il.h>
@@ -23,15 +24,27 @@ namespace sb
         Image& operator =(Image&& source);
 
         bool loadFromFile(const std::string& file);
+        // encoded file contents, e.g. from a resource pack; name is only
+        // used in logs
+        bool loadFromMemory(const void* data,
+                            size_t sizeBytes,
+                            const std::string& name);
 
         uint32_t getWidth();
         uint32_t getHeight();
+        // decoded pixel data
+        size_t getSizeBytes();
 
         void scale(uint32_t newWidth,
                    uint32_t newHeight);
 
         void* getRGBAData();
 
+        // DevIL operates on a global "bound image"; Image methods lock this
+        // themselves, direct il* calls have to hold it as long as they rely
+        // on the bound image, as images may be decoded on loader threads
+        static std::unique_lock<std::recursive_mutex> lockDevIL();
+
     private:
         ILuint mId;
     };
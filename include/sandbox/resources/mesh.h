@@ -8,6 +8,7 @@
 #include <sandbox/rendering/color.h>
 #include <sandbox/rendering/texture.h>
 #include <sandbox/rendering/vertexBuffer.h>
+#include <sandbox/rendering/geometryArena.h>
 #include <sandbox/utils/types.h>
 
 namespace sb
@@ -23,17 +24,91 @@ namespace sb
             TriangleStrip = SHAPE_TRIANGLE_STRIP
         };
 
+        // meshes with interleaved layout are sub-allocated from a geometry
+        // arena shared with other meshes of the same layout; others get
+        // their own buffers
         Mesh(Shape shape,
              const std::vector<Vec3>& vertices,
              const std::vector<Vec2>& texcoords,
              const std::vector<Color>& colors,
              const std::vector<Vec3>& normals,
              const std::vector<uint32_t>& indices,
+             std::shared_ptr<Texture> texture,
+             const VertexLayout& layout = VertexLayout::packed());
+        // arena mesh from vertices already interleaved according to
+        // VertexLayout::packed() and indices packed as indexType, e.g.
+        // pointing into a MeshCache mapping
+        Mesh(Shape shape,
+             const std::vector<Attrib::Kind>& attribs,
+             const void* vertexData,
+             size_t numVertices,
+             const void* indexData,
+             size_t numIndices,
+             GLenum indexType,
+             const Vec3& boundingSphereCenter,
+             float boundingSphereRadius,
              std::shared_ptr<Texture> texture);
+        ~Mesh();
+
+        Mesh(const Mesh&) = delete;
+        Mesh& operator =(const Mesh&) = delete;
+
+        // binds vertex array and index buffer
+        void bind() const;
+        void unbind() const;
+        // bind() must be called before
+        void draw() const;
+
+        // overwrite vertices [firstVertex, firstVertex + vertices.size()) in
+        // place; other attributes must be given for the same vertices, and
+        // only for the ones the mesh was created with
+        void updateVertices(size_t firstVertex,
+                            const std::vector<Vec3>& vertices,
+                            const std::vector<Vec2>& texcoords,
+                            const std::vector<Color>& colors,
+                            const std::vector<Vec3>& normals,
+                            Buffer::WriteMode mode = Buffer::WriteMode::SubData);
+        // overwrite indices [firstIndex, firstIndex + indices.size()) in place
+        void updateIndices(size_t firstIndex,
+                           const std::vector<uint32_t>& indices,
+                           Buffer::WriteMode mode = Buffer::WriteMode::SubData);
+        // replaces whole mesh contents, keeping the attribute set; storage
+        // is reused if it is big enough, so the VAO stays the same
+        void update(const std::vector<Vec3>& vertices,
+                    const std::vector<Vec2>& texcoords,
+                    const std::vector<Color>& colors,
+                    const std::vector<Vec3>& normals,
+                    const std::vector<uint32_t>& indices);
+
+        // exchanges all contents, so that a placeholder handed out by
+        // ResourceMgr::getMeshAsync becomes the loaded mesh
+        void swap(Mesh& other);
+
+        const std::vector<Attrib::Kind>& getAttribs() const;
+        // meshes with the same key can be drawn without switching VAOs
+        const void* getVertexArrayKey() const;
+
+        const std::shared_ptr<GeometryArena>& getArena() const { return mArena; }
+        const GeometryArena::Allocation& getAllocation() const { return mAllocation; }
+
+        // bounding sphere of vertex positions, in model space
+        const Vec3& getBoundingSphereCenter() const { return mBoundingSphereCenter; }
+        float getBoundingSphereRadius() const { return mBoundingSphereRadius; }
+        // the sphere a mesh with given vertex positions would have
+        static void getBoundingSphere(const std::vector<Vec3>& vertices,
+                                      Vec3& outCenter,
+                                      float& outRadius);
+
+        // vertex and index data in GPU buffers, approximately
+        size_t getSizeBytes() const;
+
+        // changes on every update of geometry or bounding sphere, and on
+        // swap; lets holders of derived data, e.g. StaticBatch, notice edits
+        uint32_t getRevision() const { return mRevision; }
 
-        VertexBuffer& getVertexBuffer() { return mVertexBuffer; }
-        IndexBuffer& getIndexBuffer() { return mIndexBuffer; }
         size_t getIndexBufferSize() { return mIndexBufferSize; }
+        // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+        GLenum getIndexType() { return mIndexType; }
 
         Shape getShape() { return mShape; }
         const std::shared_ptr<Texture>& getTexture() { return mTexture; }
@@ -44,12 +119,26 @@ namespace sb
         }
 
     private:
-        VertexBuffer mVertexBuffer;
-        IndexBuffer mIndexBuffer;
+        // only for meshes not stored in an arena
+        std::unique_ptr<VertexBuffer> mVertexBuffer;
+        std::unique_ptr<IndexBuffer> mIndexBuffer;
+
+        std::shared_ptr<GeometryArena> mArena;
+        GeometryArena::Allocation mAllocation;
+
+        Vec3 mBoundingSphereCenter;
+        float mBoundingSphereRadius;
+
         uint32_t mIndexBufferSize;
+        GLenum mIndexType;
 
         Shape mShape;
         std::shared_ptr<Texture> mTexture;
+        uint32_t mRevision;
+
+        void computeBoundingSphere(const std::vector<Vec3>& vertices);
+        // enlarges the bounding sphere to contain given vertices
+        void growBoundingSphere(const std::vector<Vec3>& vertices);
 
         friend class ResourceMgr;
     };
@@ -0,0 +1,79 @@
+#ifndef RESOURCES_MESHCACHE_H
+#define RESOURCES_MESHCACHE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sandbox/rendering/types.h>
+#include <sandbox/rendering/vertexBuffer.h>
+#include <sandbox/resources/mesh.h>
+#include <sandbox/utils/mappedFile.h>
+
+namespace sb {
+
+// On-disk cache of imported meshes, so that model files go through assimp
+// and the mesh optimizer only once. Entries hold vertices interleaved
+// exactly as VertexLayout::packed() stores them in a GeometryArena and
+// already packed indices, so loading one is an mmap followed by a buffer
+// upload straight from the mapped pages, with no parsing in between.
+//
+// An entry is used as long as the source file has the same modification
+// time and size, or the same contents hash if only the time changed.
+// Sources that are not loose files, e.g. packed ones, are passed in memory
+// and only matched by size and contents hash.
+class MeshCache
+{
+public:
+    struct Entry
+    {
+        Mesh::Shape shape;
+        std::vector<Attrib::Kind> attribs;
+
+        // numVertices * VertexLayout::packed().getStride(attribs) bytes
+        const void* vertexData;
+        size_t numVertices;
+        // numIndices indices of indexType
+        const void* indexData;
+        size_t numIndices;
+        GLenum indexType;
+
+        Vec3 boundingSphereCenter;
+        float boundingSphereRadius;
+        // diffuse textures referenced by the model, in material order
+        std::vector<std::string> textureNames;
+
+        // keeps data pointers valid for entries returned by load()
+        std::shared_ptr<MappedFile> file;
+    };
+
+    // creates the directory if needed; an empty path disables the cache
+    explicit MeshCache(const std::string& directory);
+
+    // $XDG_CACHE_HOME/sandbox/meshes, or ~/.cache/sandbox/meshes
+    static std::string getDefaultDirectory();
+
+    bool isEnabled() const { return !mDirectory.empty(); }
+
+    // false if there is no entry for given source file, or it is stale.
+    // sourceData holds the source contents if it is not read from
+    // sourcePath. Safe to call from any thread.
+    bool load(const std::string& sourcePath,
+              Entry& outEntry,
+              const void* sourceData = nullptr,
+              size_t sourceSizeBytes = 0) const;
+    // safe to call from any thread
+    void store(const std::string& sourcePath,
+               const Entry& entry,
+               const void* sourceData = nullptr,
+               size_t sourceSizeBytes = 0) const;
+
+private:
+    std::string mDirectory;
+
+    std::string getPath(const std::string& sourcePath) const;
+};
+
+} // namespace sb
+
+#endif // RESOURCES_MESHCACHE_H
@@ -0,0 +1,68 @@
+#ifndef RESOURCES_MESHOPTIMIZER_H
+#define RESOURCES_MESHOPTIMIZER_H
+
+#include <vector>
+
+#include <sandbox/utils/types.h>
+
+namespace sb {
+namespace meshopt {
+
+// size of the FIFO cache used for ACMR measurements and cluster splitting
+const size_t DEFAULT_CACHE_SIZE = 16;
+
+// average cache miss ratio: vertex shader invocations per triangle with
+// a FIFO post-transform cache of given size; 0.5 is optimal, 3 is worst
+float computeACMR(const std::vector<uint32_t>& indices,
+                  size_t numVertices,
+                  size_t cacheSize = DEFAULT_CACHE_SIZE);
+
+// reorders triangles for post-transform cache locality using Tom Forsyth's
+// "Linear-Speed Vertex Cache Optimisation"
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices,
+                                          size_t numVertices);
+
+// splits cache-optimized triangle list into clusters and draws the ones
+// facing away from the mesh center first, so that they occlude the rest;
+// threshold is the allowed ACMR degradation, e.g. 1.05 = 5% worse
+std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices,
+                                       const std::vector<Vec3>& positions,
+                                       float threshold = 1.05f);
+
+// renumbers vertices in order of first use, modifying indices in place;
+// returns remap table, where remap[oldIndex] == newIndex, or ~0u if vertex
+// is not referenced at all
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices,
+                                          size_t numVertices);
+
+// reorders vertex attributes according to remap table returned by
+// optimizeVertexFetch, dropping unreferenced vertices
+template<typename T>
+void remapVertices(std::vector<T>& data,
+                   const std::vector<uint32_t>& remap)
+{
+    if (data.empty()) {
+        return;
+    }
+
+    size_t numUsed = 0;
+    for (uint32_t newIndex: remap) {
+        if (newIndex != ~0u) {
+            ++numUsed;
+        }
+    }
+
+    std::vector<T> result(numUsed);
+    for (size_t i = 0; i < remap.size() && i < data.size(); ++i) {
+        if (remap[i] != ~0u) {
+            result[remap[i]] = data[i];
+        }
+    }
+
+    data.swap(result);
+}
+
+} // namespace meshopt
+} // namespace sb
+
+#endif // RESOURCES_MESHOPTIMIZER_H
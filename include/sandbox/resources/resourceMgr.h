@@ -3,38 +3,73 @@
 
 #include <sandbox/rendering/types.h>
 #include <sandbox/rendering/shader.h>
+#include <sandbox/rendering/programCache.h>
+#include <sandbox/rendering/shaderFeatures.h>
 #include <sandbox/rendering/texture.h>
+#include <sandbox/rendering/textureArray.h>
+#include <sandbox/rendering/textureStreamer.h>
+#include <sandbox/resources/meshCache.h>
+#include <sandbox/resources/resourcePack.h>
+#include <sandbox/resources/textMeshCache.h>
+#include <sandbox/resources/textureAtlas.h>
 #include <sandbox/utils/logger.h>
 #include <sandbox/utils/singleton.h>
 #include <sandbox/utils/stringUtils.h>
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/debug.h>
+#include <sandbox/utils/threadPool.h>
 
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <list>
 #include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 #include <memory>
+#include <tuple>
 
 namespace sb
 {
     class Image;
     class Mesh;
     class Font;
+    class UploadContext;
 
     template<typename T>
     void noop(const std::shared_ptr<T>&) {}
 
+    // approximate memory held by a resource
+    struct ResourceSize
+    {
+        size_t cpuBytes;
+        size_t gpuBytes;
+    };
+
+    template<typename T>
+    ResourceSize noSize(const std::shared_ptr<T>&) { return { 0, 0 }; }
+
+    // Resources by name, loaded on first use. Kept in least-recently-used
+    // order; whenever one is added and the total size of all of them
+    // exceeds the budget, unreferenced ones are evicted, least recently used
+    // first. Special resources are never evicted.
     template<
         typename T,
         std::shared_ptr<T>(*LoadFunc)(const std::string&),
-        void(*ReleaseFunc)(const std::shared_ptr<T>&) = noop<T>
+        void(*ReleaseFunc)(const std::shared_ptr<T>&) = noop<T>,
+        ResourceSize(*SizeFunc)(const std::shared_ptr<T>&) = noSize<T>
     >
     class SpecificResourceMgr
     {
     public:
         SpecificResourceMgr(const std::string& basePath):
             mBasePath(basePath),
-            mResources()
+            mResources(),
+            mRecentlyUsed(),
+            mBudgetBytes(0),
+            mNumEvicted(0)
         {
             if (mBasePath != ""
                     && mBasePath[mBasePath.size() - 1] != '/') {
@@ -51,17 +86,44 @@ namespace sb
         {
             auto it = mResources.find(name);
             if (it != mResources.end()) {
-                return it->second;
+                touch(it->second);
+                return it->second.resource;
             }
 
             std::shared_ptr<T> resource = LoadFunc(mBasePath + name);
             if (resource) {
-                mResources.insert(std::make_pair(name, resource));
+                add(name, resource);
             }
 
             return resource;
         }
 
+        // like get, but never loads; null if not loaded yet
+        std::shared_ptr<T> find(const std::string& name)
+        {
+            auto it = mResources.find(name);
+            if (it == mResources.end()) {
+                return {};
+            }
+
+            touch(it->second);
+            return it->second.resource;
+        }
+
+        // registers a resource loaded elsewhere, e.g. asynchronously
+        void add(const std::string& name,
+                 const std::shared_ptr<T>& resource)
+        {
+            mRecentlyUsed.push_front(name);
+            if (!mResources.insert(std::make_pair(
+                    name, Entry{ resource, mRecentlyUsed.begin() })).second) {
+                mRecentlyUsed.pop_front();
+                return;
+            }
+
+            evictOverBudget();
+        }
+
         static bool isSpecial(const std::string& resourceName)
         {
             return resourceName.size() > 0
@@ -76,14 +138,15 @@ namespace sb
         void addSpecial(const std::string& name,
                         const std::shared_ptr<T>& resource)
         {
-            mResources.insert(std::make_pair(makeSpecial(name), resource));
+            mResources.insert(std::make_pair(
+                    makeSpecial(name), Entry{ resource, mRecentlyUsed.end() }));
         }
 
         std::shared_ptr<T> getSpecial(const std::string& name) const
         {
             auto it = mResources.find(makeSpecial(name));
             if (it != mResources.end()) {
-                return it->second;
+                return it->second.resource;
             }
 
             return {};
@@ -92,11 +155,10 @@ namespace sb
         void freeUnused()
         {
             for (auto it = mResources.begin(); it != mResources.end();) {
-                if (it->second.use_count() == 1
+                if (it->second.resource.use_count() == 1
                         && !isSpecial(it->first)) {
                     gLog.trace("ResourceMgr: removing %s\n", (mBasePath + it->first).c_str());
-                    ReleaseFunc(it->second);
-                    it = mResources.erase(it);
+                    it = release(it);
                 } else {
                     ++it;
                 }
@@ -106,34 +168,237 @@ namespace sb
         void freeAll()
         {
             mResources.clear();
+            mRecentlyUsed.clear();
+        }
+
+        // 0 for no limit
+        void setBudget(size_t budgetBytes)
+        {
+            mBudgetBytes = budgetBytes;
+            evictOverBudget();
         }
+        size_t getBudget() const { return mBudgetBytes; }
+
+        // sums sizes of all resources, special ones included
+        ResourceSize getResidentSize() const
+        {
+            ResourceSize total { 0, 0 };
+            for (const auto& pair: mResources) {
+                ResourceSize size = SizeFunc(pair.second.resource);
+                total.cpuBytes += size.cpuBytes;
+                total.gpuBytes += size.gpuBytes;
+            }
+            return total;
+        }
+
+        size_t getNumResources() const { return mResources.size(); }
+        // resources dropped because of the budget so far
+        size_t getNumEvicted() const { return mNumEvicted; }
 
     private:
+        typedef std::list<std::string> RecentlyUsedList;
+
+        struct Entry
+        {
+            std::shared_ptr<T> resource;
+            // end() for special resources
+            typename RecentlyUsedList::iterator recentlyUsedPosition;
+        };
+        typedef std::map<std::string, Entry> ResourceMap;
+
         std::string mBasePath;
-        std::map<std::string, std::shared_ptr<T>> mResources;
+        ResourceMap mResources;
+        // names, most recently used first
+        RecentlyUsedList mRecentlyUsed;
+        size_t mBudgetBytes;
+        size_t mNumEvicted;
+
+        void touch(Entry& entry)
+        {
+            if (entry.recentlyUsedPosition != mRecentlyUsed.end()) {
+                mRecentlyUsed.splice(mRecentlyUsed.begin(), mRecentlyUsed,
+                                     entry.recentlyUsedPosition);
+            }
+        }
+
+        typename ResourceMap::iterator release(typename ResourceMap::iterator it)
+        {
+            ReleaseFunc(it->second.resource);
+            if (it->second.recentlyUsedPosition != mRecentlyUsed.end()) {
+                mRecentlyUsed.erase(it->second.recentlyUsedPosition);
+            }
+            return mResources.erase(it);
+        }
+
+        void evictOverBudget()
+        {
+            if (mBudgetBytes == 0) {
+                return;
+            }
+
+            ResourceSize resident = getResidentSize();
+            size_t totalBytes = resident.cpuBytes + resident.gpuBytes;
+
+            auto name = mRecentlyUsed.end();
+            while (totalBytes > mBudgetBytes && name != mRecentlyUsed.begin()) {
+                --name;
+                auto it = mResources.find(*name);
+                if (it->second.resource.use_count() > 1) {
+                    continue;
+                }
+
+                ResourceSize size = SizeFunc(it->second.resource);
+                totalBytes -= size.cpuBytes + size.gpuBytes;
+                gLog.trace("ResourceMgr: evicting %s, %lu bytes\n",
+                           (mBasePath + it->first).c_str(),
+                           size.cpuBytes + size.gpuBytes);
+                ++mNumEvicted;
+
+                // name is erased along with the resource
+                auto next = std::next(name);
+                release(it);
+                name = next;
+            }
+        }
     };
 
     class ResourceMgr: public Singleton<ResourceMgr>
     {
     public:
+        // reads files from basePath.pack (e.g. data.pack), built by
+        // tools/pack, if there is one; files missing from it, or everything
+        // if there is no pack, are read from basePath
         ResourceMgr(const std::string& basePath = "data/");
 
+        // resources loaded by name, each with its own memory budget
+        enum class Category {
+            Textures,
+            Images,
+            Meshes,
+            Terrains
+        };
+
+        struct CategoryStats
+        {
+            Category category;
+            const char* name;
+            size_t numResources;
+            ResourceSize resident;
+            // 0 if unlimited
+            size_t budgetBytes;
+            size_t numEvicted;
+        };
+
         void freeUnused();
         void freeAll();
 
+        // whenever a resource of the category is added and its CPU and GPU
+        // bytes total more than budgetBytes, unreferenced ones are evicted,
+        // least recently used first; 0 for no limit
+        void setBudget(Category category,
+                       size_t budgetBytes);
+        // one entry per category, in Category order
+        std::vector<CategoryStats> getStats() const;
+
+        // uses name.ktx or name.dds from the same directory instead of the
+        // image itself if there is one in a supported format
         std::shared_ptr<Texture> getTexture(const std::string& name);
         std::shared_ptr<Image> getImage(const std::string& name);
         std::shared_ptr<Mesh> getMesh(const std::string& name);
         std::shared_ptr<Mesh> getTerrain(const std::string& heightmap);
         std::shared_ptr<Font> getFont(const std::string& name);
+
+        // Start decoding on a loader thread and return immediately. Handles
+        // are placeholders (1x1 white texture, unit cube) until
+        // processUploads creates the real GL objects and swaps them in.
+        std::shared_ptr<Texture> getTextureAsync(const std::string& name);
+        std::shared_ptr<Mesh> getMeshAsync(const std::string& name);
+        std::shared_ptr<Mesh> getTerrainAsync(const std::string& heightmap);
+        // like getTextureAsync, but once decoded, only the smallest mips are
+        // uploaded; larger ones follow over the next frames, see
+        // streamTextures. Meant for large textures that should not stall the
+        // frame they arrive on. Same as getTextureAsync without immutable
+        // texture storage.
+        std::shared_ptr<Texture> getTextureStreamed(const std::string& name);
+        // creates GL objects for resources decoded by loader threads; must be
+        // called on the GL context thread. Returns after budgetMicroseconds,
+        // but always finishes at least one upload if any is ready.
+        void processUploads(uint64_t budgetMicroseconds);
+        // uploads up to budgetBytes of mip levels of streamed textures; must
+        // be called on the GL context thread
+        void streamTextures(size_t budgetBytes) { mTextureStreamer.update(budgetBytes); }
+        // textures of async loads are created on given context's thread
+        // instead of in processUploads, which only swaps them in once their
+        // fences are signaled. Set by Renderer; null to upload everything on
+        // the render thread. Jobs already submitted to the previous context
+        // are finished first, so it can be destroyed right after.
+        void setUploadContext(UploadContext* context);
+        // true while an async load is being decoded or waits for upload
+        bool hasPendingLoads() const { return mPendingLoads > 0; }
+        // blocks until all async loads are uploaded, including every mip
+        // level of streamed textures
+        void waitForLoads();
+        std::shared_ptr<Shader> getShader(
+                const std::string& vertexShaderName,
+                const std::string& fragmentShaderName,
+                const std::string& geometryShaderName = "");
+        // permutation of the shader with given #defines injected after
+        // #version; programs are cached separately for each feature set
         std::shared_ptr<Shader> getShader(
                 const std::string& vertexShaderName,
                 const std::string& fragmentShaderName,
+                const ShaderFeatures& features,
                 const std::string& geometryShaderName = "");
+        // returns immediately; the shader draws as getPlaceholderShader()
+        // until pollShaders() finds its program linked
+        std::shared_ptr<Shader> getShaderAsync(
+                const std::string& vertexShaderName,
+                const std::string& fragmentShaderName,
+                const std::string& geometryShaderName = "");
+        std::shared_ptr<Shader> getShaderAsync(
+                const std::string& vertexShaderName,
+                const std::string& fragmentShaderName,
+                const ShaderFeatures& features,
+                const std::string& geometryShaderName = "");
+        // features permutations are built with, e.g. light counts; called
+        // by Renderer once per frame, does nothing unless they changed
+        void setLightFeatures(const ShaderFeatures& features);
+        // shader built from the same sources as given one, with light
+        // features it references added to its defines; the shader itself if
+        // it references none of them. Permutations compile asynchronously,
+        // given shader is returned until its permutation is ready.
+        std::shared_ptr<Shader> getShaderPermutation(
+                const std::shared_ptr<Shader>& shader);
+        // finishes shaders requested with getShaderAsync that are done
+        // compiling, never blocks; called by Renderer once per frame
+        void pollShaders();
+        // blocks until all pending shaders are linked
+        void waitForShaders();
+        // built on first use, then reused until evicted
+        std::shared_ptr<Mesh> getTextMesh(const std::shared_ptr<Font>& font,
+                                          const std::string& text);
+        TextMeshCache& getTextMeshCache() { return mTextMeshes; }
+        // image stored as a layer of a texture array page shared with other
+        // images of the same size
+        TextureLayer getTextureLayer(const std::string& image);
+        // image packed into a shared sprite atlas page
+        const TextureAtlas::Region& getAtlasRegion(const std::string& image);
 
         std::shared_ptr<Mesh> getLine();
         std::shared_ptr<Mesh> getQuad();
 
+        // line shader with per-vertex colors
+        std::shared_ptr<Shader> getDebugShader();
+        // textured screen-space quads with per-vertex colors
+        std::shared_ptr<Shader> getBatch2DShader();
+        // multi-draw shader for StaticBatch; requires GL 4.3. The lit
+        // variant also needs normals.
+        std::shared_ptr<Shader> getStaticBatchShader(bool lit = false);
+        // compute program culling StaticBatch draws; requires GL 4.3
+        std::shared_ptr<Shader> getFrustumCullShader();
+        // flat-colored, used in place of shaders that are still compiling
+        std::shared_ptr<Shader> getPlaceholderShader();
+
         // default texture, indicating some errors
         std::shared_ptr<Texture> getDefaultTexture();
 
@@ -144,11 +409,39 @@ namespace sb
         static std::shared_ptr<Mesh> loadTerrain(const std::string& heightmapPath);
         static std::shared_ptr<Font> loadFont(const std::string& path);
 
+        static ResourceSize getTextureSize(const std::shared_ptr<Texture>& texture);
+        static ResourceSize getImageSize(const std::shared_ptr<Image>& image);
+        static ResourceSize getMeshSize(const std::shared_ptr<Mesh>& mesh);
+
         static std::map<std::string, std::string> getInputs(const std::string& code);
 
+        // registers shaders embedded in the binary as special resources
+        void addBuiltinShaders();
+
+        std::shared_ptr<Shader> getShaderProgram(
+                const std::string& vertexShaderName,
+                const std::string& fragmentShaderName,
+                const std::string& geometryShaderName,
+                const ShaderFeatures& features,
+                bool async);
+
+        // null on cache miss, or if the driver rejects the cached binary
+        std::shared_ptr<Shader> loadCachedProgram(uint64_t key);
+        void storeCachedProgram(uint64_t key,
+                                const Shader& shader);
+
+        // GL part of an async load, run by processUploads
+        typedef std::function<void()> Upload;
+        // runs decode on a loader thread and queues the Upload it returns
+        void queueLoad(const std::function<Upload()>& decode);
+
         template<GLuint ShaderType>
         static std::shared_ptr<ConcreteShader> loadShader(const std::string& path)
         {
+            std::string code;
+            if (ResourceMgr::get().mPack.read(path, code)) {
+                return std::make_shared<ConcreteShader>(ShaderType, path, code);
+            }
             return std::make_shared<ConcreteShader>(ShaderType, path);
         }
 
@@ -156,19 +449,27 @@ namespace sb
 
         SpecificResourceMgr<
             Texture,
-            &ResourceMgr::loadTexture
+            &ResourceMgr::loadTexture,
+            noop<Texture>,
+            &ResourceMgr::getTextureSize
         > mTextures;
         SpecificResourceMgr<
             Image,
-            &ResourceMgr::loadImage
+            &ResourceMgr::loadImage,
+            noop<Image>,
+            &ResourceMgr::getImageSize
         > mImages;
         SpecificResourceMgr<
             Mesh,
-            &ResourceMgr::loadMesh
+            &ResourceMgr::loadMesh,
+            noop<Mesh>,
+            &ResourceMgr::getMeshSize
         > mMeshes;
         SpecificResourceMgr<
             Mesh,
-            &ResourceMgr::loadTerrain
+            &ResourceMgr::loadTerrain,
+            noop<Mesh>,
+            &ResourceMgr::getMeshSize
         > mTerrains;
         SpecificResourceMgr<
             Font,
@@ -188,27 +489,77 @@ namespace sb
             &ResourceMgr::loadShader<GL_GEOMETRY_SHADER>
         > mGeometryShaders;
 
+        // unpermuted stages and the features applied to them
         struct ShaderProgramDef
         {
             std::shared_ptr<ConcreteShader> vertex;
             std::shared_ptr<ConcreteShader> fragment;
             std::shared_ptr<ConcreteShader> geometry;
+            ShaderFeatures features;
 
             bool operator <(const ShaderProgramDef& s) const
             {
-                return std::make_tuple(vertex, fragment, geometry)
-                        < std::make_tuple(s.vertex, s.fragment, s.geometry);
+                return std::tie(vertex, fragment, geometry, features)
+                        < std::tie(s.vertex, s.fragment, s.geometry, s.features);
             }
 
             bool operator ==(const ShaderProgramDef& s) const
             {
                 return vertex == s.vertex
                         && fragment == s.fragment
-                        && geometry == s.geometry;
+                        && geometry == s.geometry
+                        && features == s.features;
             }
         };
 
+        std::shared_ptr<Shader> getShaderProgram(const ShaderProgramDef& def,
+                                                 bool async);
+        // shader source with features applied, compiled once per feature set
+        std::shared_ptr<ConcreteShader> getShaderVariant(
+                const std::shared_ptr<ConcreteShader>& shader,
+                const ShaderFeatures& features);
+
         std::map<ShaderProgramDef, std::shared_ptr<Shader>> mShaderPrograms;
+        std::map<const Shader*, ShaderProgramDef> mShaderDefs;
+        std::map<std::pair<std::shared_ptr<ConcreteShader>, ShaderFeatures>,
+                 std::shared_ptr<ConcreteShader>> mShaderVariants;
+        ShaderFeatures mLightFeatures;
+        // permutations for mLightFeatures, by base shader
+        std::map<const Shader*, std::shared_ptr<Shader>> mShaderPermutations;
+        ProgramCache mProgramCache;
+        // imported meshes; const after construction, so loader threads use
+        // it without locking
+        MeshCache mMeshCache;
+        // opened by the constructor, before anything is loaded, and
+        // read-only afterwards, so loader threads use it without locking
+        ResourcePack mPack;
+
+        struct PendingShader
+        {
+            uint64_t cacheKey;
+            std::shared_ptr<Shader> shader;
+        };
+        std::vector<PendingShader> mPendingShaders;
+        std::shared_ptr<Shader> mFrustumCullShader;
+
+        TextMeshCache mTextMeshes;
+        TextureAtlas mSpriteAtlas;
+
+        std::map<std::string, TextureLayer> mTextureLayers;
+        // pages with free layers, by image size
+        std::map<std::pair<uint32_t, uint32_t>,
+                 std::shared_ptr<TextureArray>> mTextureArrayPages;
+
+        std::mutex mUploadsMutex;
+        std::condition_variable mUploadQueued;
+        std::deque<Upload> mUploads;
+        // only touched on the GL thread
+        size_t mPendingLoads;
+        UploadContext* mUploadContext;
+        TextureStreamer mTextureStreamer;
+        // created on first async load; declared last, so that loader threads
+        // are joined before anything they use is destroyed
+        std::unique_ptr<ThreadPool> mLoaders;
     };
 } // namespace sb
 
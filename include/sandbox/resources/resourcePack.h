@@ -0,0 +1,68 @@
+#ifndef RESOURCES_RESOURCEPACK_H
+#define RESOURCES_RESOURCEPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sandbox/utils/mappedFile.h>
+
+namespace sb {
+
+// Whole data directory in a single file, written by tools/pack. A header is
+// followed by an index of entries sorted by path hash, the paths themselves
+// and the file contents. The pack is mmap'ed once, so a lookup is a binary
+// search over the index and file contents are read straight from the
+// mapping, with no further opens.
+//
+// Paths are looked up as loaders see them, e.g. "data/image/ground.jpg";
+// the mount point given to open() is stripped from them first. Anything
+// outside of it, or missing from the pack, is left to the caller to read
+// from disk.
+class ResourcePack
+{
+public:
+    enum class Compression: uint32_t {
+        // as is; not None, which X11 defines as a macro
+        Stored = 0
+    };
+
+    ResourcePack();
+
+    // false if there is no pack at path, or it is malformed; mountPoint is
+    // the directory the pack was built from, as loaders see it
+    bool open(const std::string& path,
+              const std::string& mountPoint);
+    void close();
+
+    bool isOpen() const { return mFile.isOpen(); }
+    size_t getNumEntries() const { return mNumEntries; }
+
+    // false if path is not in the pack. Data stays valid until the pack is
+    // closed. Safe to call from any thread.
+    bool find(const std::string& path,
+              const uint8_t*& outData,
+              size_t& outSizeBytes) const;
+    // like find, but copies the contents
+    bool read(const std::string& path,
+              std::string& outData) const;
+
+    // packs given files, as paths relative to rootDirectory
+    static bool write(const std::string& path,
+                      const std::string& rootDirectory,
+                      const std::vector<std::string>& names);
+
+private:
+    MappedFile mFile;
+    std::string mMountPoint;
+    // point into mFile
+    const void* mIndex;
+    size_t mNumEntries;
+    const char* mNames;
+    size_t mNamesBytes;
+};
+
+} // namespace sb
+
+#endif // RESOURCES_RESOURCEPACK_H
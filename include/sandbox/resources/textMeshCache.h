@@ -0,0 +1,54 @@
+#ifndef RESOURCES_TEXTMESHCACHE_H
+#define RESOURCES_TEXTMESHCACHE_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace sb {
+
+class Font;
+class Mesh;
+
+// Least-recently-used cache of text meshes keyed by (font, string), so that
+// HUD text that does not change between frames is not rebuilt and
+// re-uploaded every time it is drawn.
+class TextMeshCache
+{
+public:
+    static const size_t DEFAULT_CAPACITY_BYTES = 1024 * 1024;
+
+    TextMeshCache(size_t capacityBytes = DEFAULT_CAPACITY_BYTES);
+
+    std::shared_ptr<Mesh> get(const std::shared_ptr<Font>& font,
+                              const std::string& text);
+
+    void setCapacity(size_t capacityBytes);
+    size_t getSizeBytes() const { return mSizeBytes; }
+
+    void clear();
+
+private:
+    typedef std::pair<const Font*, std::string> Key;
+
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<Font> font;
+        std::shared_ptr<Mesh> mesh;
+        size_t sizeBytes;
+    };
+
+    // most recently used first
+    std::list<Entry> mEntries;
+    std::map<Key, std::list<Entry>::iterator> mIndex;
+    size_t mCapacityBytes;
+    size_t mSizeBytes;
+
+    void evict();
+};
+
+} // namespace sb
+
+#endif // RESOURCES_TEXTMESHCACHE_H
@@ -0,0 +1,87 @@
+#ifndef RESOURCES_TEXTUREATLAS_H
+#define RESOURCES_TEXTUREATLAS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sandbox/utils/types.h>
+
+namespace sb {
+
+class Image;
+class Texture;
+
+// Packs images into shared RGBA texture pages using a skyline bottom-left
+// packer. Images that do not fit into a page get a page of their own.
+class TextureAtlas
+{
+public:
+    static const uint32_t DEFAULT_PAGE_SIZE = 1024;
+    // texels around each image repeating its edges, against bleeding with
+    // linear filtering
+    static const uint32_t PADDING = 1;
+
+    struct Region
+    {
+        std::shared_ptr<const Texture> page;
+        Vec2 uvMin;
+        Vec2 uvMax;
+        Vec2i sizePixels;
+    };
+
+    TextureAtlas(uint32_t pageSize = DEFAULT_PAGE_SIZE);
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator =(const TextureAtlas&) = delete;
+
+    // packs the image on first use
+    const Region& getRegion(const std::string& name,
+                            const std::shared_ptr<Image>& image);
+
+    size_t getNumPages() const { return mPages.size(); }
+    void clear();
+
+private:
+    class SkylinePacker
+    {
+    public:
+        SkylinePacker(uint32_t width, uint32_t height);
+
+        // returns false if the rect does not fit
+        bool insert(uint32_t width, uint32_t height, Vec2i& outPos);
+
+    private:
+        struct Segment
+        {
+            uint32_t x;
+            uint32_t y;
+            uint32_t width;
+        };
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        std::vector<Segment> mSkyline;
+
+        // y at which a rect of given width fits when placed at segment idx;
+        // false if it does not fit at all
+        bool fitAt(size_t idx, uint32_t width, uint32_t height,
+                   uint32_t& outY) const;
+    };
+
+    struct Page
+    {
+        std::shared_ptr<Texture> texture;
+        SkylinePacker packer;
+        Vec2i size;
+    };
+
+    uint32_t mPageSize;
+    std::vector<Page> mPages;
+    std::map<std::string, Region> mRegions;
+};
+
+} // namespace sb
+
+#endif // RESOURCES_TEXTUREATLAS_H
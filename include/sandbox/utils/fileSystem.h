@@ -0,0 +1,40 @@
+#ifndef UTILS_FILESYSTEM_H
+#define UTILS_FILESYSTEM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sb {
+namespace utils {
+
+// mkdir -p
+bool makeDirectories(const std::string& path);
+
+// $XDG_CACHE_HOME/sandbox/name, or ~/.cache/sandbox/name; empty if neither
+// variable is set
+std::string getCacheDirectory(const std::string& name);
+
+// false if path cannot be stat'ed
+bool getFileInfo(const std::string& path,
+                 uint64_t& outModificationTimeNs,
+                 uint64_t& outSizeBytes);
+
+// regular files under directory, recursively, as paths relative to it,
+// sorted; false if directory cannot be read
+bool listFiles(const std::string& directory,
+               std::vector<std::string>& outPaths);
+
+// whole file contents; false if it cannot be read
+bool readFile(const std::string& path,
+              std::string& outData);
+
+// writes to a temporary file renamed to path afterwards, so that readers
+// never see a truncated file, even after a crash
+bool writeFileAtomic(const std::string& path,
+                     const std::string& data);
+
+} // namespace utils
+} // namespace sb
+
+#endif // UTILS_FILESYSTEM_H
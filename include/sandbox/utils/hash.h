@@ -0,0 +1,38 @@
+#ifndef UTILS_HASH_H
+#define UTILS_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sb {
+namespace utils {
+
+const uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV1A_PRIME = 1099511628211ULL;
+
+// 64-bit FNV-1a; pass the previous result as hash to combine several inputs.
+// Fast and good enough for cache keys, not for anything adversarial.
+inline uint64_t fnv1a(const void* data,
+                      size_t bytes,
+                      uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+    const uint8_t* ptr = (const uint8_t*)data;
+    for (size_t i = 0; i < bytes; ++i) {
+        hash ^= ptr[i];
+        hash *= FNV1A_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t fnv1a(const std::string& str,
+                      uint64_t hash = FNV1A_OFFSET_BASIS)
+{
+    // include the terminator, so that ("ab", "c") and ("a", "bc") differ
+    return fnv1a(str.c_str(), str.size() + 1, hash);
+}
+
+} // namespace utils
+} // namespace sb
+
+#endif // UTILS_HASH_H
@@ -0,0 +1,39 @@
+#ifndef UTILS_MAPPEDFILE_H
+#define UTILS_MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace sb {
+
+// Read-only mmap of a whole file. Pages are faulted in on first access, so
+// opening is cheap regardless of file size.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator =(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& old);
+    MappedFile& operator =(MappedFile&& old);
+
+    // unmaps previously opened file; false if path cannot be mapped
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return mData != nullptr; }
+    const uint8_t* getData() const { return mData; }
+    size_t getSize() const { return mSize; }
+
+private:
+    const uint8_t* mData;
+    size_t mSize;
+};
+
+} // namespace sb
+
+#endif // UTILS_MAPPEDFILE_H
@@ -0,0 +1,42 @@
+#ifndef UTILS_RANGEALLOCATOR_H
+#define UTILS_RANGEALLOCATOR_H
+
+#include <cstddef>
+#include <map>
+
+namespace sb {
+
+// first-fit sub-allocator of [0, capacity) ranges; adjacent free ranges
+// are merged when released
+class RangeAllocator
+{
+public:
+    static const size_t INVALID_OFFSET = ~(size_t)0;
+
+    explicit RangeAllocator(size_t capacity);
+
+    // returns INVALID_OFFSET if there is no free range large enough
+    size_t allocate(size_t size,
+                    size_t alignment = 1);
+    void free(size_t offset,
+              size_t size);
+    // extends the managed range to [0, newCapacity)
+    void grow(size_t newCapacity);
+
+    size_t getCapacity() const { return mCapacity; }
+    size_t getUsed() const { return mUsed; }
+
+private:
+    // offset -> size
+    std::map<size_t, size_t> mFreeRanges;
+    size_t mCapacity;
+    size_t mUsed;
+
+    // adds range to the free list, merging it with adjacent ones
+    void insertFreeRange(size_t offset,
+                         size_t size);
+};
+
+} // namespace sb
+
+#endif // UTILS_RANGEALLOCATOR_H
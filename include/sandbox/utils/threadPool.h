@@ -0,0 +1,43 @@
+#ifndef UTILS_THREADPOOL_H
+#define UTILS_THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sb {
+
+// Fixed set of worker threads running submitted jobs in FIFO order. Jobs
+// must not touch GL, which is only usable on the thread owning the context.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t numThreads = getDefaultThreadCount());
+    // drops jobs that have not started yet and joins all workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator =(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> job);
+
+    // one less than the number of hardware threads, leaving one core for
+    // the render thread, but at least 1
+    static size_t getDefaultThreadCount();
+
+private:
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mJobs;
+    std::mutex mMutex;
+    std::condition_variable mJobAdded;
+    bool mStopping;
+
+    void run();
+};
+
+} // namespace sb
+
+#endif // UTILS_THREADPOOL_H
@@ -6,13 +6,17 @@
 #include <sandbox/utils/stringUtils.h>
 #include <sandbox/utils/debug.h>
 
+#include <cstring>
 #include <map>
 
 namespace sb
 {
     Buffer::Buffer(const void* data,
-                   size_t bytes):
+                   size_t bytes,
+                   GLenum usage):
         id(0),
+        sizeBytes(bytes),
+        usage(usage),
         bufferType(0),
         prevId(0)
     {
@@ -27,17 +31,19 @@ namespace sb
         {
             auto bind = make_bind(*this, GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
 
-            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, bytes, data,
-                                  GL_DYNAMIC_DRAW));
+            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, bytes, data, usage));
         }
     }
 
     Buffer::Buffer(Buffer&& old):
         id(old.id),
+        sizeBytes(old.sizeBytes),
+        usage(old.usage),
         bufferType(old.bufferType),
         prevId(old.prevId)
     {
         old.id = 0;
+        old.sizeBytes = 0;
         old.bufferType = 0;
         old.prevId = 0;
     }
@@ -50,10 +56,13 @@ namespace sb
         }
 
         id = old.id;
+        sizeBytes = old.sizeBytes;
+        usage = old.usage;
         bufferType = old.bufferType;
         prevId = old.prevId;
 
         old.id = 0;
+        old.sizeBytes = 0;
         old.bufferType = 0;
         old.prevId = 0;
 
@@ -105,5 +114,79 @@ namespace sb
         bufferType = 0;
         prevId = 0;
     }
-} // namespace sb
 
+    void Buffer::upload(const void* data,
+                        size_t bytes)
+    {
+        if (bytes == 0) {
+            return;
+        }
+
+        auto bind = make_bind(*this, GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
+
+        if (bytes > sizeBytes) {
+            sizeBytes = bytes;
+            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, sizeBytes, data, usage));
+        } else {
+            // no draw can be using the fresh storage yet
+            GL_CHECK(glBufferData(GL_ARRAY_BUFFER, sizeBytes, NULL, usage));
+            mapAndCopy(0, data, bytes, GL_MAP_UNSYNCHRONIZED_BIT);
+        }
+    }
+
+    void Buffer::write(size_t offsetBytes,
+                       const void* data,
+                       size_t bytes,
+                       WriteMode mode)
+    {
+        sbAssert(offsetBytes + bytes <= sizeBytes,
+                 "writing %lu bytes at %lu past buffer end (%lu bytes)",
+                 bytes, offsetBytes, sizeBytes);
+        if (bytes == 0) {
+            return;
+        }
+
+        auto bind = make_bind(*this, GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
+
+        switch (mode) {
+        case WriteMode::SubData:
+            GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, offsetBytes, bytes, data));
+            break;
+        case WriteMode::InvalidateRange:
+            mapAndCopy(offsetBytes, data, bytes, 0);
+            break;
+        case WriteMode::Unsynchronized:
+            mapAndCopy(offsetBytes, data, bytes, GL_MAP_UNSYNCHRONIZED_BIT);
+            break;
+        }
+    }
+
+    // buffer must be bound to GL_ARRAY_BUFFER
+    void Buffer::mapAndCopy(size_t offsetBytes,
+                            const void* data,
+                            size_t bytes,
+                            GLbitfield extraAccess)
+    {
+        void* dst;
+        GL_CHECK(dst = glMapBufferRange(GL_ARRAY_BUFFER, offsetBytes, bytes,
+                                        GL_MAP_WRITE_BIT
+                                        | GL_MAP_INVALIDATE_RANGE_BIT
+                                        | extraAccess));
+        if (!dst) {
+            // mapping may fail e.g. for out-of-memory; fall back to a copy
+            gLog.warn("glMapBufferRange failed, using glBufferSubData");
+            GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, offsetBytes, bytes, data));
+            return;
+        }
+
+        memcpy(dst, data, bytes);
+
+        GLboolean unmapped;
+        GL_CHECK(unmapped = glUnmapBuffer(GL_ARRAY_BUFFER));
+        if (!unmapped) {
+            // contents got corrupted, e.g. by a video mode switch
+            gLog.warn("buffer %u contents lost while mapped, rewriting", id);
+            GL_CHECK(glBufferSubData(GL_ARRAY_BUFFER, offsetBytes, bytes, data));
+        }
+    }
+} // namespace sb
@@ -0,0 +1,183 @@
+#include <sandbox/rendering/debugDraw.h>
+#include <sandbox/rendering/camera.h>
+#include <sandbox/rendering/shader.h>
+
+#include <sandbox/resources/resourceMgr.h>
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/math.h>
+#include <sandbox/utils/misc.h>
+
+#include <cmath>
+
+namespace sb {
+namespace {
+
+const size_t SPHERE_SEGMENTS = 24;
+
+// arrow head length, relative to arrow length
+const float ARROW_HEAD_SIZE = 0.1f;
+
+// any unit vector perpendicular to v
+Vec3 perpendicular(const Vec3& v)
+{
+    Vec3 axis = std::abs(v.y) < 0.9f ? Vec3(0.f, 1.f, 0.f)
+                                     : Vec3(1.f, 0.f, 0.f);
+    return v.cross(axis).normalized();
+}
+
+} // namespace
+
+DebugDraw::DebugDraw():
+    mBuckets(),
+    mShader(gResourceMgr.getDebugShader()),
+    mVertexBuffer(),
+    mPositions(),
+    mColors()
+{
+    // a single vertex just to get the buffers created; real data gets
+    // uploaded on each flush
+    mVertexBuffer.reset(new VertexBuffer({ Vec3() }, {}, { Color() }, {}));
+}
+
+void DebugDraw::line(const Vec3& from,
+                     const Vec3& to,
+                     const Color& color,
+                     bool depthTest)
+{
+    Bucket& bucket = mBuckets[depthTest];
+
+    bucket.positions.push_back(from);
+    bucket.positions.push_back(to);
+    bucket.colors.push_back(color);
+    bucket.colors.push_back(color);
+}
+
+void DebugDraw::arrow(const Vec3& from,
+                      const Vec3& to,
+                      const Color& color,
+                      bool depthTest)
+{
+    line(from, to, color, depthTest);
+
+    Vec3 dir = to - from;
+    float length = dir.length();
+    if (length <= 0.f) {
+        return;
+    }
+
+    dir = dir / length;
+    Vec3 side = perpendicular(dir);
+    Vec3 up = dir.cross(side);
+
+    float headSize = length * ARROW_HEAD_SIZE;
+    Vec3 headBase = to - dir * headSize;
+    side = side * (headSize * 0.5f);
+    up = up * (headSize * 0.5f);
+
+    line(to, headBase + side, color, depthTest);
+    line(to, headBase - side, color, depthTest);
+    line(to, headBase + up, color, depthTest);
+    line(to, headBase - up, color, depthTest);
+}
+
+void DebugDraw::polyline(const std::vector<Vec3>& points,
+                         const Color& color,
+                         bool depthTest)
+{
+    polyline(points.begin(), points.end(), color, depthTest);
+}
+
+void DebugDraw::sphere(const Vec3& center,
+                       float radius,
+                       const Color& color,
+                       bool depthTest)
+{
+    // three great circles, one per axis plane
+    for (size_t i = 0; i < SPHERE_SEGMENTS; ++i) {
+        float a0 = 2.f * PI * (float)i / (float)SPHERE_SEGMENTS;
+        float a1 = 2.f * PI * (float)(i + 1) / (float)SPHERE_SEGMENTS;
+
+        float s0 = std::sin(a0) * radius;
+        float c0 = std::cos(a0) * radius;
+        float s1 = std::sin(a1) * radius;
+        float c1 = std::cos(a1) * radius;
+
+        line(center + Vec3(c0, s0, 0.f), center + Vec3(c1, s1, 0.f), color, depthTest);
+        line(center + Vec3(c0, 0.f, s0), center + Vec3(c1, 0.f, s1), color, depthTest);
+        line(center + Vec3(0.f, c0, s0), center + Vec3(0.f, c1, s1), color, depthTest);
+    }
+}
+
+void DebugDraw::aabb(const Vec3& min,
+                     const Vec3& max,
+                     const Color& color,
+                     bool depthTest)
+{
+    const Vec3 corners[] = {
+        { min.x, min.y, min.z }, { max.x, min.y, min.z },
+        { max.x, max.y, min.z }, { min.x, max.y, min.z },
+        { min.x, min.y, max.z }, { max.x, min.y, max.z },
+        { max.x, max.y, max.z }, { min.x, max.y, max.z }
+    };
+
+    for (size_t i = 0; i < 4; ++i) {
+        // bottom face, top face, vertical edges
+        line(corners[i], corners[(i + 1) % 4], color, depthTest);
+        line(corners[i + 4], corners[(i + 1) % 4 + 4], color, depthTest);
+        line(corners[i], corners[i + 4], color, depthTest);
+    }
+}
+
+void DebugDraw::flush(Camera& camera)
+{
+    mPositions.clear();
+    mColors.clear();
+    for (const Bucket& bucket: mBuckets) {
+        mPositions.insert(mPositions.end(),
+                          bucket.positions.begin(), bucket.positions.end());
+        mColors.insert(mColors.end(),
+                       bucket.colors.begin(), bucket.colors.end());
+    }
+
+    if (mPositions.empty()) {
+        return;
+    }
+
+    mVertexBuffer->update(Attrib::Kind::Position, &mPositions[0], mPositions.size());
+    mVertexBuffer->update(Attrib::Kind::Color, &mColors[0], mColors.size());
+
+    auto vaoBind = make_bind(*mVertexBuffer);
+    auto shaderBind = make_bind(*mShader, *mVertexBuffer);
+    mShader->setUniform("matViewProjection", camera.getViewProjectionMatrix());
+
+    GLboolean depthTestEnabled;
+    GL_CHECK(depthTestEnabled = glIsEnabled(GL_DEPTH_TEST));
+
+    GLint first = 0;
+    for (size_t depthTest = 0; depthTest < mBuckets.size(); ++depthTest) {
+        Bucket& bucket = mBuckets[depthTest];
+        if (bucket.positions.empty()) {
+            continue;
+        }
+
+        if (depthTest) {
+            GL_CHECK(glEnable(GL_DEPTH_TEST));
+        } else {
+            GL_CHECK(glDisable(GL_DEPTH_TEST));
+        }
+
+        GL_CHECK(glDrawArrays(GL_LINES, first, (GLsizei)bucket.positions.size()));
+        first += (GLint)bucket.positions.size();
+
+        bucket.positions.clear();
+        bucket.colors.clear();
+    }
+
+    if (depthTestEnabled) {
+        GL_CHECK(glEnable(GL_DEPTH_TEST));
+    } else {
+        GL_CHECK(glDisable(GL_DEPTH_TEST));
+    }
+}
+
+} // namespace sb
@@ -4,6 +4,8 @@
 #include <sandbox/resources/mesh.h>
 #include <sandbox/resources/image.h>
 
+#include <tuple>
+
 namespace sb {
 
 Drawable::Drawable(ProjectionType projType,
@@ -12,6 +14,7 @@ Drawable::Drawable(ProjectionType projType,
                    const std::shared_ptr<Shader>& shader):
     mMesh(mesh),
     mTextures({ { "tex", texture ? texture : gResourceMgr.getDefaultTexture() } }),
+    mTextureLayers(),
     mShader(shader),
     mColor(Color::White),
     mTranslationMatrix(),
@@ -148,10 +151,42 @@ void Drawable::setTexture(const std::shared_ptr<const Texture>& tex)
     setTexture("tex", tex);
 }
 
-namespace {
+void Drawable::setTextureLayer(const std::string& uniformName,
+                               const TextureLayer& layer)
+{
+    sbAssert(layer.array, "invalid texture layer");
+
+    // a sampler can only be one of these
+    mTextures.erase(uniformName);
+    mTextureLayers[uniformName] = layer;
+}
+
+const void* Drawable::getTextureKey() const
+{
+    if (!mTextureLayers.empty()) {
+        return mTextureLayers.begin()->second.array.get();
+    }
+    if (!mTextures.empty()) {
+        return mTextures.begin()->second.get();
+    }
+    return nullptr;
+}
 
-void setLightUniforms(const Renderer::State& state,
-                      const std::shared_ptr<Shader>& shader)
+bool Drawable::operator <(const Drawable& d) const
+{
+    // perspective first, so that the HUD still ends up on top
+    if (mProjectionType != d.mProjectionType) {
+        return mProjectionType == ProjectionType::Perspective;
+    }
+
+    return std::make_tuple(mShader.get(), getTextureKey(),
+                           mMesh->getVertexArrayKey(), mMesh.get())
+            < std::make_tuple(d.mShader.get(), d.getTextureKey(),
+                              d.mMesh->getVertexArrayKey(), d.mMesh.get());
+}
+
+void Drawable::setLightUniforms(const Renderer::State& state,
+                                const std::shared_ptr<Shader>& shader)
 {
     if (shader->hasUniform("eyePos")) {
         shader->setUniform("eyePos", state.camera->getEye());
@@ -161,11 +196,16 @@ void setLightUniforms(const Renderer::State& state,
         shader->setUniform("ambientLightColor", state.ambientLightColor);
     }
 
-    sbAssert(shader->hasUniform("pointLights") == shader->hasUniform("numPointLights"),
-             "pointLights and numPointLights must both be present");
+    // light and shadow counts are uniforms, unless compiled in by a
+    // permutation with POINT_LIGHTS/PARALLEL_LIGHTS/SHADOWS defined
+    sbAssert(shader->hasUniform("pointLights")
+                 || !shader->hasUniform("numPointLights"),
+             "numPointLights requires pointLights");
 
     if (shader->hasUniform("pointLights")) {
-        shader->setUniform("numPointLights", (unsigned)state.pointLights.size());
+        if (shader->hasUniform("numPointLights")) {
+            shader->setUniform("numPointLights", (unsigned)state.pointLights.size());
+        }
         for (size_t i = 0; i < state.pointLights.size(); ++i) {
             std::string base = utils::format("pointLights[{0}]", i);
             const Light& l = state.pointLights[i];
@@ -176,11 +216,14 @@ void setLightUniforms(const Renderer::State& state,
         }
     }
 
-    sbAssert(shader->hasUniform("parallelLights") == shader->hasUniform("numParallelLights"),
-             "parallelLights and numParallelLights must both be present");
+    sbAssert(shader->hasUniform("parallelLights")
+                 || !shader->hasUniform("numParallelLights"),
+             "numParallelLights requires parallelLights");
 
     if (shader->hasUniform("parallelLights")) {
-        shader->setUniform("numParallelLights", (unsigned)state.parallelLights.size());
+        if (shader->hasUniform("numParallelLights")) {
+            shader->setUniform("numParallelLights", (unsigned)state.parallelLights.size());
+        }
         for (size_t i = 0; i < state.parallelLights.size(); ++i) {
             std::string base = utils::format("parallelLights[{0}]", i);
             const Light& l = state.parallelLights[i];
@@ -192,16 +235,19 @@ void setLightUniforms(const Renderer::State& state,
     }
 }
 
-void setShadowUniforms(Renderer::State& state,
-                       const std::shared_ptr<const Shader>& shader,
-                       size_t firstTextureUnit,
-                       std::vector<bind_guard<Texture>>& outBinds)
+void Drawable::setShadowUniforms(Renderer::State& state,
+                                 const std::shared_ptr<const Shader>& shader,
+                                 size_t firstTextureUnit,
+                                 std::vector<bind_guard<Texture>>& outBinds)
 {
-    sbAssert(shader->hasUniform("shadows") == shader->hasUniform("numShadows"),
-             "shadows and numShadows must both be present");
+    sbAssert(shader->hasUniform("shadows")
+                 || !shader->hasUniform("numShadows"),
+             "numShadows requires shadows");
 
     if (shader->hasUniform("shadows")) {
-        shader->setUniform("numShadows", (unsigned)state.shadows.size());
+        if (shader->hasUniform("numShadows")) {
+            shader->setUniform("numShadows", (unsigned)state.shadows.size());
+        }
 
         outBinds.clear();
         outBinds.reserve(state.shadows.size());
@@ -217,8 +263,6 @@ void setShadowUniforms(Renderer::State& state,
     }
 }
 
-} // namespace
-
 void Drawable::draw(Renderer::State& state) const
 {
     if (state.isRenderingShadow
@@ -226,35 +270,46 @@ void Drawable::draw(Renderer::State& state) const
         return;
     }
 
-    auto vaoBind = make_bind(mMesh->getVertexBuffer());
-    auto indexBind = make_bind(mMesh->getIndexBuffer());
-    auto shaderBind = make_bind(*mShader, mMesh->getVertexBuffer());
+    // variant with light counts compiled in, if the shader supports that
+    const std::shared_ptr<Shader> shader =
+            gResourceMgr.getShaderPermutation(mShader);
 
-    mShader->setUniform("matViewProjection",
+    auto meshBind = make_bind(*mMesh);
+    auto shaderBind = make_bind(*shader, mMesh->getAttribs());
+
+    shader->setUniform("matViewProjection",
                         state.camera->getViewProjectionMatrix());
-    mShader->setUniform("matModel", getTransformationMatrix());
+    shader->setUniform("matModel", getTransformationMatrix());
 
     std::vector<bind_guard<Texture>> textureBinds;
     std::vector<bind_guard<Texture>> shadowBinds;
+    std::vector<bind_guard<TextureArray>> layerBinds;
     if (!state.isRenderingShadow) {
-        mShader->setUniform("color", mColor);
+        shader->setUniform("color", mColor);
 
         size_t boundTextures = 0;
         for (const auto& pair: mTextures) {
-            if (mShader->hasUniform(pair.first)) {
+            if (shader->hasUniform(pair.first)) {
                 textureBinds.emplace_back(make_bind(*pair.second, boundTextures));
-                mShader->setUniform(pair.first, (GLint)boundTextures);
+                shader->setUniform(pair.first, (GLint)boundTextures);
+                ++boundTextures;
+            }
+        }
+
+        for (const auto& pair: mTextureLayers) {
+            if (shader->hasUniform(pair.first)) {
+                layerBinds.emplace_back(make_bind(*pair.second.array, boundTextures));
+                shader->setUniform(pair.first, (GLint)boundTextures);
+                shader->setUniform(pair.first + "Layer", (float)pair.second.layer);
                 ++boundTextures;
             }
         }
 
-        setLightUniforms(state, mShader);
-        setShadowUniforms(state, mShader, boundTextures, shadowBinds);
+        setLightUniforms(state, shader);
+        setShadowUniforms(state, shader, boundTextures, shadowBinds);
     }
 
-    GL_CHECK(glDrawElements((GLuint)mMesh->getShape(),
-                            mMesh->getIndexBufferSize(),
-                            GL_UNSIGNED_INT, (void*)NULL));
+    mMesh->draw();
 }
 
 }
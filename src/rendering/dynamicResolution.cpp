@@ -0,0 +1,148 @@
+#include <sandbox/rendering/dynamicResolution.h>
+
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/math.h>
+#include <sandbox/utils/logger.h>
+
+#include <cmath>
+
+namespace sb {
+namespace {
+
+// weight of the newest sample in the moving average
+const float SMOOTHING = 0.1f;
+// scale changes by this much at once
+const float SCALE_STEP = 0.05f;
+// scale back up only when comfortably below the budget
+const float HEADROOM = 0.85f;
+// let the moving average settle after each change
+const uint32_t RESCALE_COOLDOWN_FRAMES = 10;
+
+} // namespace
+
+constexpr float DynamicResolution::MIN_SCALE;
+constexpr float DynamicResolution::MAX_SCALE;
+
+DynamicResolution::DynamicResolution(float frameTimeBudgetMs):
+    mQueries(),
+    mQueryPending(),
+    mCurrentQuery(0),
+    mBudgetMs(frameTimeBudgetMs),
+    mAverageMs(0.0f),
+    mScale(MAX_SCALE),
+    mFramesSinceRescale(0)
+{
+    GL_CHECK(glGenQueries((GLsizei)mQueries.size(), mQueries.data()));
+    mQueryPending.fill(false);
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    GL_CHECK(glDeleteQueries((GLsizei)mQueries.size(), mQueries.data()));
+}
+
+void DynamicResolution::beginFrame()
+{
+    collectResults();
+
+    // all queries still in flight - skip measuring this frame
+    if (mQueryPending[mCurrentQuery]) {
+        return;
+    }
+
+    GL_CHECK(glBeginQuery(GL_TIME_ELAPSED, mQueries[mCurrentQuery]));
+    mQueryPending[mCurrentQuery] = true;
+}
+
+void DynamicResolution::endFrame()
+{
+    GLint active = 0;
+    GL_CHECK(glGetQueryiv(GL_TIME_ELAPSED, GL_CURRENT_QUERY, &active));
+    if ((GLuint)active != mQueries[mCurrentQuery]) {
+        return;
+    }
+
+    GL_CHECK(glEndQuery(GL_TIME_ELAPSED));
+    mCurrentQuery = (mCurrentQuery + 1) % mQueries.size();
+}
+
+void DynamicResolution::collectResults()
+{
+    bool gotSample = false;
+
+    for (size_t i = 0; i < mQueries.size(); ++i) {
+        // oldest first
+        size_t idx = (mCurrentQuery + i) % mQueries.size();
+        if (!mQueryPending[idx]) {
+            continue;
+        }
+
+        GLint available = 0;
+        GL_CHECK(glGetQueryObjectiv(mQueries[idx], GL_QUERY_RESULT_AVAILABLE,
+                                    &available));
+        if (!available) {
+            break;
+        }
+
+        GLuint64 elapsedNs = 0;
+        GL_CHECK(glGetQueryObjectui64v(mQueries[idx], GL_QUERY_RESULT,
+                                       &elapsedNs));
+        mQueryPending[idx] = false;
+
+        float elapsedMs = (float)elapsedNs / 1000000.0f;
+        mAverageMs = (mAverageMs == 0.0f)
+                ? elapsedMs
+                : mAverageMs + SMOOTHING * (elapsedMs - mAverageMs);
+        gotSample = true;
+    }
+
+    if (gotSample) {
+        updateScale();
+    }
+}
+
+void DynamicResolution::updateScale()
+{
+    if (++mFramesSinceRescale < RESCALE_COOLDOWN_FRAMES) {
+        return;
+    }
+
+    float newScale = mScale;
+    if (mAverageMs > mBudgetMs) {
+        newScale -= SCALE_STEP;
+    } else if (mAverageMs < mBudgetMs * HEADROOM) {
+        newScale += SCALE_STEP;
+    }
+
+    newScale = math::clamp(newScale, MIN_SCALE, MAX_SCALE);
+    if (newScale != mScale) {
+        gLog.trace("dynamic resolution: GPU time %.2f ms (budget %.2f ms), "
+                   "scale %.2f -> %.2f", mAverageMs, mBudgetMs,
+                   mScale, newScale);
+        mScale = newScale;
+        mFramesSinceRescale = 0;
+    }
+}
+
+Vec2i DynamicResolution::getScaledSize(const Vec2i& fullSize) const
+{
+    return Vec2i(std::max(1, (int)std::lround((float)fullSize.x * mScale)),
+                 std::max(1, (int)std::lround((float)fullSize.y * mScale)));
+}
+
+void DynamicResolution::blit(const Framebuffer& source,
+                             const IntRect& target) const
+{
+    sbAssert(source.getColorTexture(), "blit source has no color attachment");
+
+    Vec2i scaled = getScaledSize(Vec2i(target.width(), target.height()));
+
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, source.getId()));
+    GL_CHECK(glBlitFramebuffer(0, 0, scaled.x, scaled.y,
+                               target.left, target.bottom,
+                               target.right, target.top,
+                               GL_COLOR_BUFFER_BIT, GL_LINEAR));
+    GL_CHECK(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+} // namespace sb
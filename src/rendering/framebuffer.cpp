@@ -7,13 +7,17 @@
 namespace sb {
 
 Framebuffer::Framebuffer(uint32_t width,
-                         uint32_t height):
+                         uint32_t height,
+                         Attachments attachments):
     sizePixels(width, height),
     id(0),
 #if WITH_RENDERBUFFER
     renderbufferId(0),
 #endif
-    texture(std::make_shared<Texture>(width, height))
+    texture(std::make_shared<Texture>(width, height)),
+    colorTexture(attachments == Attachments::ColorDepth
+                 ? std::make_shared<Texture>(width, height, Texture::Format::RGBA)
+                 : nullptr)
 {
     GL_CHECK(glGenFramebuffers(1, &id));
     auto bind = make_bind(*this);
@@ -28,8 +32,15 @@ Framebuffer::Framebuffer(uint32_t width,
 
     GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
                                     GL_TEXTURE_2D, texture->getId(), 0));
-    GL_CHECK(glDrawBuffer(GL_NONE));
-    GL_CHECK(glReadBuffer(GL_NONE));
+    if (colorTexture) {
+        GL_CHECK(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                        GL_TEXTURE_2D, colorTexture->getId(), 0));
+        GL_CHECK(glDrawBuffer(GL_COLOR_ATTACHMENT0));
+        GL_CHECK(glReadBuffer(GL_COLOR_ATTACHMENT0));
+    } else {
+        GL_CHECK(glDrawBuffer(GL_NONE));
+        GL_CHECK(glReadBuffer(GL_NONE));
+    }
 
 #if WITH_RENDERBUFFER
     //GL_CHECK(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
@@ -67,7 +78,12 @@ void Framebuffer::unbind() const
     GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
     //GL_CHECK(glDrawBuffer(GL_BACK));
     //GL_CHECK(glReadBuffer(GL_BACK));
+}
 
+void Framebuffer::generateMipmaps() const
+{
+    // called by the render graph only before a pass that reads this target
+    // with needsMipmaps, and only if it was written since the last call
     auto texBind = make_bind(*texture, 0);
     GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D));
 }
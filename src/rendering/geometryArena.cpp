@@ -0,0 +1,227 @@
+#include <sandbox/rendering/geometryArena.h>
+#include <sandbox/rendering/indexBuffer.h>
+
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+
+namespace sb {
+namespace {
+
+// few enough to look up linearly
+std::vector<std::weak_ptr<GeometryArena>> gArenas;
+
+} // namespace
+
+std::shared_ptr<GeometryArena>
+GeometryArena::get(const VertexLayout& layout,
+                   const std::vector<Attrib::Kind>& attribs)
+{
+    for (const std::weak_ptr<GeometryArena>& weakArena: gArenas) {
+        std::shared_ptr<GeometryArena> arena = weakArena.lock();
+        if (arena && arena->matches(layout, attribs)) {
+            return arena;
+        }
+    }
+
+    gArenas.erase(std::remove_if(gArenas.begin(), gArenas.end(),
+                                 [](const std::weak_ptr<GeometryArena>& arena) {
+                                     return arena.expired();
+                                 }),
+                  gArenas.end());
+
+    auto arena = std::make_shared<GeometryArena>(layout, attribs);
+    gArenas.push_back(arena);
+    return arena;
+}
+
+GeometryArena::GeometryArena(const VertexLayout& layout,
+                             const std::vector<Attrib::Kind>& attribs):
+    mLayout(layout),
+    mAttribs(attribs),
+    mStride(layout.getStride(attribs)),
+    mVAO(0),
+    mVertexBuffer(new Buffer(NULL, INITIAL_VERTICES * mStride, layout.usage)),
+    mIndexBuffer(new Buffer(NULL, INITIAL_INDEX_BYTES, layout.usage)),
+    mVertexAllocator(INITIAL_VERTICES),
+    mIndexAllocator(INITIAL_INDEX_BYTES)
+{
+    sbAssert(layout.storage == VertexLayout::Storage::Interleaved,
+             "geometry arena requires interleaved vertex layout");
+
+    GL_CHECK(glGenVertexArrays(1, &mVAO));
+    setupVertexArray();
+}
+
+GeometryArena::~GeometryArena()
+{
+    if (mVAO) {
+        GLint current;
+        GL_CHECK(glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &current));
+        if ((GLuint)current == mVAO) {
+            GL_CHECK(glBindVertexArray(0));
+        }
+
+        GL_CHECK(glDeleteVertexArrays(1, &mVAO));
+    }
+}
+
+void GeometryArena::setupVertexArray()
+{
+    GL_CHECK(glBindVertexArray(mVAO));
+    {
+        auto vertexBind = make_bind(*mVertexBuffer, GL_ARRAY_BUFFER,
+                                    GL_ARRAY_BUFFER_BINDING);
+        mLayout.setAttribPointers(mAttribs);
+    }
+    // element buffer binding is a part of VAO state, keep it bound
+    GL_CHECK(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexBuffer->getId()));
+    GL_CHECK(glBindVertexArray(0));
+}
+
+size_t GeometryArena::allocateFrom(RangeAllocator& allocator,
+                                   std::unique_ptr<Buffer>& buffer,
+                                   size_t unitBytes,
+                                   size_t size,
+                                   size_t alignment)
+{
+    size_t offset = allocator.allocate(size, alignment);
+    if (offset != RangeAllocator::INVALID_OFFSET) {
+        return offset;
+    }
+
+    size_t oldCapacity = allocator.getCapacity();
+    size_t newCapacity = oldCapacity * 2;
+    while (newCapacity < oldCapacity + size + alignment) {
+        newCapacity *= 2;
+    }
+
+    gLog.trace("geometry arena: growing buffer from %lu to %lu bytes",
+               oldCapacity * unitBytes, newCapacity * unitBytes);
+
+    std::unique_ptr<Buffer> newBuffer(new Buffer(NULL, newCapacity * unitBytes,
+                                                 mLayout.usage));
+    GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, buffer->getId()));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer->getId()));
+    GL_CHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                 0, 0, oldCapacity * unitBytes));
+    GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+
+    buffer.swap(newBuffer);
+    allocator.grow(newCapacity);
+    setupVertexArray();
+
+    offset = allocator.allocate(size, alignment);
+    sbAssert(offset != RangeAllocator::INVALID_OFFSET,
+             "geometry arena allocation failed after growing");
+    return offset;
+}
+
+GeometryArena::Allocation
+GeometryArena::allocate(const std::vector<uint8_t>& vertexData,
+                        const std::vector<uint32_t>& indices)
+{
+    sbAssert(vertexData.size() % mStride == 0,
+             "vertex data size not a multiple of vertex size");
+    sbAssert(!indices.empty(), "geometry arena allocations must be indexed");
+
+    GLenum indexType = chooseIndexType(indices);
+    std::vector<uint8_t> indexData = packIndices(indices, indexType);
+    return allocate(vertexData.data(), vertexData.size() / mStride,
+                    indexData.data(), indices.size(), indexType);
+}
+
+GeometryArena::Allocation
+GeometryArena::allocate(const void* vertexData,
+                        size_t numVertices,
+                        const void* indexData,
+                        size_t numIndices,
+                        GLenum indexType)
+{
+    sbAssert(numIndices > 0, "geometry arena allocations must be indexed");
+
+    Allocation allocation;
+    allocation.numVertices = numVertices;
+    allocation.baseVertex = allocateFrom(mVertexAllocator, mVertexBuffer,
+                                         mStride, allocation.numVertices, 1);
+    mVertexBuffer->write(allocation.baseVertex * mStride,
+                         vertexData, numVertices * mStride);
+
+    allocation.numIndices = numIndices;
+    allocation.indexType = indexType;
+    allocation.indexSizeBytes = numIndices * getIndexSize(indexType);
+    allocation.indexOffsetBytes = allocateFrom(mIndexAllocator, mIndexBuffer,
+                                               1, allocation.indexSizeBytes,
+                                               sizeof(uint32_t));
+    mIndexBuffer->write(allocation.indexOffsetBytes,
+                        indexData, allocation.indexSizeBytes);
+
+    return allocation;
+}
+
+bool GeometryArena::fits(const Allocation& allocation,
+                         size_t numVertices,
+                         const std::vector<uint32_t>& indices) const
+{
+    return numVertices <= allocation.numVertices
+           && indices.size() * getIndexSize(allocation.indexType)
+                  <= allocation.indexSizeBytes
+           && (allocation.indexType == GL_UNSIGNED_INT
+               || chooseIndexType(indices) == GL_UNSIGNED_SHORT);
+}
+
+void GeometryArena::writeVertices(const Allocation& allocation,
+                                  size_t firstVertex,
+                                  const std::vector<uint8_t>& vertexData,
+                                  Buffer::WriteMode mode)
+{
+    sbAssert(vertexData.size() % mStride == 0,
+             "vertex data size not a multiple of vertex size");
+    sbAssert(firstVertex + vertexData.size() / mStride <= allocation.numVertices,
+             "writing vertices past the end of allocation");
+    if (vertexData.empty()) {
+        return;
+    }
+
+    mVertexBuffer->write((allocation.baseVertex + firstVertex) * mStride,
+                         &vertexData[0], vertexData.size(), mode);
+}
+
+void GeometryArena::writeIndices(const Allocation& allocation,
+                                 size_t firstIndex,
+                                 const std::vector<uint32_t>& indices,
+                                 Buffer::WriteMode mode)
+{
+    std::vector<uint8_t> indexData = packIndices(indices, allocation.indexType);
+    size_t offsetBytes = firstIndex * getIndexSize(allocation.indexType);
+
+    sbAssert(offsetBytes + indexData.size() <= allocation.indexSizeBytes,
+             "writing indices past the end of allocation");
+    if (indexData.empty()) {
+        return;
+    }
+
+    mIndexBuffer->write(allocation.indexOffsetBytes + offsetBytes,
+                        &indexData[0], indexData.size(), mode);
+}
+
+void GeometryArena::free(const Allocation& allocation)
+{
+    mVertexAllocator.free(allocation.baseVertex, allocation.numVertices);
+    mIndexAllocator.free(allocation.indexOffsetBytes, allocation.indexSizeBytes);
+}
+
+void GeometryArena::bind() const
+{
+    GL_CHECK(glBindVertexArray(mVAO));
+}
+
+void GeometryArena::unbind() const
+{
+    GL_CHECK(glBindVertexArray(0));
+}
+
+} // namespace sb
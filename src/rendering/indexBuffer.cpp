@@ -0,0 +1,95 @@
+#include <sandbox/rendering/indexBuffer.h>
+
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace sb
+{
+    namespace
+    {
+        std::vector<uint16_t> toShortIndices(const std::vector<uint32_t>& indices)
+        {
+            if (chooseIndexType(indices) != GL_UNSIGNED_SHORT) {
+                return {};
+            }
+
+            return std::vector<uint16_t>(indices.begin(), indices.end());
+        }
+    } // namespace
+
+    GLenum chooseIndexType(const std::vector<uint32_t>& indices)
+    {
+        uint32_t maxIndex = indices.empty()
+                ? 0
+                : *std::max_element(indices.begin(), indices.end());
+        return maxIndex > std::numeric_limits<uint16_t>::max()
+                ? GL_UNSIGNED_INT
+                : GL_UNSIGNED_SHORT;
+    }
+
+    size_t getIndexSize(GLenum indexType)
+    {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                              : sizeof(uint32_t);
+    }
+
+    std::vector<uint8_t> packIndices(const std::vector<uint32_t>& indices,
+                                     GLenum type)
+    {
+        if (type == GL_UNSIGNED_INT) {
+            const uint8_t* begin = (const uint8_t*)indices.data();
+            return std::vector<uint8_t>(begin,
+                                        begin + indices.size() * sizeof(uint32_t));
+        }
+
+        sbAssert(chooseIndexType(indices) == GL_UNSIGNED_SHORT,
+                 "indices do not fit in 16 bits");
+
+        std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+        const uint8_t* begin = (const uint8_t*)shortIndices.data();
+        return std::vector<uint8_t>(begin,
+                                    begin + shortIndices.size() * sizeof(uint16_t));
+    }
+
+    IndexBuffer::IndexBuffer(const std::vector<uint32_t>& indices):
+        IndexBuffer(indices, toShortIndices(indices))
+    {}
+
+    IndexBuffer::IndexBuffer(const std::vector<uint32_t>& indices,
+                             const std::vector<uint16_t>& shortIndices):
+        Buffer(shortIndices.empty() ? (const void*)&indices[0]
+                                    : (const void*)&shortIndices[0],
+               shortIndices.empty() ? indices.size() * sizeof(uint32_t)
+                                    : shortIndices.size() * sizeof(uint16_t),
+               GL_STATIC_DRAW),
+        mType(shortIndices.empty() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT),
+        mNumIndices(indices.size())
+    {}
+
+    void IndexBuffer::setIndices(const std::vector<uint32_t>& indices)
+    {
+        mType = chooseIndexType(indices);
+        mNumIndices = indices.size();
+
+        std::vector<uint8_t> data = packIndices(indices, mType);
+        upload(data.data(), data.size());
+    }
+
+    void IndexBuffer::writeIndices(size_t firstIndex,
+                                   const std::vector<uint32_t>& indices,
+                                   WriteMode mode)
+    {
+        sbAssert(firstIndex + indices.size() <= mNumIndices,
+                 "writing indices past the end of index buffer");
+
+        std::vector<uint8_t> data = packIndices(indices, mType);
+        write(firstIndex * getIndexSize(), data.data(), data.size(), mode);
+    }
+
+    size_t IndexBuffer::getIndexSize() const
+    {
+        return sb::getIndexSize(mType);
+    }
+} // namespace sb
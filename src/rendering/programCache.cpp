@@ -0,0 +1,266 @@
+#include <sandbox/rendering/programCache.h>
+
+#include <sandbox/utils/fileSystem.h>
+#include <sandbox/utils/hash.h>
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/stringUtils.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace sb {
+namespace {
+
+const uint32_t MAGIC = 0x43504253; // "SBPC"
+// 2: attribute locations fixed per Attrib::Kind
+const uint32_t VERSION = 2;
+
+class Writer
+{
+public:
+    void put(const void* data,
+             size_t bytes)
+    {
+        const char* ptr = (const char*)data;
+        mData.insert(mData.end(), ptr, ptr + bytes);
+    }
+
+    void put(uint32_t value) { put(&value, sizeof(value)); }
+    void put(uint64_t value) { put(&value, sizeof(value)); }
+
+    void put(const std::string& str)
+    {
+        put((uint32_t)str.size());
+        put(str.data(), str.size());
+    }
+
+    const std::string& getData() const { return mData; }
+
+private:
+    std::string mData;
+};
+
+// every get returns false once the input is exhausted
+class Reader
+{
+public:
+    explicit Reader(const std::string& data):
+        mData(data),
+        mOffset(0)
+    {}
+
+    bool get(void* out,
+             size_t bytes)
+    {
+        if (mData.size() - mOffset < bytes) {
+            return false;
+        }
+
+        memcpy(out, mData.data() + mOffset, bytes);
+        mOffset += bytes;
+        return true;
+    }
+
+    bool get(uint32_t& value) { return get(&value, sizeof(value)); }
+    bool get(uint64_t& value) { return get(&value, sizeof(value)); }
+
+    bool get(std::string& str)
+    {
+        uint32_t size;
+        if (!get(size) || mData.size() - mOffset < size) {
+            return false;
+        }
+
+        str = mData.substr(mOffset, size);
+        mOffset += size;
+        return true;
+    }
+
+private:
+    const std::string& mData;
+    size_t mOffset;
+};
+
+bool readEntry(Reader& reader,
+               uint64_t key,
+               ProgramCache::Entry& entry)
+{
+    uint32_t magic, version, count;
+    uint64_t storedKey;
+    if (!reader.get(magic) || magic != MAGIC
+            || !reader.get(version) || version != VERSION
+            || !reader.get(storedKey) || storedKey != key) {
+        return false;
+    }
+
+    std::string binary;
+    if (!reader.get(entry.binaryFormat) || !reader.get(binary)) {
+        return false;
+    }
+    entry.binary.assign(binary.begin(), binary.end());
+
+    if (!reader.get(count)) {
+        return false;
+    }
+    entry.filenames.resize(count);
+    for (std::string& filename: entry.filenames) {
+        if (!reader.get(filename)) {
+            return false;
+        }
+    }
+
+    if (!reader.get(count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t kind;
+        std::string type, name;
+        if (!reader.get(kind) || !reader.get(type) || !reader.get(name)) {
+            return false;
+        }
+        entry.inputs.insert({ (Attrib::Kind)kind,
+                              Input(name, type, (Attrib::Kind)kind) });
+    }
+
+    if (!reader.get(count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        std::string name, type;
+        if (!reader.get(name) || !reader.get(type)) {
+            return false;
+        }
+        entry.uniforms.insert(Uniform(name, type));
+    }
+
+    return true;
+}
+
+std::string getGLString(GLenum name)
+{
+    const GLubyte* str;
+    GL_CHECK(str = glGetString(name));
+    return str ? (const char*)str : "";
+}
+
+} // namespace
+
+ProgramCache::ProgramCache(const std::string& directory):
+    mDirectory(directory),
+    mDriverHash(utils::fnv1a(getGLString(GL_VERSION),
+                             utils::fnv1a(getGLString(GL_RENDERER))))
+{
+    if (mDirectory.empty()) {
+        return;
+    }
+
+    GLint numFormats = 0;
+    if (GLEW_ARB_get_program_binary) {
+        GL_CHECK(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats));
+    }
+    if (numFormats == 0) {
+        gLog.info("program binaries not supported, shader cache disabled");
+        mDirectory.clear();
+        return;
+    }
+
+    if (!utils::makeDirectories(mDirectory)) {
+        gLog.warn("cannot create shader cache directory %s: %s",
+                  mDirectory.c_str(), strerror(errno));
+        mDirectory.clear();
+        return;
+    }
+
+    gLog.trace("shader cache: %s", mDirectory.c_str());
+}
+
+std::string ProgramCache::getDefaultDirectory()
+{
+    return utils::getCacheDirectory("programs");
+}
+
+uint64_t ProgramCache::makeKey(const std::vector<std::string>& sources) const
+{
+    uint64_t hash = mDriverHash;
+    for (const std::string& source: sources) {
+        hash = utils::fnv1a(source, hash);
+    }
+    return hash;
+}
+
+std::string ProgramCache::getPath(uint64_t key) const
+{
+    char name[sizeof("0123456789abcdef.bin")];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return mDirectory + "/" + name;
+}
+
+bool ProgramCache::load(uint64_t key,
+                        Entry& outEntry) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    std::string data;
+    if (!utils::readFile(getPath(key), data)) {
+        return false;
+    }
+
+    Reader reader(data);
+    if (!readEntry(reader, key, outEntry)) {
+        gLog.warn("invalid shader cache entry: %s", getPath(key).c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void ProgramCache::store(uint64_t key,
+                         const Entry& entry) const
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    Writer writer;
+    writer.put(MAGIC);
+    writer.put(VERSION);
+    writer.put(key);
+    writer.put((uint32_t)entry.binaryFormat);
+    writer.put(std::string(entry.binary.begin(), entry.binary.end()));
+
+    writer.put((uint32_t)entry.filenames.size());
+    for (const std::string& filename: entry.filenames) {
+        writer.put(filename);
+    }
+
+    writer.put((uint32_t)entry.inputs.size());
+    for (const auto& kindInput: entry.inputs) {
+        writer.put((uint32_t)kindInput.first);
+        writer.put(kindInput.second.type);
+        writer.put(kindInput.second.name);
+    }
+
+    writer.put((uint32_t)entry.uniforms.size());
+    for (const Uniform& uniform: entry.uniforms) {
+        writer.put(uniform.name);
+        writer.put(uniform.type);
+    }
+
+    const std::string path = getPath(key);
+    if (!utils::writeFileAtomic(path, writer.getData())) {
+        gLog.warn("cannot write shader cache entry: %s", path.c_str());
+    }
+}
+
+void ProgramCache::remove(uint64_t key) const
+{
+    if (isEnabled()) {
+        ::remove(getPath(key).c_str());
+    }
+}
+
+} // namespace sb
@@ -0,0 +1,145 @@
+#include <sandbox/rendering/quadBatch.h>
+#include <sandbox/rendering/camera.h>
+#include <sandbox/rendering/shader.h>
+#include <sandbox/rendering/texture.h>
+
+#include <sandbox/resources/resourceMgr.h>
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/misc.h>
+
+namespace sb {
+namespace {
+
+const size_t VERTICES_PER_QUAD = 4;
+const size_t INDICES_PER_QUAD = 6;
+const size_t INITIAL_CAPACITY_QUADS = 1024;
+
+std::vector<uint32_t> makeQuadIndices(size_t numQuads)
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(numQuads * INDICES_PER_QUAD);
+
+    for (size_t i = 0; i < numQuads; ++i) {
+        uint32_t base = (uint32_t)(i * VERTICES_PER_QUAD);
+
+        indices.push_back(base);
+        indices.push_back(base + 2);
+        indices.push_back(base + 1);
+        indices.push_back(base + 1);
+        indices.push_back(base + 2);
+        indices.push_back(base + 3);
+    }
+
+    return indices;
+}
+
+} // namespace
+
+QuadBatch::QuadBatch():
+    mPages(),
+    mShader(gResourceMgr.getBatch2DShader()),
+    mVertexBuffer(),
+    mIndexBuffer(),
+    mIndexCapacityQuads(0),
+    mPositions(),
+    mTexcoords(),
+    mColors()
+{
+    mVertexBuffer.reset(new VertexBuffer({ Vec3() }, { Vec2() }, { Color() }, {}));
+    reserveQuads(INITIAL_CAPACITY_QUADS);
+}
+
+void QuadBatch::reserveQuads(size_t numQuads)
+{
+    if (numQuads <= mIndexCapacityQuads) {
+        return;
+    }
+
+    while (mIndexCapacityQuads < numQuads) {
+        mIndexCapacityQuads = std::max(mIndexCapacityQuads * 2,
+                                       INITIAL_CAPACITY_QUADS);
+    }
+
+    mIndexBuffer.reset(new IndexBuffer(makeQuadIndices(mIndexCapacityQuads)));
+}
+
+QuadBatch::Page& QuadBatch::getPage(const std::shared_ptr<const Texture>& texture)
+{
+    for (Page& page: mPages) {
+        if (page.texture == texture) {
+            return page;
+        }
+    }
+
+    mPages.push_back({ texture, {}, {}, {} });
+    return mPages.back();
+}
+
+void QuadBatch::add(const std::shared_ptr<const Texture>& texture,
+                    const Positions& positions,
+                    const Texcoords& texcoords,
+                    const Color& color)
+{
+    Page& page = getPage(texture);
+
+    page.positions.insert(page.positions.end(), positions.begin(), positions.end());
+    page.texcoords.insert(page.texcoords.end(), texcoords.begin(), texcoords.end());
+    page.colors.insert(page.colors.end(), VERTICES_PER_QUAD, color);
+}
+
+void QuadBatch::flush(Camera& camera)
+{
+    mPositions.clear();
+    mTexcoords.clear();
+    mColors.clear();
+    for (const Page& page: mPages) {
+        mPositions.insert(mPositions.end(),
+                          page.positions.begin(), page.positions.end());
+        mTexcoords.insert(mTexcoords.end(),
+                          page.texcoords.begin(), page.texcoords.end());
+        mColors.insert(mColors.end(),
+                       page.colors.begin(), page.colors.end());
+    }
+
+    if (mPositions.empty()) {
+        return;
+    }
+
+    reserveQuads(mPositions.size() / VERTICES_PER_QUAD);
+
+    mVertexBuffer->update(Attrib::Kind::Position, &mPositions[0], mPositions.size());
+    mVertexBuffer->update(Attrib::Kind::Texcoord, &mTexcoords[0], mTexcoords.size());
+    mVertexBuffer->update(Attrib::Kind::Color, &mColors[0], mColors.size());
+
+    auto vaoBind = make_bind(*mVertexBuffer);
+    auto indexBind = make_bind(*mIndexBuffer);
+    auto shaderBind = make_bind(*mShader, *mVertexBuffer);
+
+    mShader->setUniform("matViewProjection", camera.getViewProjectionMatrix());
+    mShader->setUniform("tex", (GLint)0);
+
+    size_t firstQuad = 0;
+    for (const Page& page: mPages) {
+        size_t numQuads = page.positions.size() / VERTICES_PER_QUAD;
+        if (numQuads == 0) {
+            continue;
+        }
+
+        auto texBind = make_bind(*page.texture, 0);
+        GL_CHECK(glDrawElements(GL_TRIANGLES,
+                                (GLsizei)(numQuads * INDICES_PER_QUAD),
+                                mIndexBuffer->getType(),
+                                (void*)(firstQuad * INDICES_PER_QUAD
+                                        * mIndexBuffer->getIndexSize())));
+        firstQuad += numQuads;
+    }
+
+    // keep pages and their storage around for the next frame
+    for (Page& page: mPages) {
+        page.positions.clear();
+        page.texcoords.clear();
+        page.colors.clear();
+    }
+}
+
+} // namespace sb
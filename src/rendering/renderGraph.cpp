@@ -0,0 +1,348 @@
+#include <sandbox/rendering/renderGraph.h>
+
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+
+namespace sb {
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::read(ResourceHandle resource,
+                                                         bool needsMipmaps)
+{
+    sbAssert(resource < mGraph.mResources.size(), "invalid resource handle");
+    sbAssert(resource != BACKBUFFER, "backbuffer cannot be read");
+
+    mGraph.mPasses[mPass].reads.push_back({ resource, needsMipmaps });
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::write(ResourceHandle resource)
+{
+    sbAssert(resource < mGraph.mResources.size(), "invalid resource handle");
+
+    Pass& pass = mGraph.mPasses[mPass];
+    sbAssert(pass.writes.empty(),
+             "pass %s already has a render target", pass.name.c_str());
+
+    pass.writes.push_back(resource);
+    return *this;
+}
+
+RenderGraph::PassBuilder& RenderGraph::PassBuilder::sideEffect()
+{
+    mGraph.mPasses[mPass].hasSideEffects = true;
+    return *this;
+}
+
+RenderGraph::RenderGraph():
+    mResources(),
+    mPasses(),
+    mPool()
+{
+    reset();
+}
+
+RenderGraph::ResourceHandle
+RenderGraph::import(const std::string& name,
+                    const std::shared_ptr<Framebuffer>& framebuffer,
+                    Framebuffer::Attachments attachments)
+{
+    sbAssert(framebuffer, "cannot import null framebuffer %s", name.c_str());
+
+    mResources.push_back({
+        name, framebuffer->getSize(), attachments, framebuffer, true, false
+    });
+    return mResources.size() - 1;
+}
+
+RenderGraph::ResourceHandle
+RenderGraph::createTarget(const std::string& name,
+                          const Vec2i& size,
+                          Framebuffer::Attachments attachments)
+{
+    mResources.push_back({ name, size, attachments, nullptr, false, false });
+    return mResources.size() - 1;
+}
+
+RenderGraph::PassBuilder RenderGraph::addPass(const std::string& name,
+                                              ExecuteFunc execute)
+{
+    mPasses.push_back({ name, execute, {}, {}, false });
+    return PassBuilder(*this, mPasses.size() - 1);
+}
+
+const Framebuffer& RenderGraph::getFramebuffer(ResourceHandle resource) const
+{
+    sbAssert(resource < mResources.size(), "invalid resource handle");
+    sbAssert(mResources[resource].framebuffer,
+             "%s has no framebuffer assigned", mResources[resource].name.c_str());
+
+    return *mResources[resource].framebuffer;
+}
+
+bool RenderGraph::writes(const Pass& pass, ResourceHandle resource) const
+{
+    return std::find(pass.writes.begin(), pass.writes.end(), resource)
+            != pass.writes.end();
+}
+
+bool RenderGraph::reads(const Pass& pass, ResourceHandle resource) const
+{
+    return std::find_if(pass.reads.begin(), pass.reads.end(),
+                        [resource](const Read& r) {
+                            return r.resource == resource;
+                        }) != pass.reads.end();
+}
+
+// deps[i] - passes that have to run before pass i: writers of what it reads,
+// and earlier users of what it writes
+std::vector<std::vector<size_t>> RenderGraph::findDependencies() const
+{
+    std::vector<std::vector<size_t>> deps(mPasses.size());
+
+    for (size_t i = 0; i < mPasses.size(); ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            bool dependsOn = false;
+
+            for (const Read& r: mPasses[i].reads) {
+                dependsOn = dependsOn || writes(mPasses[j], r.resource);
+            }
+            for (ResourceHandle w: mPasses[i].writes) {
+                dependsOn = dependsOn
+                            || writes(mPasses[j], w)
+                            || reads(mPasses[j], w);
+            }
+
+            if (dependsOn) {
+                deps[i].push_back(j);
+            }
+        }
+    }
+
+    return deps;
+}
+
+std::vector<bool>
+RenderGraph::cull(const std::vector<std::vector<size_t>>& deps) const
+{
+    std::vector<bool> needed(mPasses.size(), false);
+    std::vector<size_t> toVisit;
+
+    for (size_t i = 0; i < mPasses.size(); ++i) {
+        if (mPasses[i].hasSideEffects || writes(mPasses[i], BACKBUFFER)) {
+            needed[i] = true;
+            toVisit.push_back(i);
+        }
+    }
+
+    while (!toVisit.empty()) {
+        size_t pass = toVisit.back();
+        toVisit.pop_back();
+
+        for (size_t dep: deps[pass]) {
+            if (!needed[dep]) {
+                needed[dep] = true;
+                toVisit.push_back(dep);
+            }
+        }
+    }
+
+    return needed;
+}
+
+// topological order; among passes ready to run, prefer the one rendering
+// into the currently bound target to avoid a framebuffer switch
+std::vector<size_t>
+RenderGraph::order(const std::vector<std::vector<size_t>>& deps,
+                   const std::vector<bool>& needed) const
+{
+    std::vector<size_t> result;
+    std::vector<bool> done(mPasses.size(), false);
+    ResourceHandle boundTarget = BACKBUFFER;
+
+    size_t numNeeded = std::count(needed.begin(), needed.end(), true);
+    while (result.size() < numNeeded) {
+        size_t next = mPasses.size();
+
+        for (size_t i = 0; i < mPasses.size(); ++i) {
+            if (!needed[i] || done[i]) {
+                continue;
+            }
+
+            bool ready = std::all_of(deps[i].begin(), deps[i].end(),
+                                     [&done](size_t dep) { return done[dep]; });
+            if (!ready) {
+                continue;
+            }
+
+            if (next == mPasses.size()) {
+                next = i;
+            }
+            if (writes(mPasses[i], boundTarget)) {
+                next = i;
+                break;
+            }
+        }
+
+        sbAssert(next < mPasses.size(), "cycle in render graph");
+
+        done[next] = true;
+        result.push_back(next);
+        if (!mPasses[next].writes.empty()) {
+            boundTarget = mPasses[next].writes.front();
+        }
+    }
+
+    return result;
+}
+
+std::shared_ptr<Framebuffer> RenderGraph::acquire(const Resource& resource)
+{
+    for (PooledTarget& target: mPool) {
+        if (!target.inUse
+                && target.attachments == resource.attachments
+                && target.framebuffer->getSize() == resource.size) {
+            target.inUse = true;
+            target.usedThisFrame = true;
+            return target.framebuffer;
+        }
+    }
+
+    gLog.trace("render graph: creating %dx%d target for %s",
+               resource.size.x, resource.size.y, resource.name.c_str());
+
+    auto framebuffer = std::make_shared<Framebuffer>(resource.size.x,
+                                                     resource.size.y,
+                                                     resource.attachments);
+    mPool.push_back({ framebuffer, resource.attachments, true, true, 0 });
+    return framebuffer;
+}
+
+void RenderGraph::release(const std::shared_ptr<Framebuffer>& framebuffer)
+{
+    for (PooledTarget& target: mPool) {
+        if (target.framebuffer == framebuffer) {
+            target.inUse = false;
+            return;
+        }
+    }
+
+    sbFail("releasing framebuffer not owned by the pool");
+}
+
+void RenderGraph::trimPool()
+{
+    for (PooledTarget& target: mPool) {
+        if (target.usedThisFrame) {
+            target.unusedFrames = 0;
+        } else {
+            ++target.unusedFrames;
+        }
+        target.usedThisFrame = false;
+    }
+
+    mPool.erase(std::remove_if(mPool.begin(), mPool.end(),
+                               [](const PooledTarget& target) {
+                                   return target.unusedFrames > MAX_UNUSED_FRAMES;
+                               }),
+                mPool.end());
+}
+
+void RenderGraph::execute()
+{
+    std::vector<std::vector<size_t>> deps = findDependencies();
+    std::vector<bool> needed = cull(deps);
+    std::vector<size_t> passOrder = order(deps, needed);
+
+    // first and last position in passOrder at which each resource is used;
+    // both stay at passOrder.size() for resources no remaining pass touches
+    const size_t unused = passOrder.size();
+    std::vector<size_t> firstUse(mResources.size(), unused);
+    std::vector<size_t> lastUse(mResources.size(), unused);
+    for (size_t step = 0; step < passOrder.size(); ++step) {
+        const Pass& pass = mPasses[passOrder[step]];
+
+        auto markUse = [&](ResourceHandle resource) {
+            firstUse[resource] = std::min(firstUse[resource], step);
+            lastUse[resource] = lastUse[resource] == unused
+                                ? step
+                                : std::max(lastUse[resource], step);
+        };
+
+        for (const Read& r: pass.reads) {
+            markUse(r.resource);
+        }
+        for (ResourceHandle w: pass.writes) {
+            markUse(w);
+        }
+    }
+
+    ResourceHandle boundTarget = BACKBUFFER;
+    GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+    for (size_t step = 0; step < passOrder.size(); ++step) {
+        const Pass& pass = mPasses[passOrder[step]];
+
+        for (size_t i = 0; i < mResources.size(); ++i) {
+            if (!mResources[i].imported && firstUse[i] == step) {
+                mResources[i].framebuffer = acquire(mResources[i]);
+            }
+        }
+
+        for (const Read& r: pass.reads) {
+            Resource& resource = mResources[r.resource];
+            if (r.needsMipmaps && resource.mipmapsDirty) {
+                resource.framebuffer->generateMipmaps();
+                resource.mipmapsDirty = false;
+            }
+        }
+
+        if (!pass.writes.empty() && pass.writes.front() != boundTarget) {
+            boundTarget = pass.writes.front();
+            if (boundTarget == BACKBUFFER) {
+                GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+            } else {
+                mResources[boundTarget].framebuffer->bind();
+            }
+        }
+
+        pass.execute(*this);
+
+        for (ResourceHandle w: pass.writes) {
+            mResources[w].mipmapsDirty = true;
+        }
+
+        for (size_t i = 0; i < mResources.size(); ++i) {
+            if (!mResources[i].imported && lastUse[i] == step) {
+                release(mResources[i].framebuffer);
+                mResources[i].framebuffer.reset();
+            }
+        }
+    }
+
+    if (boundTarget != BACKBUFFER) {
+        GL_CHECK(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+    }
+
+    trimPool();
+}
+
+void RenderGraph::reset()
+{
+    mPasses.clear();
+    mResources.clear();
+    mResources.push_back({
+        "backbuffer", Vec2i(0, 0), Framebuffer::Attachments::ColorDepth,
+        nullptr, true, false
+    });
+}
+
+void RenderGraph::releaseTargets()
+{
+    reset();
+    mPool.clear();
+}
+
+} // namespace sb
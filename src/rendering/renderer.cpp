@@ -4,6 +4,8 @@
 #include <sandbox/rendering/drawable.h>
 #include <sandbox/rendering/string.h>
 #include <sandbox/rendering/sprite.h>
+#include <sandbox/rendering/staticBatch.h>
+#include <sandbox/rendering/uploadContext.h>
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/stringUtils.h>
 #include <sandbox/utils/logger.h>
@@ -11,11 +13,31 @@
 #include <sandbox/utils/debug.h>
 #include <sandbox/resources/mesh.h>
 #include <sandbox/resources/image.h>
+#include <sandbox/resources/resourceMgr.h>
 #include <sandbox/rendering/model.h>
 
 namespace sb {
 namespace {
 
+// newest first; 4.3 enables indirect multi-draws and compute shaders
+const int CONTEXT_VERSIONS[][2] = {
+    { 4, 3 },
+    { 3, 3 }
+};
+
+// time per frame spent creating GL objects of asynchronously loaded resources
+const uint64_t UPLOAD_BUDGET_MICROSECONDS = 2000;
+// mip level bytes of streamed textures copied per frame
+const size_t TEXTURE_STREAM_BUDGET_BYTES = 4 * 1024 * 1024;
+
+bool gContextCreationFailed = false;
+
+int onContextCreationError(::Display*, XErrorEvent*)
+{
+    gContextCreationFailed = true;
+    return 0;
+}
+
 void printGLVersion() {
     int versionMajor = 0;
     int versionMinor = 0;
@@ -61,18 +83,38 @@ bool Renderer::initGLEW()
 
 Renderer::Renderer():
     mClearColor(Color::Black),
+    mViewportSize(0, 0),
     mCamera(Camera::perspective()),
     mSpriteCamera(Camera::orthographic()),
     mGLContext(NULL),
     mDisplay(NULL),
+    mUploadContext(),
     mDrawablesBuffer(),
-    mAmbientLightColor(Color::White)
+    mSortDrawables(false),
+    mAmbientLightColor(Color::White),
+    mDynamicResolution(),
+    mRenderGraph(),
+    mDebugDraw(),
+    mTextBatch(),
+    mSpriteBatch(),
+    mStaticBatch()
 {
 }
 
 Renderer::~Renderer()
 {
-    // let's free everything before deleting gl context
+    // let's free everything before deleting gl context; detaching the
+    // upload context first runs completions of jobs still in flight
+    if (mUploadContext) {
+        gResourceMgr.setUploadContext(nullptr);
+        mUploadContext.reset();
+    }
+    mDynamicResolution.reset();
+    mRenderGraph.releaseTargets();
+    mDebugDraw.reset();
+    mTextBatch.reset();
+    mSpriteBatch.reset();
+    mStaticBatch.reset();
     gResourceMgr.freeAll();
 
     glXMakeCurrent(mDisplay, 0, 0);
@@ -95,12 +137,6 @@ bool Renderer::init(::Display* display, ::Window window, GLXFBConfig& fbc)
     mDisplay = display;
 
     gLog.info("creating GL context...\n");
-    int contextAttribs[] = {
-        GLX_CONTEXT_MAJOR_VERSION_ARB, 3,
-        GLX_CONTEXT_MINOR_VERSION_ARB, 3,
-        GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
-        0
-    };
 
     GLXCREATECTXATTRSARBPROC glXCreateContextAttribsARB = (GLXCREATECTXATTRSARBPROC)glXGetProcAddress((GLubyte*)"glXCreateContextAttribsARB");
     if (!glXCreateContextAttribsARB) {
@@ -108,7 +144,38 @@ bool Renderer::init(::Display* display, ::Window window, GLXFBConfig& fbc)
         return false;
     }
 
-    GL_CHECK(mGLContext = glXCreateContextAttribsARB(mDisplay, fbc, 0, True, contextAttribs));
+    // unsupported versions fail with an X error, which would otherwise
+    // terminate the program
+    int (*prevErrorHandler)(::Display*, XErrorEvent*) =
+            XSetErrorHandler(onContextCreationError);
+
+    const int* contextVersion = nullptr;
+    for (const int* version: CONTEXT_VERSIONS) {
+        int contextAttribs[] = {
+            GLX_CONTEXT_MAJOR_VERSION_ARB, version[0],
+            GLX_CONTEXT_MINOR_VERSION_ARB, version[1],
+            GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+            0
+        };
+
+        gContextCreationFailed = false;
+        mGLContext = glXCreateContextAttribsARB(mDisplay, fbc, 0, True, contextAttribs);
+        XSync(mDisplay, False);
+
+        if (mGLContext && !gContextCreationFailed) {
+            contextVersion = version;
+            break;
+        }
+
+        gLog.info("GL %d.%d context not available\n", version[0], version[1]);
+        if (mGLContext) {
+            glXDestroyContext(mDisplay, mGLContext);
+            mGLContext = NULL;
+        }
+    }
+
+    XSetErrorHandler(prevErrorHandler);
+
     if (!mGLContext) {
         gLog.err("glXCreateContextAttribsARB failed\n");
         return false;
@@ -130,6 +197,16 @@ bool Renderer::init(::Display* display, ::Window window, GLXFBConfig& fbc)
     GL_CHECK(glEnable(GL_BLEND));
     GL_CHECK(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
+    // sync objects are core since 3.2, so any context created above has them
+    mUploadContext.reset(new UploadContext(mDisplay, fbc, mGLContext,
+                                           contextVersion[0],
+                                           contextVersion[1]));
+    if (mUploadContext->isValid()) {
+        gResourceMgr.setUploadContext(mUploadContext.get());
+    } else {
+        mUploadContext.reset();
+    }
+
 #if 0
     GL_CHECK(glEnable(GL_TEXTURE_2D));
 
@@ -152,7 +229,9 @@ void Renderer::clear() const
 void Renderer::setViewport(unsigned x, unsigned y, unsigned cx, unsigned cy)
 {
     //gLog.debug("setViewport: %u %u %u %u", x, y, cx, cy);
-    mViewport = IntRect(x, x + cx, y, y + cy);
+    // the (left, right, bottom, top) constructor swaps axes
+    mViewport = IntRect(Vec2i((int)x, (int)y), Vec2i((int)cx, (int)cy));
+    mViewportSize = Vec2i(cx, cy);
     glViewport(x, y, cx, cy);
 
     // adjust aspect ratio
@@ -160,6 +239,12 @@ void Renderer::setViewport(unsigned x, unsigned y, unsigned cx, unsigned cy)
     mSpriteCamera.updateViewport(cx, cy);
 }
 
+void Renderer::restoreViewport() const
+{
+    GL_CHECK(glViewport(mViewport.left, mViewport.bottom,
+                        mViewport.width(), mViewport.height()));
+}
+
 void Renderer::setViewport(const IntRect& rect)
 {
     return setViewport(rect.left, rect.bottom, rect.width(), rect.height());
@@ -174,10 +259,8 @@ void Renderer::draw(Drawable& d)
     mDrawablesBuffer.push_back(std::make_shared<Drawable>(d));
 }
 
-void Renderer::drawTo(Framebuffer& framebuffer,
-                      Camera& camera) const
+void Renderer::drawShadowMap(Camera& camera) const
 {
-    auto fbBind = make_bind(framebuffer);
     GL_CHECK(glClearColor(1.0f, 1.0f, 1.0f, 1.0f));
     clear();
 
@@ -185,28 +268,115 @@ void Renderer::drawTo(Framebuffer& framebuffer,
     rendererState.isRenderingShadow = true;
     rendererState.projectionType = ProjectionType::Orthographic; // TODO
 
+    drawStaticBatch(rendererState);
     for (const std::shared_ptr<Drawable>& d: mDrawablesBuffer) {
         d->draw(rendererState);
     }
 }
 
+void Renderer::drawStaticBatch(State& rendererState) const
+{
+    if (mStaticBatch) {
+        mStaticBatch->draw(rendererState);
+    }
+}
+
+void Renderer::drawProjected(State& rendererState,
+                             ProjectionType projectionType)
+{
+    rendererState.camera = projectionType == ProjectionType::Perspective
+                           ? &mCamera
+                           : &mSpriteCamera;
+
+    for (const std::shared_ptr<Drawable>& d: mDrawablesBuffer) {
+        if (d->mProjectionType == projectionType) {
+            d->draw(rendererState);
+        }
+    }
+}
+
+void Renderer::flushDebugDraw()
+{
+    if (mDebugDraw) {
+        mDebugDraw->flush(mCamera);
+    }
+}
+
+void Renderer::flushHudBatches()
+{
+    if (mSpriteBatch) {
+        mSpriteBatch->flush(mSpriteCamera);
+    }
+    if (mTextBatch) {
+        mTextBatch->flush(mSpriteCamera);
+    }
+}
+
+TextBatch& Renderer::getTextBatch()
+{
+    if (!mTextBatch) {
+        mTextBatch.reset(new TextBatch());
+    }
+
+    return *mTextBatch;
+}
+
+StaticBatch& Renderer::getStaticBatch()
+{
+    if (!mStaticBatch) {
+        mStaticBatch.reset(new StaticBatch());
+    }
+
+    return *mStaticBatch;
+}
+
+SpriteBatch& Renderer::getSpriteBatch()
+{
+    if (!mSpriteBatch) {
+        mSpriteBatch.reset(new SpriteBatch());
+    }
+
+    return *mSpriteBatch;
+}
+
+DebugDraw& Renderer::getDebugDraw()
+{
+    if (!mDebugDraw) {
+        mDebugDraw.reset(new DebugDraw());
+    }
+
+    return *mDebugDraw;
+}
+
 void Renderer::drawAll()
 {
-    if (mDrawablesBuffer.size() == 0) {
+    gResourceMgr.pollShaders();
+    gResourceMgr.processUploads(UPLOAD_BUDGET_MICROSECONDS);
+    gResourceMgr.streamTextures(TEXTURE_STREAM_BUDGET_BYTES);
+
+    if (mDrawablesBuffer.size() == 0 && !mDebugDraw && !mTextBatch
+            && !mSpriteBatch && !mStaticBatch) {
         return;
     }
 
-#if 0
-    std::sort(mDrawablesBuffer.begin(), mDrawablesBuffer.end(),
-              [](const std::shared_ptr<Drawable>& a,
-                 const std::shared_ptr<Drawable>& b) {
-                  return *a < *b;
-              });
-#endif
+    if (mSortDrawables) {
+        std::stable_sort(mDrawablesBuffer.begin(), mDrawablesBuffer.end(),
+                         [](const std::shared_ptr<Drawable>& a,
+                            const std::shared_ptr<Drawable>& b) {
+                             return *a < *b;
+                         });
+    }
+    if (mDynamicResolution) {
+        mDynamicResolution->beginFrame();
+    }
+
     State rendererState(mCamera,
                         mAmbientLightColor,
                         mLights);
 
+    mRenderGraph.reset();
+    std::vector<RenderGraph::ResourceHandle> shadowMaps;
+
     for (const Light& light: mLights) {
         if (light.makesShadows) {
             sbAssert(light.type == Light::Type::Parallel, "TODO: shadows for point lights");
@@ -214,12 +384,17 @@ void Renderer::drawAll()
             Camera camera = Camera::orthographic(-100.0, 100.0, -100.0, 100.0, -1000.0, 1000.0);
             camera.lookAt(-light.pos, Vec3(0.0, 0.0, 0.0));
 
-            IntRect savedViewport = mViewport;
-            Vec2i shadowFbSize = light.shadowFramebuffer->getSize();
-            setViewport(0, 0, shadowFbSize.x, shadowFbSize.y);
+            RenderGraph::ResourceHandle shadowMap =
+                    mRenderGraph.import("shadow map", light.shadowFramebuffer,
+                                        Framebuffer::Attachments::Depth);
+            shadowMaps.push_back(shadowMap);
 
-            drawTo(*light.shadowFramebuffer, camera);
-            setViewport(savedViewport);
+            Vec2i shadowFbSize = light.shadowFramebuffer->getSize();
+            mRenderGraph.addPass("shadow", [this, camera, shadowFbSize](const RenderGraph&) mutable {
+                GL_CHECK(glViewport(0, 0, shadowFbSize.x, shadowFbSize.y));
+                drawShadowMap(camera);
+                restoreViewport();
+            }).write(shadowMap);
 
             rendererState.shadows.push_back({
                 light.shadowFramebuffer->getTexture(),
@@ -228,18 +403,88 @@ void Renderer::drawAll()
         }
     }
 
-    GL_CHECK(glClearColor(mClearColor.r, mClearColor.g,
-                          mClearColor.b, mClearColor.a));
-    clear();
+    gResourceMgr.setLightFeatures(ShaderFeatures {
+        { "POINT_LIGHTS", (int)rendererState.pointLights.size() },
+        { "PARALLEL_LIGHTS", (int)rendererState.parallelLights.size() },
+        { "SHADOWS", (int)rendererState.shadows.size() }
+    });
+
+    RenderGraph::ResourceHandle backbuffer = mRenderGraph.getBackbuffer();
+
+    if (mDynamicResolution) {
+        RenderGraph::ResourceHandle scene =
+                mRenderGraph.createTarget("scene", mViewportSize,
+                                          Framebuffer::Attachments::ColorDepth);
+
+        RenderGraph::PassBuilder scenePass =
+                mRenderGraph.addPass("scene", [this, &rendererState](const RenderGraph&) {
+            Vec2i scaledSize = mDynamicResolution->getScaledSize(mViewportSize);
+            // cameras keep the full-size aspect ratio, only the raster shrinks
+            GL_CHECK(glViewport(0, 0, scaledSize.x, scaledSize.y));
+            GL_CHECK(glClearColor(mClearColor.r, mClearColor.g,
+                                  mClearColor.b, mClearColor.a));
+            clear();
+            rendererState.camera = &mCamera;
+            drawStaticBatch(rendererState);
+            drawProjected(rendererState, ProjectionType::Perspective);
+            flushDebugDraw();
+            restoreViewport();
+        });
+        for (RenderGraph::ResourceHandle shadowMap: shadowMaps) {
+            scenePass.read(shadowMap, true);
+        }
+        scenePass.write(scene);
+
+        mRenderGraph.addPass("upscale", [this, scene](const RenderGraph& graph) {
+            mDynamicResolution->blit(graph.getFramebuffer(scene), mViewport);
+            GL_CHECK(glClear(GL_DEPTH_BUFFER_BIT));
+        }).read(scene).write(backbuffer);
+
+        mRenderGraph.addPass("hud", [this, &rendererState](const RenderGraph&) {
+            drawProjected(rendererState, ProjectionType::Orthographic);
+            flushHudBatches();
+        }).write(backbuffer);
+    } else {
+        RenderGraph::PassBuilder mainPass =
+                mRenderGraph.addPass("main", [this, &rendererState](const RenderGraph&) {
+            GL_CHECK(glClearColor(mClearColor.r, mClearColor.g,
+                                  mClearColor.b, mClearColor.a));
+            clear();
 
-    for (const std::shared_ptr<Drawable>& d: mDrawablesBuffer) {
-        if (d->mProjectionType == ProjectionType::Perspective) {
             rendererState.camera = &mCamera;
-        } else {
-            rendererState.camera = &mSpriteCamera;
+            drawStaticBatch(rendererState);
+
+            // debug lines go between the 3D scene and the HUD
+            bool debugDrawFlushed = false;
+            for (const std::shared_ptr<Drawable>& d: mDrawablesBuffer) {
+                if (d->mProjectionType == ProjectionType::Perspective) {
+                    rendererState.camera = &mCamera;
+                } else {
+                    if (!debugDrawFlushed) {
+                        flushDebugDraw();
+                        debugDrawFlushed = true;
+                    }
+                    rendererState.camera = &mSpriteCamera;
+                }
+
+                d->draw(rendererState);
+            }
+
+            if (!debugDrawFlushed) {
+                flushDebugDraw();
+            }
+            flushHudBatches();
+        });
+        for (RenderGraph::ResourceHandle shadowMap: shadowMaps) {
+            mainPass.read(shadowMap, true);
         }
+        mainPass.write(backbuffer);
+    }
 
-        d->draw(rendererState);
+    mRenderGraph.execute();
+
+    if (mDynamicResolution) {
+        mDynamicResolution->endFrame();
     }
 
     mAmbientLightColor = Color::White;
@@ -247,6 +492,27 @@ void Renderer::drawAll()
     mDrawablesBuffer.clear();
 }
 
+void Renderer::enableDynamicResolution(float frameTimeBudgetMs)
+{
+    if (mDynamicResolution) {
+        mDynamicResolution->setFrameTimeBudget(frameTimeBudgetMs);
+        return;
+    }
+
+    gLog.info("dynamic resolution enabled, budget: %.2f ms", frameTimeBudgetMs);
+    mDynamicResolution.reset(new DynamicResolution(frameTimeBudgetMs));
+}
+
+void Renderer::disableDynamicResolution()
+{
+    mDynamicResolution.reset();
+}
+
+float Renderer::getResolutionScale() const
+{
+    return mDynamicResolution ? mDynamicResolution->getScale() : 1.0f;
+}
+
 void Renderer::enableFeature(Feature feature, bool enable)
 {
     if (feature == Feature::WireframeMode) {
@@ -262,6 +528,7 @@ void Renderer::enableFeature(Feature feature, bool enable)
 
 void Renderer::saveScreenshot(const std::string& filename, int width, int height)
 {
+    auto ilLock = Image::lockDevIL();
     ILuint tex;
     tex = IL_CHECK(ilGenImage());
     IL_CHECK(ilBindImage(tex));
@@ -5,6 +5,8 @@
 #include <sandbox/utils/stringUtils.h>
 #include <sandbox/utils/logger.h>
 
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <algorithm>
 
@@ -96,10 +98,27 @@ bool isInputLine(const std::string& line,
     return true;
 }
 
+// "layout(location = 0) in ..." -> "in ..."
+std::string stripLayoutQualifier(const std::string& line)
+{
+    std::string stripped = utils::strip(line);
+    if (stripped.compare(0, 6, "layout") != 0) {
+        return line;
+    }
+
+    size_t qualifierEnd = stripped.find(')');
+    if (qualifierEnd == std::string::npos) {
+        return line;
+    }
+
+    return utils::strip(stripped.substr(qualifierEnd + 1));
+}
+
 void extractInput(std::set<Input>& outInputs,
-                  const std::string& line,
+                  const std::string& rawLine,
                   bool warnOnUntagged)
 {
+    const std::string line = stripLayoutQualifier(rawLine);
     std::vector<std::string> words = utils::split(line);
 
     if (!isInputLine(line, words, warnOnUntagged)) {
@@ -157,6 +176,185 @@ void extractOutput(std::set<Output>& outOutputs,
     outOutputs.insert(Output(name, type));
 }
 
+typedef std::map<std::string, std::string> Defines;
+
+long evalValue(const std::string& text,
+               const Defines& defines,
+               bool& outOk)
+{
+    const std::string str = utils::strip(text, " \t()");
+    if (str.empty()) {
+        outOk = false;
+        return 0;
+    }
+
+    char* end;
+    long value = strtol(str.c_str(), &end, 0);
+    if (*end == '\0') {
+        return value;
+    }
+
+    // undefined identifiers are 0, like in C
+    auto it = defines.find(str);
+    if (it == defines.end()) {
+        return 0;
+    }
+
+    value = strtol(it->second.c_str(), &end, 0);
+    if (it->second.empty() || *end != '\0') {
+        outOk = false;
+    }
+    return value;
+}
+
+bool evalTerm(const std::string& text,
+              const Defines& defines,
+              bool& outOk)
+{
+    const std::string term = utils::strip(text);
+    if (!term.empty() && term[0] == '!' && term.compare(0, 2, "!=") != 0) {
+        return !evalTerm(term.substr(1), defines, outOk);
+    }
+    if (term.compare(0, 7, "defined") == 0) {
+        return defines.count(utils::strip(term.substr(7), " \t()")) > 0;
+    }
+
+    static const char* const OPERATORS[] = { "==", "!=", ">=", "<=", ">", "<" };
+    for (const char* op: OPERATORS) {
+        size_t pos = term.find(op);
+        if (pos == std::string::npos) {
+            continue;
+        }
+
+        long lhs = evalValue(term.substr(0, pos), defines, outOk);
+        long rhs = evalValue(term.substr(pos + strlen(op)), defines, outOk);
+        switch (op[0]) {
+        case '=': return lhs == rhs;
+        case '!': return lhs != rhs;
+        case '>': return op[1] == '=' ? lhs >= rhs : lhs > rhs;
+        case '<': return op[1] == '=' ? lhs <= rhs : lhs < rhs;
+        }
+    }
+
+    return evalValue(term, defines, outOk) != 0;
+}
+
+// Handles NAME, defined(NAME), NAME <op> INT and literals, optionally
+// negated and joined with && or ||. Anything fancier is assumed true, so
+// that declarations inside are seen rather than lost.
+bool evalCondition(const std::string& expr,
+                   const Defines& defines)
+{
+    bool ok = true;
+    bool result = false;
+    for (const std::string& alternative: utils::split(expr, "||")) {
+        bool all = true;
+        for (const std::string& term: utils::split(alternative, "&&")) {
+            all = evalTerm(term, defines, ok) && all;
+        }
+        result = result || all;
+    }
+
+    return ok ? result : true;
+}
+
+// removes lines excluded by #if/#ifdef/#ifndef, so that parsing only finds
+// declarations that make it into given permutation of the shader
+std::string stripInactiveCode(const std::string& code)
+{
+    struct Branch
+    {
+        bool parentActive;
+        bool taken;
+        bool active;
+    };
+
+    Defines defines;
+    std::vector<Branch> branches;
+    std::string ret;
+
+    for (const std::string& line: utils::split(code, "\n")) {
+        const bool active = branches.empty() || branches.back().active;
+        const std::string stripped = utils::strip(line);
+        if (stripped.empty() || stripped[0] != '#') {
+            if (active) {
+                ret += line + "\n";
+            }
+            continue;
+        }
+
+        std::string directive = utils::strip(stripped.substr(1));
+        directive = utils::strip(directive.substr(0, directive.find("//")));
+        const size_t keywordEnd = directive.find_first_of(" \t(");
+        const std::string keyword = directive.substr(0, keywordEnd);
+        const std::string arg = keywordEnd == std::string::npos
+                                ? ""
+                                : utils::strip(directive.substr(keywordEnd));
+
+        if (keyword == "if" || keyword == "ifdef" || keyword == "ifndef") {
+            bool cond = keyword == "if"
+                        ? evalCondition(arg, defines)
+                        : (defines.count(arg) > 0) == (keyword == "ifdef");
+            branches.push_back({ active, active && cond, active && cond });
+        } else if (keyword == "elif" && !branches.empty()) {
+            Branch& branch = branches.back();
+            branch.active = branch.parentActive && !branch.taken
+                            && evalCondition(arg, defines);
+            branch.taken = branch.taken || branch.active;
+        } else if (keyword == "else" && !branches.empty()) {
+            Branch& branch = branches.back();
+            branch.active = branch.parentActive && !branch.taken;
+            branch.taken = true;
+        } else if (keyword == "endif" && !branches.empty()) {
+            branches.pop_back();
+        } else if (active) {
+            if (keyword == "define") {
+                const size_t nameEnd = arg.find_first_of(" \t(");
+                defines[arg.substr(0, nameEnd)] =
+                        nameEnd == std::string::npos
+                        ? "" : utils::strip(arg.substr(nameEnd));
+            } else if (keyword == "undef") {
+                defines.erase(arg);
+            }
+            ret += line + "\n";
+        }
+    }
+
+    return ret;
+}
+
+bool isIdentifierChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+// compilation and linking run on driver threads, and their status can be
+// queried without blocking
+bool hasParallelShaderCompile()
+{
+    return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+bool isLinkCompleted(ProgramId program)
+{
+    if (!hasParallelShaderCompile()) {
+        return true;
+    }
+
+    GLint completed = GL_FALSE;
+    GL_CHECK(glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed == GL_TRUE;
+}
+
+uint32_t getInputMask(const std::map<Attrib::Kind, Input>& inputs)
+{
+    uint32_t mask = 0;
+    for (const auto& kindInput: inputs) {
+        mask |= Attrib::getMask(kindInput.first);
+    }
+    return mask;
+}
+
 void detectOptimizedOutUniforms(GLuint program,
                                 std::set<Uniform>& uniforms)
 {
@@ -229,7 +427,86 @@ std::set<Uniform> ConcreteShader::parseUniforms(const std::string& code)
     return ret;
 }
 
-bool ConcreteShader::shaderCompilationSucceeded(const std::string& source)
+void ConcreteShader::submit() const
+{
+    if (mShader) {
+        return;
+    }
+
+    static std::map<GLuint, std::string> SHADERS {
+        { GL_VERTEX_SHADER, "vertex" },
+        { GL_FRAGMENT_SHADER, "fragment" },
+        { GL_GEOMETRY_SHADER, "geometry" },
+        { GL_COMPUTE_SHADER, "compute" }
+    };
+
+    GL_CHECK(mShader = glCreateShader(mShaderType));
+
+    const GLchar* codePtr = (const GLchar*)&mCode[0];
+    GL_CHECK(glShaderSource(mShader, 1, &codePtr, NULL));
+
+    gLog.trace("compiling %s shader: %s",
+               SHADERS[mShaderType].c_str(), mFilename.c_str());
+    GL_CHECK(glCompileShader(mShader));
+}
+
+bool ConcreteShader::isCompiled() const
+{
+    if (!mShader) {
+        return false;
+    }
+    if (!hasParallelShaderCompile()) {
+        return true;
+    }
+
+    GLint completed = GL_FALSE;
+    GL_CHECK(glGetShaderiv(mShader, GL_COMPLETION_STATUS_KHR, &completed));
+    return completed == GL_TRUE;
+}
+
+GLuint ConcreteShader::getShader() const
+{
+    submit();
+
+    if (!mStatusChecked) {
+        if (!shaderCompilationSucceeded(mCode)) {
+            sbFail("shader compilation failed");
+        }
+        mStatusChecked = true;
+    }
+
+    return mShader;
+}
+
+void ConcreteShader::parse() const
+{
+    if (mParsed) {
+        return;
+    }
+
+    const std::string activeCode = stripInactiveCode(mCode);
+    mInputs = parseInputs(activeCode, mShaderType == GL_VERTEX_SHADER);
+    mOutputs = parseOutputs(activeCode);
+    mUniforms = parseUniforms(activeCode);
+    mParsed = true;
+}
+
+bool ConcreteShader::references(const std::string& identifier) const
+{
+    for (size_t pos = mCode.find(identifier);
+            pos != std::string::npos;
+            pos = mCode.find(identifier, pos + 1)) {
+        const size_t end = pos + identifier.size();
+        if ((pos == 0 || !isIdentifierChar(mCode[pos - 1]))
+                && (end == mCode.size() || !isIdentifierChar(mCode[end]))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ConcreteShader::shaderCompilationSucceeded(const std::string& source) const
 {
     GLint retval;
     GL_CHECK_RET(glGetShaderiv(mShader, GL_COMPILE_STATUS, &retval), false);
@@ -311,10 +588,89 @@ void checkInputOutputCompatbility(
 Shader::Shader(const std::shared_ptr<ConcreteShader>& vertex,
                const std::shared_ptr<ConcreteShader>& fragment,
                const std::shared_ptr<ConcreteShader>& geometry):
-    mProgram(linkShader(vertex, fragment, geometry)),
+    mProgram(0),
+    mFilenames(),
+    mInputs(),
+    mInputMask(0),
+    mUniforms(),
+    mPending()
+{
+    finishLink(vertex, fragment, geometry,
+               linkShader(vertex, fragment, geometry));
+}
+
+Shader::Shader(const std::shared_ptr<ConcreteShader>& vertex,
+               const std::shared_ptr<ConcreteShader>& fragment,
+               const std::shared_ptr<ConcreteShader>& geometry,
+               const std::shared_ptr<Shader>& placeholder):
+    mProgram(0),
     mFilenames({ vertex->getFilename(), fragment->getFilename() }),
-    mInputs(vertex->makeInputsMap())
+    mInputs(),
+    mInputMask(0),
+    mUniforms(),
+    mPending(new PendingLink { vertex, fragment, geometry, placeholder, 0 })
+{
+    vertex->submit();
+    fragment->submit();
+    if (geometry) {
+        geometry->submit();
+    }
+}
+
+bool Shader::poll()
+{
+    return advance(false);
+}
+
+void Shader::wait()
+{
+    advance(true);
+}
+
+bool Shader::advance(bool block)
+{
+    if (!mPending) {
+        return true;
+    }
+
+    PendingLink& pending = *mPending;
+    if (!pending.program) {
+        bool compiled = pending.vertex->isCompiled()
+                        && pending.fragment->isCompiled()
+                        && (!pending.geometry || pending.geometry->isCompiled());
+        if (!compiled && !block) {
+            return false;
+        }
+
+        pending.program = startLink(pending.vertex, pending.fragment,
+                                    pending.geometry);
+    }
+
+    if (!block && !isLinkCompleted(pending.program)) {
+        return false;
+    }
+
+    if (!shaderLinkSucceeded(pending.program)) {
+        sbFail("shader link failed: %s", getName().c_str());
+    }
+
+    std::unique_ptr<PendingLink> done(std::move(mPending));
+    finishLink(done->vertex, done->fragment, done->geometry, done->program);
+    gLog.trace("shader ready: %s", getName().c_str());
+    return true;
+}
+
+void Shader::finishLink(const std::shared_ptr<ConcreteShader>& vertex,
+                        const std::shared_ptr<ConcreteShader>& fragment,
+                        const std::shared_ptr<ConcreteShader>& geometry,
+                        ProgramId program)
 {
+    mProgram = program;
+    mFilenames = { vertex->getFilename(), fragment->getFilename() };
+    mInputs = vertex->makeInputsMap();
+    mInputMask = getInputMask(mInputs);
+    mUniforms.clear();
+
     checkInputOutputCompatbility(vertex, fragment, geometry);
 
     for (const Uniform& uniform: vertex->getUniforms()) {
@@ -334,9 +690,95 @@ Shader::Shader(const std::shared_ptr<ConcreteShader>& vertex,
     detectOptimizedOutUniforms(mProgram, mUniforms);
 }
 
+Shader::Shader(const std::shared_ptr<ConcreteShader>& compute):
+    // linkShader attaches whatever stages it gets
+    mProgram(linkShader(compute, nullptr, nullptr)),
+    mFilenames({ compute->getFilename() }),
+    mInputs(),
+    mInputMask(0),
+    mUniforms(compute->getUniforms()),
+    mPending()
+{
+    detectOptimizedOutUniforms(mProgram, mUniforms);
+}
+
+Shader::Shader(ProgramId program,
+               const std::vector<std::string>& filenames,
+               const std::map<Attrib::Kind, Input>& inputs,
+               const std::set<Uniform>& uniforms):
+    mProgram(program),
+    mFilenames(filenames),
+    mInputs(inputs),
+    mInputMask(getInputMask(inputs)),
+    mUniforms(uniforms),
+    mPending()
+{}
+
+ProgramId Shader::loadBinary(GLenum format,
+                             const std::vector<uint8_t>& binary)
+{
+    if (binary.empty()) {
+        return 0;
+    }
+
+    ProgramId id;
+    GL_CHECK(id = glCreateProgram());
+    if (!id) {
+        return 0;
+    }
+
+    // a binary from an incompatible driver is not an error, just a miss
+    glProgramBinary(id, format, &binary[0], (GLsizei)binary.size());
+    glGetError();
+
+    GLint linked = GL_FALSE;
+    GL_CHECK(glGetProgramiv(id, GL_LINK_STATUS, &linked));
+    if (linked != GL_TRUE) {
+        GL_CHECK(glDeleteProgram(id));
+        return 0;
+    }
+
+    return id;
+}
+
+bool Shader::getBinary(GLenum& outFormat,
+                       std::vector<uint8_t>& outBinary) const
+{
+    if (!GLEW_ARB_get_program_binary || mPending) {
+        return false;
+    }
+
+    GLint length = 0;
+    GL_CHECK(glGetProgramiv(mProgram, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0) {
+        return false;
+    }
+
+    outBinary.resize(length);
+    GLsizei written = 0;
+    GL_CHECK(glGetProgramBinary(mProgram, length, &written,
+                                &outFormat, &outBinary[0]));
+    outBinary.resize(written);
+    return written > 0;
+}
+
 ProgramId Shader::linkShader(const std::shared_ptr<ConcreteShader>& vertex,
                              const std::shared_ptr<ConcreteShader>& fragment,
                              const std::shared_ptr<ConcreteShader>& geometry)
+{
+    ProgramId id = startLink(vertex, fragment, geometry);
+
+    if (id && !shaderLinkSucceeded(id)) {
+        sbFail("shader link failed");
+        return 0;
+    }
+
+    return id;
+}
+
+ProgramId Shader::startLink(const std::shared_ptr<ConcreteShader>& vertex,
+                            const std::shared_ptr<ConcreteShader>& fragment,
+                            const std::shared_ptr<ConcreteShader>& geometry)
 {
     ProgramId id;
     GL_CHECK(id = glCreateProgram());
@@ -354,14 +796,25 @@ ProgramId Shader::linkShader(const std::shared_ptr<ConcreteShader>& vertex,
         GL_CHECK(glAttachShader(id, geometry->getShader()));
     }
 
-    gLog.trace("linking shader program...");
-    GL_CHECK(glLinkProgram(id));
+    // only takes effect on link; explicit layout(location) wins, so
+    // built-in shaders have to use the same locations
+    if (vertex && vertex->getType() == GL_VERTEX_SHADER) {
+        for (const Input& input: vertex->getInputs()) {
+            if (input.kind != Attrib::Kind::Unspecified) {
+                GL_CHECK(glBindAttribLocation(id, Attrib::getLocation(input.kind),
+                                              input.name.c_str()));
+            }
+        }
+    }
 
-    if (!shaderLinkSucceeded(id)) {
-        sbFail("shader link failed");
-        return 0;
+    if (GLEW_ARB_get_program_binary) {
+        GL_CHECK(glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                     GL_TRUE));
     }
 
+    gLog.trace("linking shader program...");
+    GL_CHECK(glLinkProgram(id));
+
     return id;
 }
 
@@ -397,12 +850,17 @@ bool Shader::shaderLinkSucceeded(ProgramId program)
                             const Type* value_array, \
                             uint32_t elements) const \
     { \
-        if (!mProgram) { \
-            sbFail("invalid program: %d", (int)mProgram); \
+        const ProgramId program = getActiveProgram(); \
+        if (!program) { \
+            sbFail("invalid program: %d", (int)program); \
             return false; \
         } \
         GLint loc; \
-        GL_CHECK(loc = glGetUniformLocation(mProgram, name)); \
+        GL_CHECK(loc = glGetUniformLocation(program, name)); \
+        if (loc == -1 && mPending) { \
+            /* placeholder does not need uniforms of the real program */ \
+            return false; \
+        } \
         if (loc == -1) { \
             std::string name_str = \
                     utils::split(utils::split(name, ".")[0], "[")[0]; \
@@ -429,25 +887,18 @@ DEFINE_UNIFORM_SETTER(unsigned, GLuint, glUniform1uiv)
 
 DEFINE_UNIFORM_SETTER(Mat44, GLfloat, glUniformMatrix4fv, GL_FALSE)
 
-void Shader::bind(const VertexBuffer& vb) const
+void Shader::bind(const std::vector<Attrib::Kind>& attribs) const
 {
-    GL_CHECK(glUseProgram(mProgram));
-
-    size_t bound = 0;
-    GLuint i = 0;
-    for (const BufferKindPair& pair: vb.getBuffers()) {
-        auto inputIt = mInputs.find(pair.kind);
-
-        if (inputIt != mInputs.end()) {
-            const Input& input = inputIt->second;
-            GL_CHECK(glBindAttribLocation(mProgram, i, input.name.c_str()));
-            ++bound;
-        }
-
-        ++i;
+    if (mPending) {
+        mPending->placeholder->bind(attribs);
+        return;
     }
 
-    if (bound < mInputs.size()) {
+    GL_CHECK(glUseProgram(mProgram));
+
+    // locations are fixed per attribute kind, so a layout is compatible
+    // as long as it provides every input
+    if ((mInputMask & ~Attrib::getMask(attribs)) != 0) {
         std::vector<std::string> expected;
         std::vector<std::string> actual;
 
@@ -456,10 +907,10 @@ void Shader::bind(const VertexBuffer& vb) const
                        [](const std::pair<Attrib::Kind, Input>& p) {
                            return ATTRIBS.find(p.first)->second.kindAsString;
                        });
-        std::transform(vb.getBuffers().begin(), vb.getBuffers().end(),
+        std::transform(attribs.begin(), attribs.end(),
                        std::back_inserter(actual),
-                       [](const BufferKindPair& p) {
-                           return ATTRIBS.find(p.kind)->second.kindAsString;
+                       [](Attrib::Kind kind) {
+                           return ATTRIBS.find(kind)->second.kindAsString;
                        });
         sbFail("%s", utils::format(
                    "not all inputs available in buffer, expected:\n{0}\ngot\n{1}",
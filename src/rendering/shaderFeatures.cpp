@@ -0,0 +1,95 @@
+#include <sandbox/rendering/shaderFeatures.h>
+
+#include <sandbox/utils/stringUtils.h>
+
+namespace sb {
+
+ShaderFeatures::Define::Define(const std::string& name,
+                               int value):
+    name(name),
+    value(utils::toString(value))
+{}
+
+ShaderFeatures::ShaderFeatures(std::initializer_list<Define> defines)
+{
+    for (const Define& define: defines) {
+        mDefines[define.name] = define.value;
+    }
+}
+
+ShaderFeatures& ShaderFeatures::set(const std::string& name)
+{
+    mDefines[name] = "";
+    return *this;
+}
+
+ShaderFeatures& ShaderFeatures::set(const std::string& name,
+                                    int value)
+{
+    mDefines[name] = utils::toString(value);
+    return *this;
+}
+
+ShaderFeatures ShaderFeatures::merged(const ShaderFeatures& other) const
+{
+    ShaderFeatures ret = *this;
+    for (const auto& define: other.mDefines) {
+        ret.mDefines[define.first] = define.second;
+    }
+    return ret;
+}
+
+ShaderFeatures ShaderFeatures::filtered(
+        const std::function<bool(const std::string&)>& pred) const
+{
+    ShaderFeatures ret;
+    for (const auto& define: mDefines) {
+        if (pred(define.first)) {
+            ret.mDefines.insert(define);
+        }
+    }
+    return ret;
+}
+
+std::string ShaderFeatures::apply(const std::string& code) const
+{
+    if (mDefines.empty()) {
+        return code;
+    }
+
+    std::string defines;
+    for (const auto& define: mDefines) {
+        defines += "#define " + define.first;
+        if (!define.second.empty()) {
+            defines += " " + define.second;
+        }
+        defines += "\n";
+    }
+
+    // #version must stay the first directive; no #line afterwards, so that
+    // compile log line numbers match the source printed with them
+    size_t versionPos = code.find("#version");
+    if (versionPos == std::string::npos) {
+        return defines + code;
+    }
+
+    size_t lineEnd = code.find('\n', versionPos);
+    if (lineEnd == std::string::npos) {
+        return code + "\n" + defines;
+    }
+
+    return code.substr(0, lineEnd + 1) + defines + code.substr(lineEnd + 1);
+}
+
+std::string ShaderFeatures::toString() const
+{
+    std::vector<std::string> parts;
+    for (const auto& define: mDefines) {
+        parts.push_back(define.second.empty()
+                        ? define.first
+                        : define.first + "=" + define.second);
+    }
+    return utils::join(parts, ",");
+}
+
+} // namespace sb
@@ -7,7 +7,8 @@ namespace sb
         Drawable(ProjectionType::Orthographic,
                  gResourceMgr.getQuad(),
                  gResourceMgr.getTexture("default.png"),
-                 shader)
+                 shader),
+        mImage("default.png")
     {}
 
     Sprite::Sprite(const std::string& image,
@@ -15,11 +16,13 @@ namespace sb
         Drawable(ProjectionType::Orthographic,
                  gResourceMgr.getQuad(),
                  gResourceMgr.getTexture(image),
-                 shader)
+                 shader),
+        mImage(image)
     {}
 
     void Sprite::setImage(const std::string& image)
     {
+        mImage = image;
         setTexture(gResourceMgr.getTexture(image));
     }
 } // namespace sb
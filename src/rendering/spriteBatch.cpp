@@ -0,0 +1,69 @@
+#include <sandbox/rendering/spriteBatch.h>
+#include <sandbox/rendering/sprite.h>
+
+#include <sandbox/resources/resourceMgr.h>
+#include <sandbox/resources/textureAtlas.h>
+
+#include <cmath>
+
+namespace sb {
+
+SpriteBatch::SpriteBatch():
+    mQuads()
+{}
+
+void SpriteBatch::add(const std::string& image,
+                      const Mat44& transform,
+                      const Color& color)
+{
+    const TextureAtlas::Region& region = gResourceMgr.getAtlasRegion(image);
+
+    auto corner = [&transform](float x, float y) {
+        Vec4 v = transform * Vec4(x, y, 0.0f, 1.0f);
+        return Vec3(v.x, v.y, v.z);
+    };
+
+    mQuads.add(region.page,
+               {{ corner(-1.0f, -1.0f), corner(1.0f, -1.0f),
+                  corner(-1.0f, 1.0f), corner(1.0f, 1.0f) }},
+               {{ Vec2(region.uvMin.x, region.uvMin.y),
+                  Vec2(region.uvMax.x, region.uvMin.y),
+                  Vec2(region.uvMin.x, region.uvMax.y),
+                  Vec2(region.uvMax.x, region.uvMax.y) }},
+               color);
+}
+
+void SpriteBatch::add(const std::string& image,
+                      const Vec2& center,
+                      const Vec2& halfSize,
+                      Radians rotation,
+                      const Color& color)
+{
+    const TextureAtlas::Region& region = gResourceMgr.getAtlasRegion(image);
+
+    float s = std::sin(rotation.value());
+    float c = std::cos(rotation.value());
+    auto corner = [&](float x, float y) {
+        x *= halfSize.x;
+        y *= halfSize.y;
+        return Vec3(center.x + x * c - y * s,
+                    center.y + x * s + y * c,
+                    0.0f);
+    };
+
+    mQuads.add(region.page,
+               {{ corner(-1.0f, -1.0f), corner(1.0f, -1.0f),
+                  corner(-1.0f, 1.0f), corner(1.0f, 1.0f) }},
+               {{ Vec2(region.uvMin.x, region.uvMin.y),
+                  Vec2(region.uvMax.x, region.uvMin.y),
+                  Vec2(region.uvMin.x, region.uvMax.y),
+                  Vec2(region.uvMax.x, region.uvMax.y) }},
+               color);
+}
+
+void SpriteBatch::add(const Sprite& sprite)
+{
+    add(sprite.getImage(), sprite.getTransformationMatrix(), sprite.getColor());
+}
+
+} // namespace sb
@@ -0,0 +1,449 @@
+#include <sandbox/rendering/staticBatch.h>
+#include <sandbox/rendering/drawable.h>
+#include <sandbox/rendering/camera.h>
+#include <sandbox/rendering/shader.h>
+#include <sandbox/rendering/texture.h>
+#include <sandbox/rendering/textureArray.h>
+
+#include <sandbox/resources/mesh.h>
+#include <sandbox/resources/resourceMgr.h>
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+#include <set>
+#include <tuple>
+
+namespace sb {
+namespace {
+
+const char* const TEXTURE_UNIFORM = "tex";
+// texture units 0 and 1 are taken by tex and texArray
+const size_t FIRST_SHADOW_TEXTURE_UNIT = 2;
+const GLuint DRAW_DATA_BINDING = 0;
+const GLuint INPUT_COMMANDS_BINDING = 1;
+const GLuint OUTPUT_COMMANDS_BINDING = 2;
+const GLuint COUNTERS_BINDING = 3;
+// local_size_x of the culling shader
+const size_t CULL_GROUP_SIZE = 64;
+
+} // namespace
+
+StaticBatch::StaticBatch():
+    mShader(),
+    mLitShader(),
+    mCullShader(),
+    mCullingEnabled(true),
+    mEntries(),
+    mNextHandle(0),
+    mDirty(false),
+    mGroups(),
+    mUnbatched(),
+    mNumCommands(0),
+    mCommandBuffer(),
+    mDrawDataBuffer(),
+    mCulledCommandBuffer(),
+    mCounterBuffer()
+{
+    static_assert(sizeof(DrawCommand) == 5 * sizeof(GLuint),
+                  "DrawCommand must match DrawElementsIndirectCommand");
+    static_assert(sizeof(DrawData) == 112,
+                  "DrawData must match std430 layout of the shader struct");
+
+    if (isSupported()) {
+        mShader = gResourceMgr.getStaticBatchShader();
+        mLitShader = gResourceMgr.getStaticBatchShader(true);
+        if (isCullingSupported()) {
+            mCullShader = gResourceMgr.getFrustumCullShader();
+        } else {
+            gLog.info("compute shaders not supported, static batch will not "
+                      "be culled");
+        }
+    } else {
+        gLog.info("indirect multi-draw not supported, static batch will "
+                  "draw objects one by one");
+    }
+}
+
+bool StaticBatch::isSupported()
+{
+    return GLEW_ARB_multi_draw_indirect
+           && GLEW_ARB_shader_storage_buffer_object
+           && GLEW_ARB_shader_draw_parameters;
+}
+
+bool StaticBatch::isCullingSupported()
+{
+    return isSupported() && GLEW_ARB_compute_shader;
+}
+
+StaticBatch::Handle StaticBatch::add(const std::shared_ptr<Drawable>& drawable,
+                                     bool useBatchShader)
+{
+    sbAssert(drawable && drawable->mMesh, "cannot batch drawable without mesh");
+    sbAssert(drawable->mProjectionType == ProjectionType::Perspective,
+             "only perspective drawables can be batched");
+
+    mEntries.push_back({ mNextHandle, drawable, useBatchShader, NO_DRAW,
+                         Shading::Unsupported, nullptr, 0 });
+    mDirty = true;
+    return mNextHandle++;
+}
+
+void StaticBatch::remove(Handle handle)
+{
+    auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                           [handle](const Entry& e) {
+                               return e.handle == handle;
+                           });
+    if (it != mEntries.end()) {
+        mEntries.erase(it);
+        mDirty = true;
+    }
+}
+
+void StaticBatch::updateTransform(Handle handle)
+{
+    auto it = std::find_if(mEntries.begin(), mEntries.end(),
+                           [handle](const Entry& e) {
+                               return e.handle == handle;
+                           });
+    // unbatched drawables are drawn with their current transform anyway,
+    // and a dirty batch picks it up when rebuilt
+    if (it == mEntries.end() || mDirty || it->drawIndex == NO_DRAW) {
+        return;
+    }
+
+    // matModel is the first member of DrawData
+    const Mat44& matModel = it->drawable->getTransformationMatrix();
+    mDrawDataBuffer->write(it->drawIndex * sizeof(DrawData),
+                           &matModel, sizeof(matModel));
+}
+
+void StaticBatch::clear()
+{
+    mEntries.clear();
+    mDirty = true;
+}
+
+StaticBatch::Shading StaticBatch::getShading(const Drawable& drawable) const
+{
+    if (!mShader || !drawable.mShader || !drawable.mMesh->getArena()) {
+        return Shading::Unsupported;
+    }
+    // uniforms of the placeholder say nothing about the real shader
+    if (!drawable.mShader->isReady()) {
+        return Shading::Pending;
+    }
+
+    // uniforms set by Drawable::draw that the batch shader reproduces
+    static const std::set<std::string> SUPPORTED_UNIFORMS {
+        "matViewProjection", "matModel", "color", "ambientLightColor",
+        TEXTURE_UNIFORM, std::string(TEXTURE_UNIFORM) + "Layer",
+        "pointLights", "numPointLights",
+        "parallelLights", "numParallelLights",
+        "shadows", "numShadows"
+    };
+
+    const Shader& shader = *drawable.mShader;
+    for (const Uniform& uniform: shader.getUniforms()) {
+        if (SUPPORTED_UNIFORMS.count(uniform.name) == 0) {
+            gLog.warn("static batch: shader %s uses uniform %s, drawing it "
+                      "one by one", shader.getName().c_str(),
+                      uniform.name.c_str());
+            return Shading::Unsupported;
+        }
+    }
+
+    const bool lit = shader.hasUniform("pointLights")
+                     || shader.hasUniform("parallelLights")
+                     || shader.hasUniform("shadows");
+
+    uint32_t required = Attrib::getMask(Attrib::Kind::Position)
+                        | Attrib::getMask(Attrib::Kind::Texcoord);
+    if (lit) {
+        required |= Attrib::getMask(Attrib::Kind::Normal);
+    }
+    if ((Attrib::getMask(drawable.mMesh->getAttribs()) & required) != required) {
+        return Shading::Unsupported;
+    }
+
+    return lit ? Shading::Lit : Shading::Unlit;
+}
+
+bool StaticBatch::isStale() const
+{
+    for (const Entry& entry: mEntries) {
+        if (entry.shading == Shading::Pending
+                && entry.drawable->mShader->isReady()) {
+            return true;
+        }
+
+        // the revision also changes on in-place updates that keep the
+        // allocation, but move the bounding sphere
+        const Mesh* mesh = entry.drawable->mMesh.get();
+        if (mesh != entry.mesh || mesh->getRevision() != entry.meshRevision) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void StaticBatch::rebuild()
+{
+    mDirty = false;
+    mGroups.clear();
+    mUnbatched.clear();
+
+    struct Item
+    {
+        Entry* entry;
+        const Drawable* drawable;
+        bool lit;
+        std::shared_ptr<const Texture> texture;
+        TextureLayer layer;
+    };
+
+    std::vector<Item> items;
+    for (Entry& entry: mEntries) {
+        const Drawable& d = *entry.drawable;
+        entry.drawIndex = NO_DRAW;
+        entry.shading = entry.useBatchShader ? getShading(d)
+                                             : Shading::Unsupported;
+        entry.mesh = d.mMesh.get();
+        entry.meshRevision = d.mMesh->getRevision();
+
+        if (entry.shading != Shading::Unlit && entry.shading != Shading::Lit) {
+            mUnbatched.push_back(entry.drawable);
+            continue;
+        }
+
+        Item item { &entry, &d, entry.shading == Shading::Lit,
+                    nullptr, { nullptr, 0 } };
+        auto layerIt = d.mTextureLayers.find(TEXTURE_UNIFORM);
+        if (layerIt != d.mTextureLayers.end()) {
+            item.layer = layerIt->second;
+        } else {
+            auto texIt = d.mTextures.find(TEXTURE_UNIFORM);
+            item.texture = texIt != d.mTextures.end()
+                           ? texIt->second
+                           : gResourceMgr.getDefaultTexture();
+        }
+        items.push_back(item);
+    }
+
+    auto groupKey = [](const Item& item) {
+        Mesh& mesh = *item.drawable->mMesh;
+        return std::make_tuple(mesh.getArena().get(), (GLenum)mesh.getShape(),
+                               mesh.getIndexType(), item.lit,
+                               item.texture.get(), item.layer.array.get());
+    };
+
+    std::stable_sort(items.begin(), items.end(),
+                     [&groupKey](const Item& a, const Item& b) {
+                         return groupKey(a) < groupKey(b);
+                     });
+
+    std::vector<DrawCommand> commands;
+    std::vector<DrawData> drawData;
+    commands.reserve(items.size());
+    drawData.reserve(items.size());
+
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Item& item = items[i];
+        Mesh& mesh = *item.drawable->mMesh;
+
+        if (i == 0 || groupKey(items[i - 1]) != groupKey(item)) {
+            mGroups.push_back({ mesh.getArena(), (GLenum)mesh.getShape(),
+                                mesh.getIndexType(), item.lit, item.texture,
+                                item.layer.array, commands.size(), 0 });
+        }
+
+        const GeometryArena::Allocation& alloc = mesh.getAllocation();
+        const Vec3& center = mesh.getBoundingSphereCenter();
+
+        item.entry->drawIndex = drawData.size();
+        commands.push_back({
+            (GLuint)alloc.numIndices, 1,
+            (GLuint)(alloc.indexOffsetBytes / getIndexSize(alloc.indexType)),
+            (GLint)alloc.baseVertex, (GLuint)drawData.size()
+        });
+        drawData.push_back({
+            item.drawable->getTransformationMatrix(),
+            item.drawable->getColor(),
+            Vec4(center.x, center.y, center.z, mesh.getBoundingSphereRadius()),
+            (float)item.layer.layer,
+            (GLuint)(mGroups.size() - 1),
+            (GLuint)mGroups.back().firstCommand,
+            0
+        });
+        ++mGroups.back().numCommands;
+    }
+
+    gLog.trace("static batch: %lu objects in %lu multi-draws, %lu unbatched",
+               commands.size(), mGroups.size(), mUnbatched.size());
+
+    mNumCommands = commands.size();
+    if (commands.empty()) {
+        return;
+    }
+
+    const size_t commandBytes = commands.size() * sizeof(DrawCommand);
+    const size_t drawDataBytes = drawData.size() * sizeof(DrawData);
+    const std::vector<GLuint> counters(mGroups.size(), 0);
+    const size_t counterBytes = counters.size() * sizeof(GLuint);
+
+    if (mCommandBuffer) {
+        mCommandBuffer->upload(&commands[0], commandBytes);
+        mDrawDataBuffer->upload(&drawData[0], drawDataBytes);
+    } else {
+        mCommandBuffer.reset(new Buffer(&commands[0], commandBytes, GL_STATIC_DRAW));
+        mDrawDataBuffer.reset(new Buffer(&drawData[0], drawDataBytes, GL_STATIC_DRAW));
+    }
+
+    if (!mCullShader) {
+        return;
+    }
+
+    // written by the culling pass every frame
+    if (mCulledCommandBuffer) {
+        mCulledCommandBuffer->upload(&commands[0], commandBytes);
+        mCounterBuffer->upload(&counters[0], counterBytes);
+    } else {
+        mCulledCommandBuffer.reset(new Buffer(&commands[0], commandBytes, GL_DYNAMIC_COPY));
+        mCounterBuffer.reset(new Buffer(&counters[0], counterBytes, GL_DYNAMIC_COPY));
+    }
+}
+
+void StaticBatch::cull(const Mat44& viewProjection)
+{
+    const bool gpuDrawCount = GLEW_ARB_indirect_parameters;
+
+    GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, mCounterBuffer->getId()));
+    GL_CHECK(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI,
+                               GL_RED_INTEGER, GL_UNSIGNED_INT, NULL));
+    if (!gpuDrawCount) {
+        // all commands are drawn; the ones past visible count must be empty
+        GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER,
+                              mCulledCommandBuffer->getId()));
+        GL_CHECK(glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI,
+                                   GL_RED_INTEGER, GL_UNSIGNED_INT, NULL));
+    }
+    GL_CHECK(glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0));
+
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING,
+                              mDrawDataBuffer->getId()));
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INPUT_COMMANDS_BINDING,
+                              mCommandBuffer->getId()));
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OUTPUT_COMMANDS_BINDING,
+                              mCulledCommandBuffer->getId()));
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTERS_BINDING,
+                              mCounterBuffer->getId()));
+
+    {
+        auto shaderBind = make_bind(*mCullShader);
+        mCullShader->setUniform("matViewProjection", viewProjection);
+        mCullShader->setUniform("numDraws", (unsigned)mNumCommands);
+
+        GLuint numWorkGroups = (GLuint)((mNumCommands + CULL_GROUP_SIZE - 1)
+                                        / CULL_GROUP_SIZE);
+        GL_CHECK(glDispatchCompute(numWorkGroups, 1, 1));
+    }
+
+    // commands and counters are consumed as indirect draw parameters
+    GL_CHECK(glMemoryBarrier(GL_COMMAND_BARRIER_BIT));
+
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INPUT_COMMANDS_BINDING, 0));
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OUTPUT_COMMANDS_BINDING, 0));
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COUNTERS_BINDING, 0));
+}
+
+void StaticBatch::draw(Renderer::State& state)
+{
+    if (mDirty || isStale()) {
+        rebuild();
+    }
+
+    for (const std::shared_ptr<Drawable>& d: mUnbatched) {
+        d->draw(state);
+    }
+
+    if (mGroups.empty()) {
+        return;
+    }
+
+    const bool culling = isCullingEnabled();
+    const bool gpuDrawCount = culling && GLEW_ARB_indirect_parameters;
+    if (culling) {
+        cull(state.camera->getViewProjectionMatrix());
+    }
+
+    const Buffer& commands = culling ? *mCulledCommandBuffer : *mCommandBuffer;
+    GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.getId()));
+    if (gpuDrawCount) {
+        GL_CHECK(glBindBuffer(GL_PARAMETER_BUFFER_ARB, mCounterBuffer->getId()));
+    }
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING,
+                              mDrawDataBuffer->getId()));
+
+    for (size_t groupIdx = 0; groupIdx < mGroups.size(); ++groupIdx) {
+        const Group& group = mGroups[groupIdx];
+        // shadow maps only need depth; the lit shader would also sample the
+        // shadow map being rendered
+        const bool lit = group.lit && !state.isRenderingShadow;
+        const std::shared_ptr<Shader>& shader = lit ? mLitShader : mShader;
+
+        auto arenaBind = make_bind(*group.arena);
+        auto shaderBind = make_bind(*shader, group.arena->getAttribs());
+
+        shader->setUniform("matViewProjection",
+                           state.camera->getViewProjectionMatrix());
+
+        std::vector<bind_guard<Texture>> textureBind;
+        std::vector<bind_guard<TextureArray>> textureArrayBind;
+        std::vector<bind_guard<Texture>> shadowBinds;
+        if (!state.isRenderingShadow) {
+            shader->setUniform("ambientLightColor", state.ambientLightColor);
+            shader->setUniform("tex", (GLint)0);
+            shader->setUniform("texArray", (GLint)1);
+            shader->setUniform("useTextureArray",
+                               (GLint)(group.textureArray ? 1 : 0));
+
+            if (group.textureArray) {
+                textureArrayBind.emplace_back(make_bind(*group.textureArray, 1));
+            } else {
+                textureBind.emplace_back(make_bind(*group.texture, 0));
+            }
+
+            if (lit) {
+                Drawable::setLightUniforms(state, shader);
+                Drawable::setShadowUniforms(state, shader,
+                                            FIRST_SHADOW_TEXTURE_UNIT,
+                                            shadowBinds);
+            }
+        }
+
+        const void* firstCommand =
+                (const void*)(group.firstCommand * sizeof(DrawCommand));
+        if (gpuDrawCount) {
+            GL_CHECK(glMultiDrawElementsIndirectCountARB(
+                    group.shape, group.indexType, firstCommand,
+                    (GLintptr)(groupIdx * sizeof(GLuint)),
+                    (GLsizei)group.numCommands, 0));
+        } else {
+            GL_CHECK(glMultiDrawElementsIndirect(
+                    group.shape, group.indexType, firstCommand,
+                    (GLsizei)group.numCommands, 0));
+        }
+    }
+
+    if (gpuDrawCount) {
+        GL_CHECK(glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0));
+    }
+    GL_CHECK(glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, 0));
+    GL_CHECK(glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0));
+}
+
+} // namespace sb
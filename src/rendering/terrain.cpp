@@ -11,4 +11,13 @@ namespace sb
                  gResourceMgr.getTexture(texture),
                  shader)
     {}
+
+    Terrain::Terrain(const std::shared_ptr<Mesh>& mesh,
+                     const std::shared_ptr<Texture>& texture,
+                     const std::shared_ptr<Shader>& shader):
+        Drawable(ProjectionType::Perspective,
+                 mesh,
+                 texture,
+                 shader)
+    {}
 } // namespace sb
@@ -0,0 +1,40 @@
+#include <sandbox/rendering/textBatch.h>
+
+#include <sandbox/resources/font.h>
+
+namespace sb {
+
+TextBatch::TextBatch():
+    mQuads()
+{}
+
+void TextBatch::add(const std::shared_ptr<Font>& font,
+                    const std::string& text,
+                    const Vec2& topLeft,
+                    const Color& color)
+{
+    float x = topLeft.x;
+    float y = topLeft.y;
+    for (char c: text) {
+        if (c == '\n') {
+            x = topLeft.x;
+            y += (float)font->getLineHeightPixels();
+            continue;
+        }
+
+        const Font::Letter& l = font->getLetter((uint8_t)c);
+        float w = (float)l.widthPixels;
+        float h = (float)l.heightPixels;
+
+        mQuads.add(font->getTexture(),
+                   {{ Vec3(x, y, 0.0f), Vec3(x + w, y, 0.0f),
+                      Vec3(x, y + h, 0.0f), Vec3(x + w, y + h, 0.0f) }},
+                   {{ l.texcoords.bottomLeft(), l.texcoords.bottomRight,
+                      l.texcoords.topLeft, l.texcoords.topRight() }},
+                   color);
+
+        x += w;
+    }
+}
+
+} // namespace sb
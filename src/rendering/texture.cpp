@@ -1,10 +1,12 @@
 #include <sandbox/rendering/texture.h>
 
+#include <sandbox/utils/debug.h>
 #include <sandbox/utils/logger.h>
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/math.h>
 #include <sandbox/utils/misc.h>
 
+#include <algorithm>
 #include <vector>
 
 namespace sb {
@@ -26,7 +28,8 @@ GLuint createTexture(unsigned width,
 
     GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
     GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
-    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR));
+    GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                             generateMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
     GL_CHECK(glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
 
     if (imageFormat == GL_DEPTH_COMPONENT) {
@@ -49,17 +52,27 @@ GLuint createTexture(unsigned width,
 } // namespace
 
 Texture::Texture(unsigned width,
-                 unsigned height):
-    mId(createTexture(width, height, nullptr, GL_DEPTH_COMPONENT, GL_FLOAT, true))
+                 unsigned height,
+                 Format format):
+    mId(format == Format::Depth
+        ? createTexture(width, height, nullptr, GL_DEPTH_COMPONENT, GL_FLOAT, true)
+        : createTexture(width, height, nullptr, GL_RGBA, GL_UNSIGNED_BYTE, false)),
+    // depth textures are mipmapped; assume 32-bit depth
+    mSizeBytes(format == Format::Depth
+               ? (size_t)width * height * 4 * 4 / 3
+               : (size_t)width * height * 4)
 {
 }
 
 Texture::Texture(std::shared_ptr<Image> image):
-    mId(0)
+    mId(0),
+    mSizeBytes(0)
 {
     uint32_t maxTexSize;
     GL_CHECK(glGetIntegerv(GL_MAX_TEXTURE_SIZE, (GLint*)&maxTexSize));
 
+    // ilGetData below reads the image bound by getHeight()
+    auto ilLock = Image::lockDevIL();
     uint32_t imgWidth = image->getWidth();
     uint32_t imgHeight = image->getHeight();
 
@@ -83,6 +96,79 @@ Texture::Texture(std::shared_ptr<Image> image):
     mId = createTexture(imgWidth, imgHeight, ilGetData(),
                         ilGetInteger(IL_IMAGE_FORMAT),
                         ilGetInteger(IL_IMAGE_TYPE), true);
+    // full mip chain takes 1/3 of the base level more
+    mSizeBytes = (size_t)imgWidth * imgHeight
+                 * ilGetInteger(IL_IMAGE_BYTES_PER_PIXEL) * 4 / 3;
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, prevTex));
+}
+
+Texture::Texture(const CompressedImage& image):
+    mId(0),
+    mSizeBytes(0)
+{
+    const std::vector<CompressedImage::Level>& levels = image.getLevels();
+    sbAssert(!levels.empty(), "compressed image has no levels");
+
+    GLuint prevTex;
+    GL_CHECK(glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&prevTex));
+
+    GL_CHECK(glGenTextures(1, &mId));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                             levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    // files may stop before the 1x1 level
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                             (GLint)levels.size() - 1));
+
+    for (size_t i = 0; i < levels.size(); ++i) {
+        const CompressedImage::Level& level = levels[i];
+        GL_CHECK(glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i,
+                                        image.getFormat(),
+                                        level.width, level.height, 0,
+                                        (GLsizei)level.sizeBytes, level.data));
+        mSizeBytes += level.sizeBytes;
+    }
+
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, prevTex));
+}
+
+Texture::Texture(uint32_t width,
+                 uint32_t height,
+                 uint32_t numLevels,
+                 GLenum internalFormat):
+    mId(0),
+    mSizeBytes(0)
+{
+    GLuint prevTex;
+    GL_CHECK(glGetIntegerv(GL_TEXTURE_BINDING_2D, (GLint*)&prevTex));
+
+    GL_CHECK(glGenTextures(1, &mId));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D, mId));
+
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                             numLevels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                             (GLint)numLevels - 1));
+
+    GL_CHECK(glTexStorage2D(GL_TEXTURE_2D, numLevels, internalFormat,
+                            width, height));
+
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        const uint32_t w = std::max(width >> level, 1u);
+        const uint32_t h = std::max(height >> level, 1u);
+        const size_t compressedBytes =
+                CompressedImage::getLevelSizeBytes(internalFormat, w, h);
+        // anything not block-compressed is streamed as RGBA8
+        mSizeBytes += compressedBytes ? compressedBytes : (size_t)w * h * 4;
+    }
 
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, prevTex));
 }
@@ -105,6 +191,18 @@ void Texture::unbind() const
     GL_CHECK(glBindTexture(GL_TEXTURE_2D, 0));
 }
 
+void Texture::upload(uint32_t x,
+                     uint32_t y,
+                     uint32_t width,
+                     uint32_t height,
+                     const void* rgbaData)
+{
+    auto bind = make_bind(*this, 0);
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+                             GL_RGBA, GL_UNSIGNED_BYTE, rgbaData));
+}
+
 void Texture::setMagFilter(MagFilter filter) const
 {
     GLuint magFilter = filter == MagFilter::Nearest ? GL_NEAREST : GL_LINEAR;
@@ -113,5 +211,10 @@ void Texture::setMagFilter(MagFilter filter) const
     GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter));
 }
 
-} // namespace sb
+void Texture::setBaseLevel(uint32_t baseLevel) const
+{
+    auto bind = make_bind(*this, 0);
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)baseLevel));
+}
 
+} // namespace sb
@@ -0,0 +1,77 @@
+#include <sandbox/rendering/textureArray.h>
+
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/misc.h>
+#include <sandbox/utils/debug.h>
+
+namespace sb {
+
+TextureArray::TextureArray(uint32_t width,
+                           uint32_t height,
+                           uint32_t numLayers):
+    mId(0),
+    mWidth(width),
+    mHeight(height),
+    mNumLayers(numLayers),
+    mUsedLayers(0),
+    mMipmapsDirty(false)
+{
+    GL_CHECK(glGenTextures(1, &mId));
+    auto bind = make_bind(*this, 0);
+
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                             GL_LINEAR_MIPMAP_LINEAR));
+    GL_CHECK(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+
+    GL_CHECK(glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8,
+                          width, height, numLayers, 0,
+                          GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+}
+
+TextureArray::~TextureArray()
+{
+    if (mId) {
+        GL_CHECK(glDeleteTextures(1, &mId));
+    }
+}
+
+uint32_t TextureArray::addLayer(const void* rgbaData)
+{
+    sbAssert(!isFull(), "no free layers in texture array");
+
+    uint32_t layer = mUsedLayers++;
+
+    // not bind(), which would regenerate mipmaps for the previous layer
+    GL_CHECK(glActiveTexture(GL_TEXTURE0));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, mId));
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GL_CHECK(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+                             mWidth, mHeight, 1,
+                             GL_RGBA, GL_UNSIGNED_BYTE, rgbaData));
+    unbind();
+
+    mMipmapsDirty = true;
+    return layer;
+}
+
+void TextureArray::bind(uint32_t textureUnit) const
+{
+    GL_CHECK(glActiveTexture(GL_TEXTURE0 + textureUnit));
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, mId));
+
+    // once for all layers added since the last bind, instead of once per
+    // layer
+    if (mMipmapsDirty) {
+        GL_CHECK(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+        mMipmapsDirty = false;
+    }
+}
+
+void TextureArray::unbind() const
+{
+    GL_CHECK(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
+
+} // namespace sb
@@ -0,0 +1,299 @@
+#include <sandbox/rendering/textureStreamer.h>
+
+#include <sandbox/utils/debug.h>
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/misc.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace sb {
+namespace {
+
+// rows of pixels, or of 4x4 blocks for compressed levels
+uint32_t getNumRows(const TextureMips& mips,
+                    const TextureMips::Level& level)
+{
+    return mips.compressed ? (level.height + 3) / 4 : level.height;
+}
+
+} // namespace
+
+TextureMips TextureMips::fromCompressed(const std::shared_ptr<CompressedImage>& image)
+{
+    TextureMips mips;
+    mips.internalFormat = image->getFormat();
+    mips.compressed = true;
+    for (const CompressedImage::Level& level: image->getLevels()) {
+        mips.levels.push_back({ level.width, level.height,
+                                level.data, level.sizeBytes });
+    }
+    mips.storage = image;
+    return mips;
+}
+
+TextureMips TextureMips::fromRGBA(const void* rgba,
+                                  uint32_t width,
+                                  uint32_t height)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> sizes;
+    size_t totalBytes = 0;
+    for (uint32_t w = width, h = height; ; w = std::max(w / 2, 1u),
+                                           h = std::max(h / 2, 1u)) {
+        sizes.push_back({ w, h });
+        totalBytes += (size_t)w * h * 4;
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+
+    auto data = std::make_shared<std::vector<uint8_t>>(totalBytes);
+    uint8_t* dst = data->data();
+    memcpy(dst, rgba, (size_t)width * height * 4);
+
+    TextureMips mips;
+    mips.internalFormat = GL_RGBA8;
+    mips.compressed = false;
+    mips.levels.push_back({ width, height, dst, (size_t)width * height * 4 });
+
+    for (size_t i = 1; i < sizes.size(); ++i) {
+        const Level& src = mips.levels.back();
+        const uint8_t* srcData = (const uint8_t*)src.data;
+        dst += src.sizeBytes;
+
+        const uint32_t w = sizes[i].first;
+        const uint32_t h = sizes[i].second;
+        for (uint32_t y = 0; y < h; ++y) {
+            for (uint32_t x = 0; x < w; ++x) {
+                const uint32_t x0 = std::min(x * 2, src.width - 1);
+                const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+                const uint32_t y0 = std::min(y * 2, src.height - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+
+                for (uint32_t c = 0; c < 4; ++c) {
+                    uint32_t sum = srcData[((size_t)y0 * src.width + x0) * 4 + c]
+                                   + srcData[((size_t)y0 * src.width + x1) * 4 + c]
+                                   + srcData[((size_t)y1 * src.width + x0) * 4 + c]
+                                   + srcData[((size_t)y1 * src.width + x1) * 4 + c];
+                    dst[((size_t)y * w + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                }
+            }
+        }
+
+        mips.levels.push_back({ w, h, dst, (size_t)w * h * 4 });
+    }
+
+    mips.storage = data;
+    return mips;
+}
+
+TextureStreamer::TextureStreamer():
+    mStreams(),
+    mStagingBuffers(),
+    mNextStagingBuffer(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    clear();
+}
+
+bool TextureStreamer::isSupported()
+{
+    return GLEW_ARB_texture_storage;
+}
+
+void TextureStreamer::add(const std::shared_ptr<Texture>& texture,
+                          const TextureMips& mips)
+{
+    sbAssert(!mips.levels.empty(), "no mip levels to stream");
+
+    Texture storage(mips.levels[0].width, mips.levels[0].height,
+                    (uint32_t)mips.levels.size(), mips.internalFormat);
+
+    // smallest levels go in right away, so that the texture is complete
+    size_t level = mips.levels.size() - 1;
+    size_t tailBytes = mips.levels[level].sizeBytes;
+    uploadLevel(storage, mips, level);
+    while (level > 0
+            && tailBytes + mips.levels[level - 1].sizeBytes <= RESIDENT_TAIL_BYTES) {
+        --level;
+        tailBytes += mips.levels[level].sizeBytes;
+        uploadLevel(storage, mips, level);
+    }
+
+    storage.setBaseLevel((uint32_t)level);
+    texture->swap(storage);
+
+    if (level > 0) {
+        mStreams.push_back({ texture, mips, level - 1, 0 });
+    }
+}
+
+void TextureStreamer::update(size_t budgetBytes)
+{
+    size_t uploadedBytes = 0;
+    while (!mStreams.empty() && uploadedBytes < budgetBytes) {
+        if (mStreams.front().texture.expired()) {
+            mStreams.pop_front();
+            continue;
+        }
+
+        size_t bytes = uploadRows(mStreams.front(), false);
+        if (bytes == 0) {
+            // GPU still reading the staging buffers
+            return;
+        }
+
+        uploadedBytes += bytes;
+    }
+}
+
+void TextureStreamer::finish()
+{
+    update(std::numeric_limits<size_t>::max());
+    while (!mStreams.empty()) {
+        if (mStreams.front().texture.expired()) {
+            mStreams.pop_front();
+        } else {
+            uploadRows(mStreams.front(), true);
+        }
+    }
+}
+
+void TextureStreamer::clear()
+{
+    mStreams.clear();
+    for (StagingBuffer& staging: mStagingBuffers) {
+        if (staging.fence) {
+            GL_CHECK(glDeleteSync(staging.fence));
+        }
+    }
+    mStagingBuffers.clear();
+    mNextStagingBuffer = 0;
+}
+
+TextureStreamer::StagingBuffer* TextureStreamer::acquireStagingBuffer(bool wait)
+{
+    if (mStagingBuffers.empty()) {
+        mStagingBuffers.resize(NUM_STAGING_BUFFERS);
+        for (StagingBuffer& staging: mStagingBuffers) {
+            staging.buffer.reset(new Buffer(NULL, STAGING_BUFFER_BYTES,
+                                            GL_STREAM_DRAW));
+            staging.fence = 0;
+        }
+    }
+
+    StagingBuffer& staging = mStagingBuffers[mNextStagingBuffer];
+    if (staging.fence) {
+        GLenum status;
+        GL_CHECK(status = glClientWaitSync(staging.fence,
+                                           GL_SYNC_FLUSH_COMMANDS_BIT,
+                                           wait ? std::numeric_limits<GLuint64>::max() : 0));
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return nullptr;
+        }
+
+        GL_CHECK(glDeleteSync(staging.fence));
+        staging.fence = 0;
+    }
+
+    mNextStagingBuffer = (mNextStagingBuffer + 1) % mStagingBuffers.size();
+    return &staging;
+}
+
+size_t TextureStreamer::uploadRows(Stream& stream,
+                                   bool wait)
+{
+    const TextureMips& mips = stream.mips;
+    const TextureMips::Level& level = mips.levels[stream.level];
+    const uint32_t numRows = getNumRows(mips, level);
+    const size_t rowBytes = level.sizeBytes / numRows;
+
+    std::shared_ptr<Texture> texture = stream.texture.lock();
+    sbAssert(texture, "streaming into a released texture");
+
+    size_t bytes;
+    if (rowBytes > STAGING_BUFFER_BYTES) {
+        // a single row does not fit in a staging buffer, which only
+        // happens for absurdly wide textures
+        uploadLevel(*texture, mips, stream.level);
+        bytes = level.sizeBytes;
+        stream.row = numRows;
+    } else {
+        StagingBuffer* staging = acquireStagingBuffer(wait);
+        if (!staging) {
+            return 0;
+        }
+
+        const uint32_t rows = std::min(numRows - stream.row,
+                                       (uint32_t)(STAGING_BUFFER_BYTES / rowBytes));
+        bytes = rows * rowBytes;
+        // the buffer is known to be idle, no need to synchronize
+        staging->buffer->write(0, (const uint8_t*)level.data + stream.row * rowBytes,
+                               bytes, Buffer::WriteMode::Unsynchronized);
+
+        {
+            auto bufferBind = make_bind(*staging->buffer, GL_PIXEL_UNPACK_BUFFER,
+                                        GL_PIXEL_UNPACK_BUFFER_BINDING);
+            auto textureBind = make_bind(*texture, 0);
+            GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+
+            if (mips.compressed) {
+                const uint32_t y = stream.row * 4;
+                const uint32_t height = std::min(rows * 4, level.height - y);
+                GL_CHECK(glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)stream.level,
+                                                   0, y, level.width, height,
+                                                   mips.internalFormat,
+                                                   (GLsizei)bytes, (const void*)0));
+            } else {
+                GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, (GLint)stream.level,
+                                         0, stream.row, level.width, rows,
+                                         GL_RGBA, GL_UNSIGNED_BYTE, (const void*)0));
+            }
+        }
+
+        GL_CHECK(staging->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        stream.row += rows;
+    }
+
+    if (stream.row == numRows) {
+        // commands are executed in order, so draws issued from now on see
+        // the whole level
+        texture->setBaseLevel((uint32_t)stream.level);
+
+        if (stream.level == 0) {
+            mStreams.pop_front();
+        } else {
+            --stream.level;
+            stream.row = 0;
+        }
+    }
+
+    return bytes;
+}
+
+void TextureStreamer::uploadLevel(const Texture& texture,
+                                  const TextureMips& mips,
+                                  size_t level)
+{
+    const TextureMips::Level& data = mips.levels[level];
+
+    auto bind = make_bind(texture, 0);
+    GL_CHECK(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    if (mips.compressed) {
+        GL_CHECK(glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)level,
+                                           0, 0, data.width, data.height,
+                                           mips.internalFormat,
+                                           (GLsizei)data.sizeBytes, data.data));
+    } else {
+        GL_CHECK(glTexSubImage2D(GL_TEXTURE_2D, (GLint)level,
+                                 0, 0, data.width, data.height,
+                                 GL_RGBA, GL_UNSIGNED_BYTE, data.data));
+    }
+}
+
+} // namespace sb
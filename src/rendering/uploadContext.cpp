@@ -0,0 +1,248 @@
+#include <sandbox/rendering/uploadContext.h>
+
+#include <sandbox/utils/lib.h>
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
+
+#include <future>
+#include <limits>
+
+namespace sb {
+namespace {
+
+typedef GLXContext (*GLXCREATECTXATTRSARBPROC)(::Display*, GLXFBConfig, GLXContext, Bool, const int*);
+
+bool gCreationFailed = false;
+
+int onCreationError(::Display*, XErrorEvent*)
+{
+    gCreationFailed = true;
+    return 0;
+}
+
+} // namespace
+
+UploadContext::UploadContext(::Display* display,
+                             GLXFBConfig fbc,
+                             GLXContext shareContext,
+                             int versionMajor,
+                             int versionMinor):
+    mDisplay(display),
+    mContext(NULL),
+    mPbuffer(0),
+    mMutex(),
+    mJobAdded(),
+    mJobDone(),
+    mJobs(),
+    mCompletions(),
+    mStopping(false),
+    mNumInFlight(0),
+    mThread()
+{
+    GLXCREATECTXATTRSARBPROC glXCreateContextAttribsARB = (GLXCREATECTXATTRSARBPROC)glXGetProcAddress((GLubyte*)"glXCreateContextAttribsARB");
+    if (!glXCreateContextAttribsARB) {
+        gLog.err("glXCreateContextAttribsARB not present\n");
+        return;
+    }
+
+    const int contextAttribs[] = {
+        GLX_CONTEXT_MAJOR_VERSION_ARB, versionMajor,
+        GLX_CONTEXT_MINOR_VERSION_ARB, versionMinor,
+        GLX_CONTEXT_FLAGS_ARB, GLX_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+        0
+    };
+    // the upload context never presents anything
+    const int pbufferAttribs[] = {
+        GLX_PBUFFER_WIDTH, 1,
+        GLX_PBUFFER_HEIGHT, 1,
+        None
+    };
+
+    int (*prevErrorHandler)(::Display*, XErrorEvent*) =
+            XSetErrorHandler(onCreationError);
+
+    gCreationFailed = false;
+    mContext = glXCreateContextAttribsARB(mDisplay, fbc, shareContext, True, contextAttribs);
+    XSync(mDisplay, False);
+    if (mContext && gCreationFailed) {
+        glXDestroyContext(mDisplay, mContext);
+        mContext = NULL;
+    }
+
+    // window-only framebuffer configs may not support pbuffers; GL 3.0+
+    // contexts can be made current without a drawable then
+    int drawableType = 0;
+    glXGetFBConfigAttrib(mDisplay, fbc, GLX_DRAWABLE_TYPE, &drawableType);
+    if (mContext && (drawableType & GLX_PBUFFER_BIT)) {
+        gCreationFailed = false;
+        mPbuffer = glXCreatePbuffer(mDisplay, fbc, pbufferAttribs);
+        XSync(mDisplay, False);
+        if (gCreationFailed) {
+            mPbuffer = 0;
+        }
+    }
+
+    XSetErrorHandler(prevErrorHandler);
+
+    if (!mContext) {
+        gLog.warn("cannot create shared GL context, uploads will be done "
+                  "on the render thread\n");
+        return;
+    }
+
+    std::promise<bool> madeCurrent;
+    std::future<bool> isCurrent = madeCurrent.get_future();
+    mThread = std::thread([this, &madeCurrent]() {
+        bool ok = glXMakeContextCurrent(mDisplay, mPbuffer, mPbuffer, mContext);
+        madeCurrent.set_value(ok);
+        if (ok) {
+            run();
+            glXMakeContextCurrent(mDisplay, None, None, NULL);
+        }
+    });
+
+    if (!isCurrent.get()) {
+        gLog.warn("cannot make shared GL context current, uploads will be "
+                  "done on the render thread\n");
+        mThread.join();
+        if (mPbuffer) {
+            glXDestroyPbuffer(mDisplay, mPbuffer);
+            mPbuffer = 0;
+        }
+        glXDestroyContext(mDisplay, mContext);
+        mContext = NULL;
+        return;
+    }
+
+    gLog.info("upload context created%s\n",
+              mPbuffer ? "" : " (no pbuffer)");
+}
+
+UploadContext::~UploadContext()
+{
+    if (!mContext) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        mJobs.clear();
+    }
+
+    mJobAdded.notify_all();
+    mThread.join();
+
+    // objects created by finished jobs outlive the context anyway, shared
+    // with the render one
+    for (const Completion& completion: mCompletions) {
+        GL_CHECK(glDeleteSync(completion.fence));
+    }
+
+    if (mPbuffer) {
+        glXDestroyPbuffer(mDisplay, mPbuffer);
+    }
+    glXDestroyContext(mDisplay, mContext);
+    gLog.info("upload context deleted\n");
+}
+
+void UploadContext::submit(std::function<void()> job,
+                           std::function<void()> onComplete)
+{
+    sbAssert(isValid(), "submit on invalid upload context");
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back({ std::move(job), std::move(onComplete) });
+        ++mNumInFlight;
+    }
+
+    mJobAdded.notify_one();
+}
+
+void UploadContext::poll()
+{
+    runCompletions(false);
+}
+
+void UploadContext::finish()
+{
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mJobDone.wait(lock, [this]() {
+            return mCompletions.size() == mNumInFlight;
+        });
+    }
+
+    runCompletions(true);
+}
+
+void UploadContext::run()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobAdded.wait(lock, [this]() {
+                return mStopping || !mJobs.empty();
+            });
+
+            if (mStopping) {
+                return;
+            }
+
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        job.run();
+
+        GLsync fence;
+        GL_CHECK(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        // the fence must reach the GPU before the render context waits on
+        // it; parenthesized, as the call tracing macro needs arguments
+        GL_CHECK((glFlush)());
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCompletions.push_back({ fence, std::move(job.onComplete) });
+        }
+        mJobDone.notify_all();
+    }
+}
+
+void UploadContext::runCompletions(bool wait)
+{
+    const GLuint64 timeout = wait ? std::numeric_limits<GLuint64>::max() : 0;
+
+    while (true) {
+        Completion completion;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mCompletions.empty()) {
+                return;
+            }
+            completion = mCompletions.front();
+        }
+
+        GLenum status;
+        GL_CHECK(status = glClientWaitSync(completion.fence, 0, timeout));
+        if (status == GL_TIMEOUT_EXPIRED) {
+            return;
+        }
+        if (status == GL_WAIT_FAILED) {
+            gLog.err("glClientWaitSync failed on upload fence\n");
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mCompletions.pop_front();
+            --mNumInFlight;
+        }
+
+        GL_CHECK(glDeleteSync(completion.fence));
+        completion.onComplete();
+    }
+}
+
+} // namespace sb
@@ -4,8 +4,11 @@
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/logger.h>
 #include <sandbox/utils/debug.h>
+#include <sandbox/utils/math.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 
 // damn you windows.h
 #ifdef min
@@ -21,49 +24,156 @@ const std::map<Attrib::Kind, Attrib> ATTRIBS {
     { Attrib::Kind::Normal,   { "normal",   GL_FLOAT, 3, sizeof(Vec3) } }
 };
 
-void VertexBuffer::addBuffer(const Attrib::Kind& kind,
-                             const void* data,
-                             size_t numElements)
+namespace {
+
+struct FormatInfo {
+    GLenum type;
+    GLint numComponents;
+    GLboolean normalized;
+    size_t sizeBytes;
+};
+
+FormatInfo getFormatInfo(Attrib::Kind kind,
+                         Attrib::Format format)
 {
     const Attrib& attrib = ATTRIBS.find(kind)->second;
-    Buffer buffer(data, numElements * attrib.elemSizeBytes);
 
-    buffer.bind(GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
-    GL_CHECK(glEnableVertexAttribArray(mBuffers.size()));
-    GL_CHECK(glVertexAttribPointer(mBuffers.size(),
-                                   attrib.numComponents, GL_FLOAT,
-                                   GL_FALSE, 0, NULL));
-    buffer.unbind();
+    switch (format) {
+    case Attrib::Format::Float:
+        return { GL_FLOAT, (GLint)attrib.numComponents, GL_FALSE,
+                 attrib.elemSizeBytes };
+    case Attrib::Format::HalfFloat:
+        // padded to keep every attribute 4-byte aligned
+        return { GL_HALF_FLOAT, (GLint)attrib.numComponents, GL_FALSE,
+                 (attrib.numComponents * sizeof(uint16_t) + 3) & ~(size_t)3 };
+    case Attrib::Format::PackedNormal:
+        sbAssert(kind == Attrib::Kind::Normal,
+                 "packed normal format used for %s",
+                 attrib.kindAsString.c_str());
+        return { GL_INT_2_10_10_10_REV, 4, GL_TRUE, sizeof(uint32_t) };
+    case Attrib::Format::UNorm8:
+        sbAssert(kind == Attrib::Kind::Color,
+                 "RGBA8 format used for %s", attrib.kindAsString.c_str());
+        return { GL_UNSIGNED_BYTE, 4, GL_TRUE, 4 * sizeof(uint8_t) };
+    }
 
-    mBuffers.emplace_back(std::move(buffer), kind);
+    sbFail("invalid attribute format");
 }
 
-VertexBuffer::VertexBuffer(const std::vector<Vec3>& vertices,
-                           const std::vector<Vec2>& texcoords,
-                           const std::vector<Color>& colors,
-                           const std::vector<Vec3>& normals):
-    mVAO(0),
-    mBuffers()
+// round-to-nearest; values too small for a normal half are flushed to zero
+uint16_t floatToHalf(float value)
 {
-#if 0
-    gLog.debug("creating vertex buffer (%lu, vertices%s%s)\n",
-               vertices.size(),
-               texcoords.size() > 0 ? " texcoords" : "",
-               colors.size() > 0 ? " colors" : "");
-#endif
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
 
-    GL_CHECK(glGenVertexArrays(1, &mVAO));
-    auto vaoBind = make_bind(*this);
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x007fffff;
+
+    if (exponent <= 0) {
+        return (uint16_t)sign;
+    }
+    if (exponent >= 31) {
+        bool isNan = ((bits >> 23) & 0xff) == 0xff && mantissa != 0;
+        return (uint16_t)(sign | 0x7c00 | (isNan ? 0x200 : 0));
+    }
+
+    // carry from rounding may overflow into the exponent, which is fine
+    uint32_t half = sign | ((uint32_t)exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) {
+        ++half;
+    }
+    return (uint16_t)half;
+}
+
+uint32_t packSnorm10(float value)
+{
+    float scaled = std::round(math::clamp(value, -1.0f, 1.0f) * 511.0f);
+    return (uint32_t)(int32_t)scaled & 0x3ff;
+}
+
+uint8_t packUnorm8(float value)
+{
+    return (uint8_t)std::round(math::clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+// converts a single element from its float representation to given format
+void packAttrib(Attrib::Kind kind,
+                Attrib::Format format,
+                const float* src,
+                uint8_t* dst)
+{
+    const Attrib& attrib = ATTRIBS.find(kind)->second;
+
+    switch (format) {
+    case Attrib::Format::Float:
+        memcpy(dst, src, attrib.elemSizeBytes);
+        break;
+    case Attrib::Format::HalfFloat:
+        for (size_t i = 0; i < attrib.numComponents; ++i) {
+            uint16_t half = floatToHalf(src[i]);
+            memcpy(dst + i * sizeof(half), &half, sizeof(half));
+        }
+        break;
+    case Attrib::Format::PackedNormal: {
+        uint32_t packed = packSnorm10(src[0])
+                          | (packSnorm10(src[1]) << 10)
+                          | (packSnorm10(src[2]) << 20);
+        memcpy(dst, &packed, sizeof(packed));
+        break;
+    }
+    case Attrib::Format::UNorm8:
+        for (size_t i = 0; i < 4; ++i) {
+            dst[i] = packUnorm8(src[i]);
+        }
+        break;
+    }
+}
+
+std::vector<uint8_t> packAttribs(Attrib::Kind kind,
+                                 Attrib::Format format,
+                                 const void* data,
+                                 size_t numElements)
+{
+    const Attrib& attrib = ATTRIBS.find(kind)->second;
+    const FormatInfo info = getFormatInfo(kind, format);
+    const uint8_t* src = (const uint8_t*)data;
 
+    std::vector<uint8_t> packed(numElements * info.sizeBytes, 0);
+    for (size_t i = 0; i < numElements; ++i) {
+        packAttrib(kind, format,
+                   (const float*)(src + i * attrib.elemSizeBytes),
+                   &packed[i * info.sizeBytes]);
+    }
+
+    return packed;
+}
+
+} // namespace
+
+VertexSources::VertexSources(const std::vector<Vec3>& vertices,
+                             const std::vector<Vec2>& texcoords,
+                             const std::vector<Color>& colors,
+                             const std::vector<Vec3>& normals):
+    attribs(),
+    data(),
+    numElements(),
+    numVertices(vertices.size())
+{
     sbAssert(vertices.size() > 0, "vertex buffer must have some vertices");
-    addBuffer(Attrib::Kind::Position, &vertices[0], vertices.size());
+
+    attribs.push_back(Attrib::Kind::Position);
+    data.push_back(&vertices[0]);
+    numElements.push_back(vertices.size());
 
     if (texcoords.size() > 0) {
         if (vertices.size() != texcoords.size()) {
             gLog.warn("%lu vertices, but %lu texcoords\n",
                       vertices.size(), texcoords.size());
         }
-        addBuffer(Attrib::Kind::Texcoord, &texcoords[0], texcoords.size());
+        attribs.push_back(Attrib::Kind::Texcoord);
+        data.push_back(&texcoords[0]);
+        numElements.push_back(texcoords.size());
     }
 
     if (colors.size() > 0) {
@@ -71,7 +181,9 @@ VertexBuffer::VertexBuffer(const std::vector<Vec3>& vertices,
             gLog.warn("%lu vertices, but %lu colors\n",
                       vertices.size(), colors.size());
         }
-        addBuffer(Attrib::Kind::Color, &colors[0], colors.size());
+        attribs.push_back(Attrib::Kind::Color);
+        data.push_back(&colors[0]);
+        numElements.push_back(colors.size());
     }
 
     if (normals.size() > 0) {
@@ -79,7 +191,153 @@ VertexBuffer::VertexBuffer(const std::vector<Vec3>& vertices,
             gLog.warn("%lu vertices, but %lu normals\n",
                       vertices.size(), normals.size());
         }
-        addBuffer(Attrib::Kind::Normal, &normals[0], normals.size());
+        attribs.push_back(Attrib::Kind::Normal);
+        data.push_back(&normals[0]);
+        numElements.push_back(normals.size());
+    }
+}
+
+Attrib::Format VertexLayout::getFormat(Attrib::Kind kind) const
+{
+    auto it = formats.find(kind);
+    return it == formats.end() ? Attrib::Format::Float : it->second;
+}
+
+VertexLayout VertexLayout::dynamic()
+{
+    return { Storage::Separate, GL_DYNAMIC_DRAW, {} };
+}
+
+VertexLayout VertexLayout::packed()
+{
+    return {
+        Storage::Interleaved, GL_STATIC_DRAW, {
+            { Attrib::Kind::Texcoord, Attrib::Format::HalfFloat },
+            { Attrib::Kind::Color,    Attrib::Format::UNorm8 },
+            { Attrib::Kind::Normal,   Attrib::Format::PackedNormal }
+        }
+    };
+}
+
+size_t VertexLayout::getStride(const std::vector<Attrib::Kind>& attribs) const
+{
+    size_t stride = 0;
+    for (Attrib::Kind kind: attribs) {
+        stride += getFormatInfo(kind, getFormat(kind)).sizeBytes;
+    }
+    return stride;
+}
+
+std::vector<uint8_t> VertexLayout::interleave(const VertexSources& sources) const
+{
+    const size_t stride = getStride(sources.attribs);
+    std::vector<uint8_t> vertexData(sources.numVertices * stride, 0);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < sources.attribs.size(); ++i) {
+        const Attrib::Kind kind = sources.attribs[i];
+        const Attrib::Format format = getFormat(kind);
+        const size_t elemSize = ATTRIBS.find(kind)->second.elemSizeBytes;
+        const uint8_t* src = (const uint8_t*)sources.data[i];
+
+        size_t count = std::min(sources.numElements[i], sources.numVertices);
+        for (size_t v = 0; v < count; ++v) {
+            packAttrib(kind, format, (const float*)(src + v * elemSize),
+                       &vertexData[v * stride + offset]);
+        }
+
+        offset += getFormatInfo(kind, format).sizeBytes;
+    }
+
+    return vertexData;
+}
+
+void VertexLayout::setAttribPointers(const std::vector<Attrib::Kind>& attribs) const
+{
+    const size_t stride = getStride(attribs);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < attribs.size(); ++i) {
+        const FormatInfo info = getFormatInfo(attribs[i], getFormat(attribs[i]));
+
+        const GLuint location = Attrib::getLocation(attribs[i]);
+        GL_CHECK(glEnableVertexAttribArray(location));
+        GL_CHECK(glVertexAttribPointer(location, info.numComponents, info.type,
+                                       info.normalized, stride,
+                                       (const void*)offset));
+        offset += info.sizeBytes;
+    }
+}
+
+void VertexBuffer::addBuffer(const Attrib::Kind& kind,
+                             const void* data,
+                             size_t numElements)
+{
+    const Attrib::Format format = mLayout.getFormat(kind);
+    const FormatInfo info = getFormatInfo(kind, format);
+
+    std::vector<uint8_t> packed;
+    if (format != Attrib::Format::Float) {
+        packed = packAttribs(kind, format, data, numElements);
+        data = &packed[0];
+    }
+
+    Buffer buffer(data, numElements * info.sizeBytes, mLayout.usage);
+
+    buffer.bind(GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
+    GL_CHECK(glEnableVertexAttribArray(Attrib::getLocation(kind)));
+    GL_CHECK(glVertexAttribPointer(Attrib::getLocation(kind),
+                                   info.numComponents, info.type,
+                                   info.normalized, 0, NULL));
+    buffer.unbind();
+
+    mBuffers.emplace_back(std::move(buffer), kind);
+}
+
+void VertexBuffer::addInterleavedBuffer(const VertexSources& sources)
+{
+    std::vector<uint8_t> vertexData = mLayout.interleave(sources);
+    Buffer buffer(&vertexData[0], vertexData.size(), mLayout.usage);
+
+    buffer.bind(GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
+    mLayout.setAttribPointers(mAttribs);
+    buffer.unbind();
+
+    mBuffers.emplace_back(std::move(buffer), Attrib::Kind::Unspecified);
+}
+
+VertexBuffer::VertexBuffer(const std::vector<Vec3>& vertices,
+                           const std::vector<Vec2>& texcoords,
+                           const std::vector<Color>& colors,
+                           const std::vector<Vec3>& normals,
+                           const VertexLayout& layout):
+    mVAO(0),
+    mLayout(layout),
+    mAttribs(),
+    mBuffers()
+{
+#if 0
+    gLog.debug("creating vertex buffer (%lu, vertices%s%s)\n",
+               vertices.size(),
+               texcoords.size() > 0 ? " texcoords" : "",
+               colors.size() > 0 ? " colors" : "");
+#endif
+
+    GL_CHECK(glGenVertexArrays(1, &mVAO));
+    auto vaoBind = make_bind(*this);
+
+    VertexSources sources(vertices, texcoords, colors, normals);
+    mAttribs = sources.attribs;
+
+    switch (mLayout.storage) {
+    case VertexLayout::Storage::Separate:
+        for (size_t i = 0; i < mAttribs.size(); ++i) {
+            addBuffer(mAttribs[i], sources.data[i], sources.numElements[i]);
+        }
+        break;
+    case VertexLayout::Storage::Interleaved:
+        addInterleavedBuffer(sources);
+        break;
     }
 }
 
@@ -113,18 +371,102 @@ void VertexBuffer::unbind() const
     GL_CHECK(glBindVertexArray(0));
 }
 
+void VertexBuffer::update(Attrib::Kind kind,
+                          const void* data,
+                          size_t numElements)
+{
+    sbAssert(mLayout.storage == VertexLayout::Storage::Separate,
+             "cannot update a single attribute of interleaved buffer");
+
+    auto it = std::find_if(mBuffers.begin(), mBuffers.end(),
+                           [kind](const BufferKindPair& p) {
+                               return p.kind == kind;
+                           });
+    sbAssert(it != mBuffers.end(), "no %s buffer to update",
+             ATTRIBS.find(kind)->second.kindAsString.c_str());
+
+    const Attrib::Format format = mLayout.getFormat(kind);
+    if (format == Attrib::Format::Float) {
+        it->buffer.upload(data, numElements * ATTRIBS.find(kind)->second.elemSizeBytes);
+    } else {
+        std::vector<uint8_t> packed = packAttribs(kind, format, data, numElements);
+        it->buffer.upload(packed.data(), packed.size());
+    }
+}
+
+void VertexBuffer::update(const VertexSources& sources)
+{
+    sbAssert(sources.attribs == mAttribs,
+             "vertex buffer attributes cannot change on update");
+
+    switch (mLayout.storage) {
+    case VertexLayout::Storage::Separate:
+        for (size_t i = 0; i < mAttribs.size(); ++i) {
+            update(mAttribs[i], sources.data[i], sources.numElements[i]);
+        }
+        break;
+    case VertexLayout::Storage::Interleaved: {
+        std::vector<uint8_t> vertexData = mLayout.interleave(sources);
+        mBuffers[0].buffer.upload(vertexData.data(), vertexData.size());
+        break;
+    }
+    }
+}
+
+void VertexBuffer::write(size_t firstVertex,
+                         const VertexSources& sources,
+                         Buffer::WriteMode mode)
+{
+    sbAssert(sources.attribs == mAttribs,
+             "vertex buffer attributes cannot change on update");
+
+    switch (mLayout.storage) {
+    case VertexLayout::Storage::Separate:
+        for (size_t i = 0; i < mAttribs.size(); ++i) {
+            const Attrib::Kind kind = mAttribs[i];
+            const Attrib::Format format = mLayout.getFormat(kind);
+            const size_t elemSize = getFormatInfo(kind, format).sizeBytes;
+            const size_t count = std::min(sources.numElements[i],
+                                          sources.numVertices);
+
+            if (format == Attrib::Format::Float) {
+                mBuffers[i].buffer.write(firstVertex * elemSize,
+                                         sources.data[i], count * elemSize, mode);
+            } else {
+                std::vector<uint8_t> packed = packAttribs(kind, format,
+                                                          sources.data[i], count);
+                mBuffers[i].buffer.write(firstVertex * elemSize,
+                                         packed.data(), packed.size(), mode);
+            }
+        }
+        break;
+    case VertexLayout::Storage::Interleaved: {
+        std::vector<uint8_t> vertexData = mLayout.interleave(sources);
+        mBuffers[0].buffer.write(firstVertex * mLayout.getStride(mAttribs),
+                                 vertexData.data(), vertexData.size(), mode);
+        break;
+    }
+    }
+}
+
 void VertexBuffer::debug()
 {
-    gLog.debug("VAO %d: %lu buffers\n", mVAO, mBuffers.size());
-    for (size_t i = 0; i < mBuffers.size(); ++i) {
+    gLog.debug("VAO %d: %lu attribs in %lu buffers\n",
+               mVAO, mAttribs.size(), mBuffers.size());
+    for (size_t i = 0; i < mAttribs.size(); ++i) {
+        const GLuint location = Attrib::getLocation(mAttribs[i]);
         GLuint attribBuffer = 0;
+        GLint stride = 0;
 
-        GL_CHECK(glGetVertexAttribiv((GLuint)i, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, (GLint*)&attribBuffer));
-
-        GLint size;
-        auto bufferBind = make_bind(mBuffers[i].buffer, GL_ARRAY_BUFFER, GL_ARRAY_BUFFER_BINDING);
-        GL_CHECK(glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size));
-        gLog.debug("- attrib %lu: buffer %d (%d bytes)\n", i, attribBuffer, size);
+        GL_CHECK(glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, (GLint*)&attribBuffer));
+        GL_CHECK(glGetVertexAttribiv(location, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride));
+        gLog.debug("- attrib %lu (%s) at location %u: buffer %d, stride %d\n", i,
+                   ATTRIBS.find(mAttribs[i])->second.kindAsString.c_str(),
+                   location, attribBuffer, stride);
+    }
+    for (const BufferKindPair& bk: mBuffers) {
+        gLog.debug("- buffer %d: %lu bytes\n",
+                   bk.buffer.getId(), bk.buffer.getSize());
     }
 }
 
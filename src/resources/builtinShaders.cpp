@@ -0,0 +1,333 @@
+#include <sandbox/resources/builtinShaders.h>
+
+namespace sb {
+namespace builtin {
+
+const char* const DEBUG_VERT = R"GLSL(#version 330
+
+layout(location = 0) in vec3 position; // POSITION
+layout(location = 2) in vec4 color; // COLOR
+
+uniform mat4 matViewProjection;
+
+out vec4 vertexColor;
+
+void main()
+{
+    vertexColor = color;
+    gl_Position = matViewProjection * vec4(position, 1.0);
+}
+)GLSL";
+
+const char* const DEBUG_FRAG = R"GLSL(#version 330
+
+in vec4 vertexColor;
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = vertexColor;
+}
+)GLSL";
+
+const char* const BATCH2D_VERT = R"GLSL(#version 330
+
+layout(location = 0) in vec3 position; // POSITION
+layout(location = 1) in vec2 texcoord; // TEXCOORD
+layout(location = 2) in vec4 color; // COLOR
+
+uniform mat4 matViewProjection;
+
+out vec2 vertexTexcoord;
+out vec4 vertexColor;
+
+void main()
+{
+    vertexTexcoord = texcoord;
+    vertexColor = color;
+    gl_Position = matViewProjection * vec4(position, 1.0);
+}
+)GLSL";
+
+const char* const BATCH2D_FRAG = R"GLSL(#version 330
+
+in vec2 vertexTexcoord;
+in vec4 vertexColor;
+
+uniform sampler2D tex;
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = texture(tex, vertexTexcoord) * vertexColor;
+}
+)GLSL";
+
+const char* const PLACEHOLDER_VERT = R"GLSL(#version 330
+
+layout(location = 0) in vec3 position; // POSITION
+
+uniform mat4 matViewProjection;
+uniform mat4 matModel;
+
+void main()
+{
+    gl_Position = matViewProjection * matModel * vec4(position, 1.0);
+}
+)GLSL";
+
+const char* const PLACEHOLDER_FRAG = R"GLSL(#version 330
+
+uniform vec4 color;
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = color;
+}
+)GLSL";
+
+const char* const STATIC_VERT = R"GLSL(#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+layout(location = 0) in vec3 position; // POSITION
+layout(location = 1) in vec2 texcoord; // TEXCOORD
+#ifdef LIT
+layout(location = 3) in vec3 normal; // NORMAL
+#endif
+
+struct DrawData
+{
+    mat4 matModel;
+    vec4 color;
+    // xyz - center in model space, w - radius
+    vec4 boundingSphere;
+    float layer;
+    uint group;
+    uint groupFirstCommand;
+    uint padding;
+};
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+    DrawData draws[];
+};
+
+uniform mat4 matViewProjection;
+
+out vec2 vertexTexcoord;
+flat out vec4 vertexColor;
+flat out float vertexLayer;
+#ifdef LIT
+out vec3 vertexPosition;
+out vec3 vertexNormal;
+#endif
+
+void main()
+{
+    // commands carry the index of their draw data in baseInstance, which
+    // stays valid when culling reorders them
+    DrawData draw = draws[gl_BaseInstanceARB];
+    vec4 worldPosition = draw.matModel * vec4(position, 1.0);
+
+    vertexTexcoord = texcoord;
+    vertexColor = draw.color;
+    vertexLayer = draw.layer;
+#ifdef LIT
+    vertexPosition = worldPosition.xyz;
+    vertexNormal = mat3(transpose(inverse(draw.matModel))) * normal;
+#endif
+    gl_Position = matViewProjection * worldPosition;
+}
+)GLSL";
+
+const char* const STATIC_FRAG = R"GLSL(#version 430
+
+#define MAX_POINT_LIGHTS 8
+#define MAX_PARALLEL_LIGHTS 8
+#define MAX_SHADOWS 4
+
+in vec2 vertexTexcoord;
+flat in vec4 vertexColor;
+flat in float vertexLayer;
+#ifdef LIT
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+#endif
+
+uniform sampler2D tex;
+uniform sampler2DArray texArray;
+uniform int useTextureArray;
+uniform vec4 ambientLightColor;
+
+#ifdef LIT
+struct PointLight
+{
+    vec3 position;
+    vec4 color;
+    float intensity;
+};
+
+struct ParallelLight
+{
+    vec3 direction;
+    vec4 color;
+    float intensity;
+};
+
+struct Shadow
+{
+    mat4 projectionMatrix;
+    sampler2D map;
+};
+
+uniform PointLight pointLights[MAX_POINT_LIGHTS];
+uniform uint numPointLights;
+uniform ParallelLight parallelLights[MAX_PARALLEL_LIGHTS];
+uniform uint numParallelLights;
+uniform Shadow shadows[MAX_SHADOWS];
+uniform uint numShadows;
+
+// 0 where any shadow map sees an occluder in front of the fragment
+float getShadowFactor(vec3 position)
+{
+    float factor = 1.0;
+    for (uint i = 0u; i < min(numShadows, uint(MAX_SHADOWS)); ++i) {
+        vec4 coord = shadows[i].projectionMatrix * vec4(position, 1.0);
+        coord /= coord.w;
+        if (all(greaterThanEqual(coord.xyz, vec3(0.0)))
+                && all(lessThanEqual(coord.xyz, vec3(1.0)))
+                && texture(shadows[i].map, coord.xy).r < coord.z - 0.005) {
+            factor = 0.0;
+        }
+    }
+    return factor;
+}
+
+vec4 getLightColor(vec3 position, vec3 normal)
+{
+    vec4 light = ambientLightColor;
+
+    for (uint i = 0u; i < min(numPointLights, uint(MAX_POINT_LIGHTS)); ++i) {
+        vec3 toLight = pointLights[i].position - position;
+        float distance = length(toLight);
+        float diffuse = max(dot(normal, toLight / distance), 0.0);
+        float attenuation = min(pointLights[i].intensity / (distance * distance), 1.0);
+        light += pointLights[i].color * diffuse * attenuation;
+    }
+
+    // shadows are only cast by parallel lights
+    float shadow = getShadowFactor(position);
+    for (uint i = 0u; i < min(numParallelLights, uint(MAX_PARALLEL_LIGHTS)); ++i) {
+        float diffuse = max(dot(normal, -normalize(parallelLights[i].direction)), 0.0);
+        float intensity = min(parallelLights[i].intensity, 1.0);
+        light += parallelLights[i].color * diffuse * intensity * shadow;
+    }
+
+    return vec4(min(light.rgb, vec3(1.0)), 1.0);
+}
+#endif
+
+out vec4 fragColor;
+
+void main()
+{
+    vec4 texColor = useTextureArray != 0
+                    ? texture(texArray, vec3(vertexTexcoord, vertexLayer))
+                    : texture(tex, vertexTexcoord);
+#ifdef LIT
+    vec4 light = getLightColor(vertexPosition, normalize(vertexNormal));
+#else
+    vec4 light = ambientLightColor;
+#endif
+    fragColor = texColor * vertexColor * light;
+}
+)GLSL";
+
+const char* const CULL_COMP = R"GLSL(#version 430
+
+layout(local_size_x = 64) in;
+
+struct DrawData
+{
+    mat4 matModel;
+    vec4 color;
+    vec4 boundingSphere;
+    float layer;
+    uint group;
+    uint groupFirstCommand;
+    uint padding;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+    DrawData draws[];
+};
+
+layout(std430, binding = 1) readonly buffer InputCommandBuffer
+{
+    DrawCommand inputCommands[];
+};
+
+layout(std430, binding = 2) writeonly buffer OutputCommandBuffer
+{
+    DrawCommand outputCommands[];
+};
+
+// number of visible draws in each group
+layout(std430, binding = 3) buffer CounterBuffer
+{
+    uint counters[];
+};
+
+uniform mat4 matViewProjection;
+uniform uint numDraws;
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= numDraws) {
+        return;
+    }
+
+    DrawData draw = draws[index];
+
+    vec3 center = (draw.matModel * vec4(draw.boundingSphere.xyz, 1.0)).xyz;
+    float scale = max(length(draw.matModel[0].xyz),
+                      max(length(draw.matModel[1].xyz),
+                          length(draw.matModel[2].xyz)));
+    float radius = draw.boundingSphere.w * scale;
+
+    // frustum planes from the rows of view-projection matrix
+    mat4 m = transpose(matViewProjection);
+    vec4 planes[6] = vec4[6](m[3] + m[0], m[3] - m[0],
+                             m[3] + m[1], m[3] - m[1],
+                             m[3] + m[2], m[3] - m[2]);
+
+    for (int i = 0; i < 6; ++i) {
+        float distance = (dot(planes[i].xyz, center) + planes[i].w)
+                         / length(planes[i].xyz);
+        if (distance < -radius) {
+            return;
+        }
+    }
+
+    uint slot = atomicAdd(counters[draw.group], 1u);
+    outputCommands[draw.groupFirstCommand + slot] = inputCommands[index];
+}
+)GLSL";
+
+} // namespace builtin
+} // namespace sb
@@ -0,0 +1,363 @@
+#include <sandbox/resources/compressedImage.h>
+
+#include <sandbox/utils/logger.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace sb {
+namespace {
+
+const uint8_t KTX_IDENTIFIER[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+struct KTXHeader
+{
+    uint8_t identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+const uint32_t DDPF_FOURCC = 0x4;
+
+struct DDSPixelFormat
+{
+    uint32_t size;
+    uint32_t flags;
+    uint32_t fourCC;
+    uint32_t rgbBitCount;
+    uint32_t rBitMask;
+    uint32_t gBitMask;
+    uint32_t bBitMask;
+    uint32_t aBitMask;
+};
+
+struct DDSHeader
+{
+    uint32_t magic;
+    uint32_t size;
+    uint32_t flags;
+    uint32_t height;
+    uint32_t width;
+    uint32_t pitchOrLinearSize;
+    uint32_t depth;
+    uint32_t mipMapCount;
+    uint32_t reserved1[11];
+    DDSPixelFormat pixelFormat;
+    uint32_t caps;
+    uint32_t caps2;
+    uint32_t caps3;
+    uint32_t caps4;
+    uint32_t reserved2;
+};
+
+struct DDSHeaderDX10
+{
+    uint32_t dxgiFormat;
+    uint32_t resourceDimension;
+    uint32_t miscFlag;
+    uint32_t arraySize;
+    uint32_t miscFlags2;
+};
+
+constexpr uint32_t fourCC(const char (&code)[5])
+{
+    return (uint32_t)code[0]
+           | ((uint32_t)code[1] << 8)
+           | ((uint32_t)code[2] << 16)
+           | ((uint32_t)code[3] << 24);
+}
+
+GLenum formatFromFourCC(uint32_t code)
+{
+    switch (code) {
+    case fourCC("DXT1"): return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case fourCC("DXT3"): return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    case fourCC("DXT5"): return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case fourCC("ATI1"):
+    case fourCC("BC4U"): return GL_COMPRESSED_RED_RGTC1;
+    case fourCC("ATI2"):
+    case fourCC("BC5U"): return GL_COMPRESSED_RG_RGTC2;
+    default: return 0;
+    }
+}
+
+GLenum formatFromDXGI(uint32_t dxgiFormat)
+{
+    switch (dxgiFormat) {
+    case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT; // BC1_UNORM
+    case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT; // BC2_UNORM
+    case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; // BC3_UNORM
+    case 80: return GL_COMPRESSED_RED_RGTC1;          // BC4_UNORM
+    case 83: return GL_COMPRESSED_RG_RGTC2;           // BC5_UNORM
+    case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;    // BC7_UNORM
+    default: return 0;
+    }
+}
+
+// bytes per 4x4 block; 0 for formats CompressedImage does not handle
+size_t getBlockSizeBytes(GLenum format)
+{
+    switch (format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        return 8;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+    case GL_COMPRESSED_RG_RGTC2:
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+} // namespace
+
+CompressedImage::CompressedImage():
+    mFile(),
+    mData(nullptr),
+    mSize(0),
+    mFormat(0),
+    mLevels()
+{
+}
+
+size_t CompressedImage::getLevelSizeBytes(GLenum format,
+                                         uint32_t width,
+                                         uint32_t height)
+{
+    return (size_t)((width + 3) / 4) * ((height + 3) / 4)
+           * getBlockSizeBytes(format);
+}
+
+bool CompressedImage::loadFromFile(const std::string& path)
+{
+    if (!mFile.open(path)) {
+        mData = nullptr;
+        mSize = 0;
+        mFormat = 0;
+        mLevels.clear();
+        return false;
+    }
+
+    if (!parse(mFile.getData(), mFile.getSize(), path)) {
+        mFile.close();
+        return false;
+    }
+    return true;
+}
+
+bool CompressedImage::loadFromMemory(const void* data,
+                                     size_t sizeBytes,
+                                     const std::string& name)
+{
+    mFile.close();
+    return parse((const uint8_t*)data, sizeBytes, name);
+}
+
+bool CompressedImage::parse(const uint8_t* data,
+                            size_t sizeBytes,
+                            const std::string& name)
+{
+    mData = data;
+    mSize = sizeBytes;
+    mFormat = 0;
+    mLevels.clear();
+
+    bool ok = false;
+    if (mSize >= sizeof(KTX_IDENTIFIER)
+            && memcmp(mData, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0) {
+        ok = parseKTX();
+    } else if (mSize >= sizeof(uint32_t)
+               && *(const uint32_t*)mData == DDS_MAGIC) {
+        ok = parseDDS();
+    }
+
+    if (!ok) {
+        gLog.warn("%s: unsupported or malformed compressed image",
+                  name.c_str());
+        mData = nullptr;
+        mSize = 0;
+        mFormat = 0;
+        mLevels.clear();
+        return false;
+    }
+
+    gLog.trace("%s: %ux%u, format 0x%x, %lu mip levels", name.c_str(),
+               getWidth(), getHeight(), mFormat, mLevels.size());
+    return true;
+}
+
+bool CompressedImage::parseKTX()
+{
+    KTXHeader header;
+    if (mSize < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, mData, sizeof(header));
+
+    // only single 2D images of compressed formats, in native byte order
+    if (header.endianness != KTX_ENDIANNESS
+            || header.glType != 0
+            || header.pixelWidth == 0
+            || header.pixelHeight == 0
+            || header.pixelDepth != 0
+            || header.numberOfArrayElements != 0
+            || header.numberOfFaces != 1
+            || getBlockSizeBytes(header.glInternalFormat) == 0) {
+        return false;
+    }
+
+    mFormat = header.glInternalFormat;
+
+    size_t offset = sizeof(header) + header.bytesOfKeyValueData;
+    uint32_t numLevels = std::max(header.numberOfMipmapLevels, 1u);
+    uint32_t width = header.pixelWidth;
+    uint32_t height = header.pixelHeight;
+
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        uint32_t imageSize;
+        if (offset + sizeof(imageSize) > mSize) {
+            return false;
+        }
+        memcpy(&imageSize, mData + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+
+        if (imageSize != getLevelSizeBytes(mFormat, width, height)
+                || offset + imageSize > mSize) {
+            return false;
+        }
+
+        mLevels.push_back({ width, height, mData + offset, imageSize });
+
+        // mipPadding; compressed levels are multiples of 8 bytes anyway
+        offset += (imageSize + 3) / 4 * 4;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    return true;
+}
+
+bool CompressedImage::parseDDS()
+{
+    DDSHeader header;
+    if (mSize < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, mData, sizeof(header));
+
+    if (header.size != sizeof(header) - sizeof(header.magic)
+            || !(header.pixelFormat.flags & DDPF_FOURCC)) {
+        return false;
+    }
+
+    size_t offset = sizeof(header);
+    if (header.pixelFormat.fourCC == fourCC("DX10")) {
+        DDSHeaderDX10 dx10;
+        if (mSize < offset + sizeof(dx10)) {
+            return false;
+        }
+        memcpy(&dx10, mData + offset, sizeof(dx10));
+        offset += sizeof(dx10);
+
+        if (dx10.arraySize > 1) {
+            return false;
+        }
+        mFormat = formatFromDXGI(dx10.dxgiFormat);
+    } else {
+        mFormat = formatFromFourCC(header.pixelFormat.fourCC);
+    }
+
+    if (mFormat == 0) {
+        return false;
+    }
+
+    return addLevels(header.width, header.height,
+                     std::max(header.mipMapCount, 1u), offset);
+}
+
+bool CompressedImage::addLevels(uint32_t width,
+                                uint32_t height,
+                                uint32_t numLevels,
+                                size_t offset)
+{
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    for (uint32_t level = 0; level < numLevels; ++level) {
+        size_t size = getLevelSizeBytes(mFormat, width, height);
+        if (offset + size > mSize) {
+            return false;
+        }
+
+        mLevels.push_back({ width, height, mData + offset, size });
+
+        offset += size;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    return true;
+}
+
+bool CompressedImage::isFormatSupported(GLenum format)
+{
+    switch (format) {
+    case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        return GLEW_EXT_texture_compression_s3tc;
+    case GL_COMPRESSED_RED_RGTC1:
+    case GL_COMPRESSED_RG_RGTC2:
+        // core since GL 3.0
+        return true;
+    case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        return GLEW_VERSION_4_2 || GLEW_ARB_texture_compression_bptc;
+    case GL_COMPRESSED_RGB8_ETC2:
+    case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+    case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        // usually decompressed by the driver on desktop GPUs, which still
+        // saves decoding and mip generation, but not VRAM
+        return GLEW_VERSION_4_3 || GLEW_ARB_ES3_compatibility;
+    default:
+        return false;
+    }
+}
+
+bool CompressedImage::isCompressedFile(const std::string& path)
+{
+    size_t dot = path.rfind('.');
+    if (dot == std::string::npos) {
+        return false;
+    }
+
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   ::tolower);
+    return extension == "ktx" || extension == "dds";
+}
+
+} // namespace sb
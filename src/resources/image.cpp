@@ -8,6 +8,13 @@
 
 namespace sb
 {
+    std::unique_lock<std::recursive_mutex> Image::lockDevIL()
+    {
+        // recursive, as some methods call others
+        static std::recursive_mutex mutex;
+        return std::unique_lock<std::recursive_mutex>(mutex);
+    }
+
     Image::Image(): mId(0u) {}
 
     Image::Image(const std::string& file):
@@ -20,6 +27,7 @@ namespace sb
 
     Image::~Image()
     {
+        auto lock = lockDevIL();
         IL_CHECK(ilBindImage(mId));
         IL_CHECK(ilDeleteImage(mId));
     }
@@ -38,6 +46,7 @@ namespace sb
 
     Image& Image::operator =(const Image& copy)
     {
+        auto lock = lockDevIL();
         IL_CHECK(mId = ilGenImage());
         IL_CHECK(ilBindImage(mId));
         IL_CHECK(ilCopyImage(copy.mId));
@@ -53,6 +62,7 @@ namespace sb
 
     bool Image::loadFromFile(const std::string& file)
     {
+        auto lock = lockDevIL();
         gLog.info("loading image %s\n", file.c_str());
 
         IL_CHECK(mId = ilGenImage());
@@ -67,14 +77,38 @@ namespace sb
         return true;
     }
 
+    bool Image::loadFromMemory(const void* data,
+                               size_t sizeBytes,
+                               const std::string& name)
+    {
+        auto lock = lockDevIL();
+        gLog.info("loading image %s from memory\n", name.c_str());
+
+        IL_CHECK(mId = ilGenImage());
+        IL_CHECK_RET(ilBindImage(mId), false);
+        // format is guessed from the header, as ilLoadImage does
+        IL_CHECK_RET(ilLoadL(IL_TYPE_UNKNOWN, data, (ILuint)sizeBytes), false);
+
+        return true;
+    }
+
     uint32_t Image::getWidth()
     {
+        auto lock = lockDevIL();
         IL_CHECK(ilBindImage(mId));
         return ilGetInteger(IL_IMAGE_WIDTH);
     }
 
+    size_t Image::getSizeBytes()
+    {
+        auto lock = lockDevIL();
+        IL_CHECK(ilBindImage(mId));
+        return (size_t)ilGetInteger(IL_IMAGE_SIZE_OF_DATA);
+    }
+
     uint32_t Image::getHeight()
     {
+        auto lock = lockDevIL();
         IL_CHECK(ilBindImage(mId));
         return ilGetInteger(IL_IMAGE_HEIGHT);
     }
@@ -82,6 +116,7 @@ namespace sb
     void Image::scale(uint32_t newWidth,
                       uint32_t newHeight)
     {
+        auto lock = lockDevIL();
         IL_CHECK(ilBindImage(mId));
 
         uint32_t width = ilGetInteger(IL_IMAGE_WIDTH);
@@ -99,6 +134,7 @@ namespace sb
 
     void* Image::getRGBAData()
     {
+        auto lock = lockDevIL();
         IL_CHECK(ilBindImage(mId));
 
         if (ilGetInteger(IL_IMAGE_FORMAT) != IL_RGBA) {
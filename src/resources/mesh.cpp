@@ -2,8 +2,11 @@
 
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
 #include <sandbox/resources/resourceMgr.h>
 
+#include <algorithm>
+
 namespace sb
 {
     Mesh::Mesh(Shape shape,
@@ -12,11 +15,264 @@ namespace sb
                const std::vector<Color>& colors,
                const std::vector<Vec3>& normals,
                const std::vector<uint32_t>& indices,
-               std::shared_ptr<Texture> texture):
-        mVertexBuffer(vertices, texcoords, colors, normals),
-        mIndexBuffer(indices),
+               std::shared_ptr<Texture> texture,
+               const VertexLayout& layout):
+        mVertexBuffer(),
+        mIndexBuffer(),
+        mArena(),
+        mAllocation(),
+        mBoundingSphereCenter(0.0f, 0.0f, 0.0f),
+        mBoundingSphereRadius(0.0f),
         mIndexBufferSize(indices.size()),
+        mIndexType(0),
         mShape(shape),
-        mTexture(texture)
-    {}
+        mTexture(texture),
+        mRevision(0)
+    {
+        computeBoundingSphere(vertices);
+
+        if (layout.storage == VertexLayout::Storage::Interleaved) {
+            VertexSources sources(vertices, texcoords, colors, normals);
+
+            mArena = GeometryArena::get(layout, sources.attribs);
+            mAllocation = mArena->allocate(layout.interleave(sources), indices);
+            mIndexType = mAllocation.indexType;
+        } else {
+            mVertexBuffer.reset(new VertexBuffer(vertices, texcoords,
+                                                 colors, normals, layout));
+            mIndexBuffer.reset(new IndexBuffer(indices));
+            mIndexType = mIndexBuffer->getType();
+        }
+    }
+
+    Mesh::Mesh(Shape shape,
+               const std::vector<Attrib::Kind>& attribs,
+               const void* vertexData,
+               size_t numVertices,
+               const void* indexData,
+               size_t numIndices,
+               GLenum indexType,
+               const Vec3& boundingSphereCenter,
+               float boundingSphereRadius,
+               std::shared_ptr<Texture> texture):
+        mVertexBuffer(),
+        mIndexBuffer(),
+        mArena(GeometryArena::get(VertexLayout::packed(), attribs)),
+        mAllocation(mArena->allocate(vertexData, numVertices,
+                                     indexData, numIndices, indexType)),
+        mBoundingSphereCenter(boundingSphereCenter),
+        mBoundingSphereRadius(boundingSphereRadius),
+        mIndexBufferSize(numIndices),
+        mIndexType(indexType),
+        mShape(shape),
+        mTexture(texture),
+        mRevision(0)
+    {
+    }
+
+    // centered at the middle of AABB; not minimal, but good enough for culling
+    void Mesh::getBoundingSphere(const std::vector<Vec3>& vertices,
+                                 Vec3& outCenter,
+                                 float& outRadius)
+    {
+        outCenter = Vec3(0.0f, 0.0f, 0.0f);
+        outRadius = 0.0f;
+        if (vertices.empty()) {
+            return;
+        }
+
+        Vec3 min = vertices[0];
+        Vec3 max = vertices[0];
+        for (const Vec3& v: vertices) {
+            min = Vec3(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
+            max = Vec3(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+        }
+
+        outCenter = (min + max) * 0.5f;
+        for (const Vec3& v: vertices) {
+            outRadius = std::max(outRadius, (v - outCenter).length());
+        }
+    }
+
+    void Mesh::computeBoundingSphere(const std::vector<Vec3>& vertices)
+    {
+        if (!vertices.empty()) {
+            getBoundingSphere(vertices, mBoundingSphereCenter,
+                              mBoundingSphereRadius);
+        }
+    }
+
+    void Mesh::growBoundingSphere(const std::vector<Vec3>& vertices)
+    {
+        for (const Vec3& v: vertices) {
+            mBoundingSphereRadius = std::max(mBoundingSphereRadius,
+                                             (v - mBoundingSphereCenter).length());
+        }
+    }
+
+    Mesh::~Mesh()
+    {
+        if (mArena) {
+            mArena->free(mAllocation);
+        }
+    }
+
+    void Mesh::bind() const
+    {
+        if (mArena) {
+            mArena->bind();
+        } else {
+            mVertexBuffer->bind();
+            mIndexBuffer->bind();
+        }
+    }
+
+    void Mesh::unbind() const
+    {
+        if (mArena) {
+            mArena->unbind();
+        } else {
+            mIndexBuffer->unbind();
+            mVertexBuffer->unbind();
+        }
+    }
+
+    void Mesh::draw() const
+    {
+        if (mArena) {
+            GL_CHECK(glDrawElementsBaseVertex(
+                    (GLenum)mShape, (GLsizei)mIndexBufferSize, mIndexType,
+                    (void*)mAllocation.indexOffsetBytes,
+                    (GLint)mAllocation.baseVertex));
+        } else {
+            GL_CHECK(glDrawElements((GLenum)mShape, (GLsizei)mIndexBufferSize,
+                                    mIndexType, (void*)NULL));
+        }
+    }
+
+    void Mesh::updateVertices(size_t firstVertex,
+                              const std::vector<Vec3>& vertices,
+                              const std::vector<Vec2>& texcoords,
+                              const std::vector<Color>& colors,
+                              const std::vector<Vec3>& normals,
+                              Buffer::WriteMode mode)
+    {
+        if (vertices.empty()) {
+            return;
+        }
+
+        VertexSources sources(vertices, texcoords, colors, normals);
+        sbAssert(sources.attribs == getAttribs(),
+                 "mesh attributes cannot change on update");
+
+        if (mArena) {
+            mArena->writeVertices(mAllocation, firstVertex,
+                                  mArena->getLayout().interleave(sources), mode);
+        } else {
+            mVertexBuffer->write(firstVertex, sources, mode);
+        }
+
+        growBoundingSphere(vertices);
+        ++mRevision;
+    }
+
+    void Mesh::updateIndices(size_t firstIndex,
+                             const std::vector<uint32_t>& indices,
+                             Buffer::WriteMode mode)
+    {
+        sbAssert(firstIndex + indices.size() <= mIndexBufferSize,
+                 "writing indices past the end of mesh");
+
+        if (mArena) {
+            mArena->writeIndices(mAllocation, firstIndex, indices, mode);
+        } else {
+            mIndexBuffer->writeIndices(firstIndex, indices, mode);
+        }
+
+        ++mRevision;
+    }
+
+    void Mesh::update(const std::vector<Vec3>& vertices,
+                      const std::vector<Vec2>& texcoords,
+                      const std::vector<Color>& colors,
+                      const std::vector<Vec3>& normals,
+                      const std::vector<uint32_t>& indices)
+    {
+        VertexSources sources(vertices, texcoords, colors, normals);
+        sbAssert(sources.attribs == getAttribs(),
+                 "mesh attributes cannot change on update");
+
+        if (mArena) {
+            std::vector<uint8_t> vertexData = mArena->getLayout().interleave(sources);
+
+            if (mArena->fits(mAllocation, vertices.size(), indices)) {
+                mArena->writeVertices(mAllocation, 0, vertexData);
+                mArena->writeIndices(mAllocation, 0, indices);
+                // capacity stays the same, so that free() releases all of it
+                mAllocation.numIndices = indices.size();
+            } else {
+                mArena->free(mAllocation);
+                mAllocation = mArena->allocate(vertexData, indices);
+            }
+            mIndexType = mAllocation.indexType;
+        } else {
+            mVertexBuffer->update(sources);
+            mIndexBuffer->setIndices(indices);
+            mIndexType = mIndexBuffer->getType();
+        }
+
+        mIndexBufferSize = indices.size();
+
+        mBoundingSphereRadius = 0.0f;
+        computeBoundingSphere(vertices);
+        ++mRevision;
+    }
+
+    void Mesh::swap(Mesh& other)
+    {
+        std::swap(mVertexBuffer, other.mVertexBuffer);
+        std::swap(mIndexBuffer, other.mIndexBuffer);
+        std::swap(mArena, other.mArena);
+        std::swap(mAllocation, other.mAllocation);
+        std::swap(mBoundingSphereCenter, other.mBoundingSphereCenter);
+        std::swap(mBoundingSphereRadius, other.mBoundingSphereRadius);
+        std::swap(mIndexBufferSize, other.mIndexBufferSize);
+        std::swap(mIndexType, other.mIndexType);
+        std::swap(mShape, other.mShape);
+        std::swap(mTexture, other.mTexture);
+
+        // not exchanged: both now hold contents they did not have before
+        ++mRevision;
+        ++other.mRevision;
+    }
+
+    size_t Mesh::getSizeBytes() const
+    {
+        if (mArena) {
+            return mAllocation.numVertices
+                       * mArena->getLayout().getStride(mArena->getAttribs())
+                   + mAllocation.indexSizeBytes;
+        }
+
+        size_t bytes = 0;
+        if (mVertexBuffer) {
+            for (const BufferKindPair& pair: mVertexBuffer->getBuffers()) {
+                bytes += pair.buffer.getSize();
+            }
+        }
+        if (mIndexBuffer) {
+            bytes += mIndexBuffer->getSize();
+        }
+        return bytes;
+    }
+
+    const std::vector<Attrib::Kind>& Mesh::getAttribs() const
+    {
+        return mArena ? mArena->getAttribs() : mVertexBuffer->getAttribs();
+    }
+
+    const void* Mesh::getVertexArrayKey() const
+    {
+        return mArena ? (const void*)mArena.get() : (const void*)mVertexBuffer.get();
+    }
 } // namespace sb
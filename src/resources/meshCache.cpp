@@ -0,0 +1,314 @@
+#include <sandbox/resources/meshCache.h>
+
+#include <sandbox/rendering/indexBuffer.h>
+#include <sandbox/utils/fileSystem.h>
+#include <sandbox/utils/hash.h>
+#include <sandbox/utils/logger.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace sb {
+namespace {
+
+const uint32_t MAGIC = 0x434d4253; // "SBMC"
+// bump whenever VertexLayout::packed() or the optimizer output changes
+const uint32_t VERSION = 1;
+// vertex blob alignment, enough for any attribute type
+const size_t DATA_ALIGNMENT = 16;
+
+// fixed-size part at the start of every entry; followed by the texture
+// names, then the vertex and index blobs at given offsets
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+
+    uint64_t sourceModificationTimeNs;
+    uint64_t sourceSizeBytes;
+    uint64_t sourceHash;
+
+    uint32_t shape;
+    uint32_t attribMask;
+    uint32_t stride;
+    uint32_t indexType;
+    uint64_t numVertices;
+    uint64_t numIndices;
+
+    float boundingSphereCenter[3];
+    float boundingSphereRadius;
+
+    uint32_t numTextureNames;
+    uint32_t textureNamesBytes;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+};
+
+size_t alignUp(size_t value,
+               size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// in the order of attribute locations, same as VertexSources::attribs
+std::vector<Attrib::Kind> attribsFromMask(uint32_t mask)
+{
+    std::vector<Attrib::Kind> attribs;
+    for (Attrib::Kind kind: { Attrib::Kind::Position, Attrib::Kind::Texcoord,
+                              Attrib::Kind::Color, Attrib::Kind::Normal }) {
+        if (mask & Attrib::getMask(kind)) {
+            attribs.push_back(kind);
+        }
+    }
+    return attribs;
+}
+
+bool hashFile(const std::string& path,
+              uint64_t& outHash)
+{
+    std::string data;
+    if (!utils::readFile(path, data)) {
+        return false;
+    }
+
+    outHash = utils::fnv1a(data.data(), data.size());
+    return true;
+}
+
+// outModificationTimeNs is set to the current one of the source file, or
+// to the one in header for in-memory sources
+bool isUpToDate(const FileHeader& header,
+                const std::string& sourcePath,
+                const void* sourceData,
+                size_t sourceSizeBytes,
+                uint64_t& outModificationTimeNs)
+{
+    outModificationTimeNs = header.sourceModificationTimeNs;
+    if (sourceData) {
+        return sourceSizeBytes == header.sourceSizeBytes
+               && utils::fnv1a(sourceData, sourceSizeBytes) == header.sourceHash;
+    }
+
+    uint64_t size;
+    if (!utils::getFileInfo(sourcePath, outModificationTimeNs, size)
+            || size != header.sourceSizeBytes) {
+        return false;
+    }
+    if (outModificationTimeNs == header.sourceModificationTimeNs) {
+        return true;
+    }
+
+    // touched, e.g. by a checkout; only rehash in that case
+    uint64_t hash;
+    return hashFile(sourcePath, hash) && hash == header.sourceHash;
+}
+
+// overwrites the source modification time in the header of an entry in
+// place, so that a touched but unchanged source is hashed only once
+void updateModificationTime(const std::string& path,
+                            uint64_t modificationTimeNs)
+{
+    FILE* file = fopen(path.c_str(), "r+b");
+    if (!file) {
+        return;
+    }
+
+    if (fseek(file, offsetof(FileHeader, sourceModificationTimeNs), SEEK_SET) != 0
+            || fwrite(&modificationTimeNs, sizeof(modificationTimeNs), 1, file) != 1) {
+        gLog.warn("cannot update mesh cache entry: %s", path.c_str());
+    }
+    fclose(file);
+}
+
+// fills everything but the data pointers; false if header is malformed
+bool readHeader(const MappedFile& file,
+                const FileHeader& header,
+                MeshCache::Entry& entry)
+{
+    if (header.magic != MAGIC || header.version != VERSION) {
+        return false;
+    }
+
+    entry.attribs = attribsFromMask(header.attribMask);
+    if (entry.attribs.empty()
+            || header.stride != VertexLayout::packed().getStride(entry.attribs)
+            || (header.indexType != GL_UNSIGNED_SHORT
+                && header.indexType != GL_UNSIGNED_INT)) {
+        return false;
+    }
+
+    const uint64_t vertexBytes = header.numVertices * header.stride;
+    const uint64_t indexBytes = header.numIndices
+                                * getIndexSize(header.indexType);
+    if (header.vertexOffset % DATA_ALIGNMENT != 0
+            || header.vertexOffset + vertexBytes > file.getSize()
+            || header.indexOffset + indexBytes > file.getSize()
+            || sizeof(FileHeader) + header.textureNamesBytes > file.getSize()) {
+        return false;
+    }
+
+    entry.shape = (Mesh::Shape)header.shape;
+    entry.numVertices = header.numVertices;
+    entry.numIndices = header.numIndices;
+    entry.indexType = header.indexType;
+    entry.boundingSphereCenter = Vec3(header.boundingSphereCenter[0],
+                                      header.boundingSphereCenter[1],
+                                      header.boundingSphereCenter[2]);
+    entry.boundingSphereRadius = header.boundingSphereRadius;
+
+    // names are stored NUL-terminated, one after another
+    const char* names = (const char*)file.getData() + sizeof(FileHeader);
+    const char* namesEnd = names + header.textureNamesBytes;
+    entry.textureNames.clear();
+    for (uint32_t i = 0; i < header.numTextureNames; ++i) {
+        const char* end = (const char*)memchr(names, '\0', namesEnd - names);
+        if (!end) {
+            return false;
+        }
+        entry.textureNames.push_back(std::string(names, end));
+        names = end + 1;
+    }
+
+    return true;
+}
+
+} // namespace
+
+MeshCache::MeshCache(const std::string& directory):
+    mDirectory(directory)
+{
+    if (mDirectory.empty()) {
+        return;
+    }
+
+    if (!utils::makeDirectories(mDirectory)) {
+        gLog.warn("cannot create mesh cache directory %s: %s",
+                  mDirectory.c_str(), strerror(errno));
+        mDirectory.clear();
+        return;
+    }
+
+    gLog.trace("mesh cache: %s", mDirectory.c_str());
+}
+
+std::string MeshCache::getDefaultDirectory()
+{
+    return utils::getCacheDirectory("meshes");
+}
+
+std::string MeshCache::getPath(const std::string& sourcePath) const
+{
+    char name[sizeof("0123456789abcdef.mesh")];
+    snprintf(name, sizeof(name), "%016llx.mesh",
+             (unsigned long long)utils::fnv1a(sourcePath));
+    return mDirectory + "/" + name;
+}
+
+bool MeshCache::load(const std::string& sourcePath,
+                     Entry& outEntry,
+                     const void* sourceData,
+                     size_t sourceSizeBytes) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(getPath(sourcePath))) {
+        return false;
+    }
+
+    if (file->getSize() < sizeof(FileHeader)) {
+        gLog.warn("invalid mesh cache entry: %s", getPath(sourcePath).c_str());
+        return false;
+    }
+
+    FileHeader header;
+    memcpy(&header, file->getData(), sizeof(header));
+    if (!readHeader(*file, header, outEntry)) {
+        gLog.warn("invalid mesh cache entry: %s", getPath(sourcePath).c_str());
+        return false;
+    }
+
+    uint64_t modificationTimeNs;
+    if (!isUpToDate(header, sourcePath, sourceData, sourceSizeBytes,
+                    modificationTimeNs)) {
+        gLog.trace("mesh cache entry for %s is stale", sourcePath.c_str());
+        return false;
+    }
+    if (modificationTimeNs != header.sourceModificationTimeNs) {
+        updateModificationTime(getPath(sourcePath), modificationTimeNs);
+    }
+
+    outEntry.vertexData = file->getData() + header.vertexOffset;
+    outEntry.indexData = file->getData() + header.indexOffset;
+    outEntry.file = file;
+    return true;
+}
+
+void MeshCache::store(const std::string& sourcePath,
+                      const Entry& entry,
+                      const void* sourceData,
+                      size_t sourceSizeBytes) const
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.version = VERSION;
+
+    if (sourceData) {
+        // no modification time, always compared by hash
+        header.sourceSizeBytes = sourceSizeBytes;
+        header.sourceHash = utils::fnv1a(sourceData, sourceSizeBytes);
+    } else if (!utils::getFileInfo(sourcePath, header.sourceModificationTimeNs,
+                                   header.sourceSizeBytes)
+               || !hashFile(sourcePath, header.sourceHash)) {
+        gLog.warn("cannot read mesh source %s, not caching it",
+                  sourcePath.c_str());
+        return;
+    }
+
+    std::string names;
+    for (const std::string& name: entry.textureNames) {
+        names.append(name.c_str(), name.size() + 1);
+    }
+
+    const size_t stride = VertexLayout::packed().getStride(entry.attribs);
+    const size_t vertexBytes = entry.numVertices * stride;
+    const size_t indexBytes = entry.numIndices * getIndexSize(entry.indexType);
+
+    header.shape = (uint32_t)entry.shape;
+    header.attribMask = Attrib::getMask(entry.attribs);
+    header.stride = (uint32_t)stride;
+    header.indexType = entry.indexType;
+    header.numVertices = entry.numVertices;
+    header.numIndices = entry.numIndices;
+    header.boundingSphereCenter[0] = entry.boundingSphereCenter.x;
+    header.boundingSphereCenter[1] = entry.boundingSphereCenter.y;
+    header.boundingSphereCenter[2] = entry.boundingSphereCenter.z;
+    header.boundingSphereRadius = entry.boundingSphereRadius;
+    header.numTextureNames = (uint32_t)entry.textureNames.size();
+    header.textureNamesBytes = (uint32_t)names.size();
+    header.vertexOffset = alignUp(sizeof(header) + names.size(), DATA_ALIGNMENT);
+    header.indexOffset = alignUp(header.vertexOffset + vertexBytes,
+                                 DATA_ALIGNMENT);
+
+    std::string data(header.indexOffset + indexBytes, '\0');
+    memcpy(&data[0], &header, sizeof(header));
+    memcpy(&data[sizeof(header)], names.data(), names.size());
+    memcpy(&data[header.vertexOffset], entry.vertexData, vertexBytes);
+    memcpy(&data[header.indexOffset], entry.indexData, indexBytes);
+
+    const std::string path = getPath(sourcePath);
+    if (!utils::writeFileAtomic(path, data)) {
+        gLog.warn("cannot write mesh cache entry: %s", path.c_str());
+    }
+}
+
+} // namespace sb
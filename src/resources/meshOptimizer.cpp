@@ -0,0 +1,352 @@
+#include <sandbox/resources/meshOptimizer.h>
+
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace sb {
+namespace meshopt {
+namespace {
+
+const size_t NO_TRIANGLE = ~(size_t)0;
+
+// parameters from Forsyth's paper
+const size_t FORSYTH_CACHE_SIZE = 32;
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+float forsythScore(int32_t cachePosition,
+                   uint32_t remainingTriangles)
+{
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePosition < 0) {
+        // not in cache
+    } else if (cachePosition < 3) {
+        // used by the last triangle; fixed score so that the algorithm does
+        // not favor any of its edges
+        score = LAST_TRIANGLE_SCORE;
+    } else {
+        const float scaler = 1.0f / (float)(FORSYTH_CACHE_SIZE - 3);
+        score = std::pow(1.0f - (float)(cachePosition - 3) * scaler,
+                         CACHE_DECAY_POWER);
+    }
+
+    // prefer vertices with few triangles left, to avoid leaving lone
+    // triangles that would have to be picked up later
+    score += VALENCE_BOOST_SCALE
+             * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+// simulates a FIFO cache by tracking the time each vertex was last loaded
+class FifoCache
+{
+public:
+    FifoCache(size_t numVertices,
+              size_t cacheSize):
+        mTimestamps(numVertices, 0),
+        mTime((uint32_t)cacheSize + 1),
+        mCacheSize((uint32_t)cacheSize)
+    {}
+
+    // returns true on cache miss
+    bool access(uint32_t vertex)
+    {
+        if (mTime - mTimestamps[vertex] > mCacheSize) {
+            mTimestamps[vertex] = mTime++;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    std::vector<uint32_t> mTimestamps;
+    uint32_t mTime;
+    uint32_t mCacheSize;
+};
+
+struct Cluster
+{
+    size_t firstTriangle;
+    size_t numTriangles;
+    float sortKey;
+};
+
+} // namespace
+
+float computeACMR(const std::vector<uint32_t>& indices,
+                  size_t numVertices,
+                  size_t cacheSize)
+{
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+
+    FifoCache cache(numVertices, cacheSize);
+    size_t misses = 0;
+    for (uint32_t index: indices) {
+        misses += cache.access(index) ? 1 : 0;
+    }
+
+    return (float)misses / (float)(indices.size() / 3);
+}
+
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices,
+                                          size_t numVertices)
+{
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0) {
+        return indices;
+    }
+
+    // triangles using each vertex: vertexTriangles[offsets[v]..offsets[v+1]);
+    // the first remaining[v] entries are the ones not emitted yet
+    std::vector<uint32_t> remaining(numVertices, 0);
+    for (size_t i = 0; i < numTriangles * 3; ++i) {
+        ++remaining[indices[i]];
+    }
+
+    std::vector<uint32_t> offsets(numVertices + 1, 0);
+    for (size_t v = 0; v < numVertices; ++v) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+
+    std::vector<uint32_t> vertexTriangles(numTriangles * 3);
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < numTriangles * 3; ++i) {
+            vertexTriangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+        }
+    }
+
+    std::vector<int32_t> cachePosition(numVertices, -1);
+    std::vector<float> vertexScore(numVertices);
+    for (size_t v = 0; v < numVertices; ++v) {
+        vertexScore[v] = forsythScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(numTriangles, 0.0f);
+    std::vector<bool> emitted(numTriangles, false);
+    size_t bestTriangle = 0;
+    for (size_t t = 0; t < numTriangles; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            triangleScore[t] += vertexScore[indices[t * 3 + k]];
+        }
+        if (triangleScore[t] > triangleScore[bestTriangle]) {
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> newCache;
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    std::vector<uint32_t> result;
+    result.reserve(numTriangles * 3);
+
+    size_t nextUnemitted = 0;
+    while (result.size() < numTriangles * 3) {
+        if (bestTriangle == NO_TRIANGLE) {
+            // no candidate in cache; the paper suggests a full scan, but
+            // picking any remaining triangle is nearly as good and O(n)
+            while (emitted[nextUnemitted]) {
+                ++nextUnemitted;
+            }
+            bestTriangle = nextUnemitted;
+        }
+
+        emitted[bestTriangle] = true;
+        newCache.clear();
+
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t v = indices[bestTriangle * 3 + k];
+            result.push_back(v);
+
+            uint32_t* begin = &vertexTriangles[offsets[v]];
+            uint32_t* end = begin + remaining[v];
+            uint32_t* it = std::find(begin, end, (uint32_t)bestTriangle);
+            sbAssert(it != end, "triangle not found in vertex adjacency");
+            std::iter_swap(it, end - 1);
+            --remaining[v];
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                newCache.push_back(v);
+            }
+        }
+
+        // less than 3 for degenerate triangles
+        const size_t numTriangleVertices = newCache.size();
+        for (uint32_t v: cache) {
+            auto triangleEnd = newCache.begin() + numTriangleVertices;
+            if (std::find(newCache.begin(), triangleEnd, v) == triangleEnd) {
+                newCache.push_back(v);
+            }
+        }
+
+        // vertices pushed out of the cache get a position of -1
+        for (size_t i = 0; i < newCache.size(); ++i) {
+            uint32_t v = newCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? (int32_t)i : -1;
+
+            float score = forsythScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            for (uint32_t j = 0; j < remaining[v]; ++j) {
+                triangleScore[vertexTriangles[offsets[v] + j]] += delta;
+            }
+        }
+
+        if (newCache.size() > FORSYTH_CACHE_SIZE) {
+            newCache.resize(FORSYTH_CACHE_SIZE);
+        }
+        cache.swap(newCache);
+
+        bestTriangle = NO_TRIANGLE;
+        float bestScore = -1.0f;
+        for (uint32_t v: cache) {
+            for (uint32_t j = 0; j < remaining[v]; ++j) {
+                uint32_t t = vertexTriangles[offsets[v] + j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> optimizeOverdraw(const std::vector<uint32_t>& indices,
+                                       const std::vector<Vec3>& positions,
+                                       float threshold)
+{
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0) {
+        return indices;
+    }
+
+    const float meshACMR = computeACMR(indices, positions.size());
+
+    // a cluster ends on a "hard" boundary, where the cache has to be
+    // refilled from scratch anyway, or when it is long enough for its ACMR
+    // to fall within threshold of the whole mesh
+    std::vector<Cluster> clusters;
+    {
+        FifoCache cache(positions.size(), DEFAULT_CACHE_SIZE);
+        size_t clusterStart = 0;
+        size_t clusterMisses = 0;
+
+        for (size_t t = 0; t < numTriangles; ++t) {
+            size_t misses = 0;
+            for (size_t k = 0; k < 3; ++k) {
+                misses += cache.access(indices[t * 3 + k]) ? 1 : 0;
+            }
+
+            if (t > clusterStart && misses == 3) {
+                clusters.push_back({ clusterStart, t - clusterStart, 0.0f });
+                clusterStart = t;
+                clusterMisses = 0;
+            }
+
+            clusterMisses += misses;
+
+            size_t clusterSize = t + 1 - clusterStart;
+            if ((float)clusterMisses / (float)clusterSize <= threshold * meshACMR) {
+                clusters.push_back({ clusterStart, clusterSize, 0.0f });
+                clusterStart = t + 1;
+                clusterMisses = 0;
+            }
+        }
+
+        if (clusterStart < numTriangles) {
+            clusters.push_back({ clusterStart, numTriangles - clusterStart, 0.0f });
+        }
+    }
+
+    // area-weighted centroids and normals
+    Vec3 meshCentroid(0.0f, 0.0f, 0.0f);
+    float meshArea = 0.0f;
+    std::vector<Vec3> clusterCentroids(clusters.size());
+    std::vector<Vec3> clusterNormals(clusters.size());
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        Vec3 centroid(0.0f, 0.0f, 0.0f);
+        Vec3 normal(0.0f, 0.0f, 0.0f);
+        float area = 0.0f;
+
+        for (size_t t = clusters[c].firstTriangle;
+                t < clusters[c].firstTriangle + clusters[c].numTriangles;
+                ++t) {
+            const Vec3& p0 = positions[indices[t * 3]];
+            const Vec3& p1 = positions[indices[t * 3 + 1]];
+            const Vec3& p2 = positions[indices[t * 3 + 2]];
+
+            Vec3 triangleNormal = (p1 - p0).cross(p2 - p0);
+            float triangleArea = triangleNormal.length();
+
+            centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            normal += triangleNormal;
+            area += triangleArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+
+        clusterCentroids[c] = area > 0.0f ? centroid / area : centroid;
+        clusterNormals[c] = normal.length() > 0.0f ? normal.normalized() : normal;
+    }
+
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].sortKey = (clusterCentroids[c] - meshCentroid)
+                                  .dot(clusterNormals[c]);
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster& a, const Cluster& b) {
+                         return a.sortKey > b.sortKey;
+                     });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const Cluster& cluster: clusters) {
+        result.insert(result.end(),
+                      indices.begin() + cluster.firstTriangle * 3,
+                      indices.begin() + (cluster.firstTriangle
+                                         + cluster.numTriangles) * 3);
+    }
+
+    return result;
+}
+
+std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices,
+                                          size_t numVertices)
+{
+    std::vector<uint32_t> remap(numVertices, ~0u);
+    uint32_t nextVertex = 0;
+
+    for (uint32_t& index: indices) {
+        if (remap[index] == ~0u) {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    return remap;
+}
+
+} // namespace meshopt
+} // namespace sb
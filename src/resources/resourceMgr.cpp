@@ -1,7 +1,11 @@
 #include <fstream>
+#include <sstream>
 #include <array>
+#include <limits>
 
+#include <assimp/DefaultIOSystem.h>
 #include <assimp/Importer.hpp>
+#include <assimp/IOStream.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
@@ -9,119 +13,190 @@
 #include <IL/ilu.h>
 
 #include <sandbox/resources/resourceMgr.h>
-
+#include <sandbox/resources/builtinShaders.h>
+#include <sandbox/resources/compressedImage.h>
+#include <sandbox/resources/meshCache.h>
+#include <sandbox/resources/meshOptimizer.h>
+#include <sandbox/resources/resourcePack.h>
+#include <sandbox/rendering/uploadContext.h>
+
+#include <sandbox/utils/fileSystem.h>
 #include <sandbox/utils/lib.h>
 #include <sandbox/utils/stringUtils.h>
 #include <sandbox/utils/types.h>
 #include <sandbox/utils/logger.h>
+#include <sandbox/utils/timer.h>
 
 #include <sandbox/resources/mesh.h>
 #include <sandbox/resources/image.h>
 #include <sandbox/resources/font.h>
 
 namespace sb {
-
-SINGLETON_INSTANCE(ResourceMgr);
-
-std::shared_ptr<Texture> ResourceMgr::getDefaultTexture()
+namespace {
+
+const uint32_t TEXTURE_ARRAY_PAGE_LAYERS = 16;
+
+// initial budgets; images are mostly kept around as a source of textures,
+// so they get little
+const size_t DEFAULT_TEXTURE_BUDGET_BYTES = 512 * 1024 * 1024;
+const size_t DEFAULT_IMAGE_BUDGET_BYTES = 64 * 1024 * 1024;
+const size_t DEFAULT_MESH_BUDGET_BYTES = 256 * 1024 * 1024;
+const size_t DEFAULT_TERRAIN_BUDGET_BYTES = 128 * 1024 * 1024;
+
+// reorders triangles for vertex cache and overdraw, then vertices for fetch
+// locality; indices must form a triangle list
+void optimizeMesh(const std::string& name,
+                  std::vector<Vec3>& vertices,
+                  std::vector<Vec2>& texcoords,
+                  std::vector<Vec3>& normals,
+                  std::vector<uint32_t>& indices)
 {
-    return getTexture("default.png");
-}
+    float acmrBefore = meshopt::computeACMR(indices, vertices.size());
 
-ResourceMgr::ResourceMgr(const std::string& basePath):
-    mBasePath(basePath),
-    mTextures(""),
-    mImages(mBasePath + "image/"),
-    mMeshes(mBasePath + "mesh/"),
-    mTerrains(""),
-    mFonts(mBasePath + "font/"),
-    mVertexShaders(mBasePath + "shader/"),
-    mFragmentShaders(mBasePath + "shader/"),
-    mGeometryShaders(mBasePath + "shader/"),
-    mShaderPrograms()
-{
-    GLint maxTexSize;
-    GL_CHECK(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize));
-    gLog.trace("max texture size: %d\n", maxTexSize);
+    indices = meshopt::optimizeVertexCache(indices, vertices.size());
+    indices = meshopt::optimizeOverdraw(indices, vertices);
 
-    ilInit();
-    iluInit();
+    std::vector<uint32_t> remap = meshopt::optimizeVertexFetch(indices,
+                                                               vertices.size());
+    meshopt::remapVertices(vertices, remap);
+    meshopt::remapVertices(texcoords, remap);
+    meshopt::remapVertices(normals, remap);
 
-    std::vector<Vec3> lineVertices {
-        { 0.f, 0.f, 0.f },
-        { 1.f, 1.f, 1.f }
-    };
+    gLog.info("%s: %lu triangles, ACMR %.3f -> %.3f",
+              name.c_str(), indices.size() / 3, acmrBefore,
+              meshopt::computeACMR(indices, vertices.size()));
+}
 
-    std::vector<uint32_t> lineIndices { 0, 1 };
+// CPU-side mesh; decoded on loader threads for async loads
+struct MeshData
+{
+    Mesh::Shape shape;
+    std::vector<Vec3> vertices;
+    std::vector<Vec2> texcoords;
+    std::vector<Color> colors;
+    std::vector<Vec3> normals;
+    std::vector<uint32_t> indices;
+    // diffuse texture referenced by the model file, if any
+    std::string textureName;
+    // set instead of the vectors above if loaded from MeshCache
+    MeshCache::Entry cached;
 
-    std::vector<Vec3> quadVertices {
-        { -1.f, -1.f, 0.f },
-        { -1.f,  1.f, 0.f },
-        {  1.f, -1.f, 0.f },
-        {  1.f,  1.f, 0.f }
-    };
+    MeshData(): shape(Mesh::Shape::Triangle), cached() {}
 
-    std::vector<Vec2> quadTexcoords {
-        { 0.f, 0.f },
-        { 0.f, 1.f },
-        { 1.f, 0.f },
-        { 1.f, 1.f }
-    };
+    std::shared_ptr<Mesh> create(const std::shared_ptr<Texture>& texture) const
+    {
+        if (cached.file) {
+            return std::make_shared<Mesh>(
+                    cached.shape, cached.attribs,
+                    cached.vertexData, cached.numVertices,
+                    cached.indexData, cached.numIndices, cached.indexType,
+                    cached.boundingSphereCenter, cached.boundingSphereRadius,
+                    texture);
+        }
 
-    std::vector<uint32_t> quadIndices { 0, 1, 2, 3 };
+        return std::make_shared<Mesh>(shape, vertices, texcoords, colors,
+                                      normals, indices, texture);
+    }
+};
 
-    auto line = std::make_shared<Mesh>(Mesh::Shape::Line,
-                                       lineVertices, std::vector<Vec2>(),
-                                       std::vector<Color>(), std::vector<Vec3>(),
-                                       lineIndices, std::shared_ptr<Texture>());
-    mMeshes.addSpecial("line", line);
+// packed file, read straight from the pack mapping
+class PackIOStream: public Assimp::IOStream
+{
+public:
+    PackIOStream(const uint8_t* data,
+                 size_t sizeBytes):
+        mData(data),
+        mSize(sizeBytes),
+        mPosition(0)
+    {}
+
+    size_t Read(void* buffer,
+                size_t size,
+                size_t count) override
+    {
+        if (size == 0) {
+            return 0;
+        }
 
-    auto quad = std::make_shared<Mesh>(Mesh::Shape::TriangleStrip,
-                                       quadVertices, quadTexcoords,
-                                       std::vector<Color>(), std::vector<Vec3>(),
-                                       quadIndices, std::shared_ptr<Texture>());
-    mMeshes.addSpecial("quad", quad);
+        count = std::min(count, (mSize - mPosition) / size);
+        memcpy(buffer, mData + mPosition, size * count);
+        mPosition += size * count;
+        return count;
+    }
 
-}
+    size_t Write(const void*, size_t, size_t) override { return 0; }
 
-void ResourceMgr::freeAll()
-{
-    mTextures.freeAll();
-    mImages.freeAll();
-    mMeshes.freeAll();
-    mTerrains.freeAll();
+    aiReturn Seek(size_t offset,
+                  aiOrigin origin) override
+    {
+        size_t position;
+        switch (origin) {
+        case aiOrigin_SET: position = offset; break;
+        case aiOrigin_CUR: position = mPosition + offset; break;
+        case aiOrigin_END: position = mSize - offset; break;
+        default: return aiReturn_FAILURE;
+        }
 
-    mVertexShaders.freeAll();
-    mFragmentShaders.freeAll();
-    mGeometryShaders.freeAll();
+        if (position > mSize) {
+            return aiReturn_FAILURE;
+        }
+        mPosition = position;
+        return aiReturn_SUCCESS;
+    }
 
-    gLog.trace("all resources freed\n");
-}
+    size_t Tell() const override { return mPosition; }
+    size_t FileSize() const override { return mSize; }
+    void Flush() override {}
 
+private:
+    const uint8_t* mData;
+    size_t mSize;
+    size_t mPosition;
+};
 
-std::shared_ptr<Image> ResourceMgr::loadImage(const std::string& name)
+// serves the model and files it references, like .mtl materials, from the
+// resource pack; anything not packed comes from disk
+class PackIOSystem: public Assimp::DefaultIOSystem
 {
-    std::shared_ptr<Image> img = std::make_shared<Image>();
-    if (img->loadFromFile(name)) {
-        return img;
+public:
+    explicit PackIOSystem(const ResourcePack& pack):
+        mPack(pack)
+    {}
+
+    bool Exists(const char* path) const override
+    {
+        const uint8_t* data;
+        size_t size;
+        return mPack.find(path, data, size)
+               || Assimp::DefaultIOSystem::Exists(path);
     }
 
-    gLog.err("cannot load image %s\n", name.c_str());
-    return std::make_shared<Image>();
-}
+    Assimp::IOStream* Open(const char* path,
+                           const char* mode) override
+    {
+        const uint8_t* data;
+        size_t size;
+        if (!strchr(mode, 'w') && mPack.find(path, data, size)) {
+            return new PackIOStream(data, size);
+        }
+        return Assimp::DefaultIOSystem::Open(path, mode);
+    }
 
-std::shared_ptr<Texture> ResourceMgr::loadTexture(const std::string& name)
-{
-    gLog.trace("loading texture %s\n", name.c_str());
-    return std::make_shared<Texture>(gResourceMgr.getImage(name));
-}
+private:
+    const ResourcePack& mPack;
+};
 
-std::shared_ptr<Mesh> ResourceMgr::loadMesh(const std::string& name)
+// touches neither GL nor ResourceMgr, so it can run on any thread
+bool decodeMesh(const ResourcePack& pack,
+                const std::string& name,
+                MeshData& outData)
 {
-    gLog.trace("loading mesh %s\n", name.c_str());
-
     // TODO: wiele tekstur
     Assimp::Importer importer;
+    if (pack.isOpen()) {
+        // the importer owns and deletes it
+        importer.SetIOHandler(new PackIOSystem(pack));
+    }
     const uint32_t importerFlags = aiProcess_Triangulate
                                    | aiProcess_JoinIdenticalVertices
                                    | aiProcess_SortByPType;
@@ -132,13 +207,14 @@ std::shared_ptr<Mesh> ResourceMgr::loadMesh(const std::string& name)
     sbAssert(scene->HasMeshes(), "no meshes in file: %s", name.c_str());
 
     if (!scene || !scene->HasMeshes()) {
-        return {};
+        return false;
     }
 
-    std::vector<Vec3> vertices;
-    std::vector<Vec2> texcoords;
-    std::vector<Vec3> normals;
-    std::vector<uint32_t> indices;
+    std::vector<Vec3>& vertices = outData.vertices;
+    std::vector<Vec2>& texcoords = outData.texcoords;
+    std::vector<Vec3>& normals = outData.normals;
+    std::vector<uint32_t>& indices = outData.indices;
+    bool trianglesOnly = true;
     for (uint32_t i = 0; i < scene->mNumMeshes; ++i) {
         aiMesh* mesh = scene->mMeshes[i];
 
@@ -179,50 +255,116 @@ std::shared_ptr<Mesh> ResourceMgr::loadMesh(const std::string& name)
         indices.resize(indicesSoFar + numIndices);
         numIndices = indicesSoFar;
         for (uint32_t i = 0; i < mesh->mNumFaces; ++i) {
-            memcpy(&indices[numIndices],
-                   mesh->mFaces[i].mIndices,
-                   mesh->mFaces[i].mNumIndices * sizeof(uint32_t));
-            numIndices += mesh->mFaces[i].mNumIndices;
+            const aiFace& face = mesh->mFaces[i];
+            for (uint32_t j = 0; j < face.mNumIndices; ++j) {
+                indices[numIndices + j] = (uint32_t)verticesSoFar + face.mIndices[j];
+            }
+            numIndices += face.mNumIndices;
+            trianglesOnly = trianglesOnly && face.mNumIndices == 3;
         }
     }
 
     if (vertices.empty()) {
-        return {};
+        return false;
+    }
+
+    if (trianglesOnly) {
+        optimizeMesh(name, vertices, texcoords, normals, indices);
+    } else {
+        gLog.warn("%s: not a triangle mesh, skipping optimization", name.c_str());
     }
 
     // TODO: multiple materials
     aiString filename;
-
-    std::shared_ptr<Texture> texture;
     aiMaterial* material = scene->mMaterials[0];
-    aiReturn result = material->GetTexture(aiTextureType_DIFFUSE,
-                                           0, &filename);
-    if (result == AI_SUCCESS) {
+    if (material->GetTexture(aiTextureType_DIFFUSE, 0, &filename) == AI_SUCCESS) {
         gLog.info("%s: got texture %s\n", name.c_str(), filename.data);
-        texture = gResourceMgr.getTexture(filename.data);
+        outData.textureName = filename.data;
     }
 
     gLog.trace("%s: got vertices%s%s",
                name.c_str(),
                texcoords.empty() ? "" : ", texcoords",
                normals.empty() ? "" : ", normals");
-    return std::make_shared<Mesh>(Mesh::Shape::Triangle,
-                                  vertices, texcoords,
-                                  std::vector<Color>(), normals,
-                                  indices, texture);
+    outData.shape = Mesh::Shape::Triangle;
+    return true;
 }
 
-std::shared_ptr<Mesh> ResourceMgr::loadTerrain(const std::string& heightmap)
+// stores data in the form MeshData::create uploads it, interleaved and with
+// packed indices
+void storeCachedMesh(const MeshCache& cache,
+                     const std::string& name,
+                     const MeshData& data,
+                     const void* sourceData,
+                     size_t sourceSizeBytes)
 {
-    gLog.trace("loading terrain %s\n", heightmap.c_str());
+    if (!cache.isEnabled()) {
+        return;
+    }
+
+    VertexSources sources(data.vertices, data.texcoords, data.colors,
+                          data.normals);
+    std::vector<uint8_t> vertexData = VertexLayout::packed().interleave(sources);
+    GLenum indexType = chooseIndexType(data.indices);
+    std::vector<uint8_t> indexData = packIndices(data.indices, indexType);
+
+    MeshCache::Entry entry;
+    entry.shape = data.shape;
+    entry.attribs = sources.attribs;
+    entry.vertexData = vertexData.data();
+    entry.numVertices = data.vertices.size();
+    entry.indexData = indexData.data();
+    entry.numIndices = data.indices.size();
+    entry.indexType = indexType;
+    Mesh::getBoundingSphere(data.vertices, entry.boundingSphereCenter,
+                            entry.boundingSphereRadius);
+    if (!data.textureName.empty()) {
+        entry.textureNames.push_back(data.textureName);
+    }
 
-    std::shared_ptr<Image> img = gResourceMgr.getImage(heightmap);
-    uint32_t w = img->getWidth();
-    uint32_t h = img->getHeight();
-    uint32_t* data = (uint32_t*)img->getRGBAData();
+    cache.store(name, entry, sourceData, sourceSizeBytes);
+}
+
+// decodeMesh, skipped if the cache has an up-to-date entry for the file;
+// imported meshes are added to the cache
+bool decodeMeshCached(const MeshCache& cache,
+                      const ResourcePack& pack,
+                      const std::string& name,
+                      MeshData& outData)
+{
+    // packed sources are validated by contents, as they have no mtime
+    const uint8_t* packedData = nullptr;
+    size_t packedSize = 0;
+    pack.find(name, packedData, packedSize);
+
+    if (cache.load(name, outData.cached, packedData, packedSize)) {
+        gLog.trace("%s: loaded from mesh cache", name.c_str());
+        if (!outData.cached.textureNames.empty()) {
+            outData.textureName = outData.cached.textureNames[0];
+        }
+        return true;
+    }
+
+    if (!decodeMesh(pack, name, outData)) {
+        return false;
+    }
+
+    storeCachedMesh(cache, name, outData, packedData, packedSize);
+    return true;
+}
+
+void decodeTerrain(const std::string& name,
+                   Image& image,
+                   MeshData& outData)
+{
+    uint32_t w = image.getWidth();
+    uint32_t h = image.getHeight();
+    uint32_t* data = (uint32_t*)image.getRGBAData();
 
     gLog.trace("loading terrain %s: %ux%u vertices\n",
-               heightmap.c_str(), w, h);
+               name.c_str(), w, h);
+
+    outData.shape = Mesh::Shape::Triangle;
 
 #define RGBA_TO_HEIGHT(rgba) \
 ((float)(((rgba) & 0x00ff0000) \
@@ -230,14 +372,14 @@ std::shared_ptr<Mesh> ResourceMgr::loadTerrain(const std::string& heightmap)
        | (((rgba) & 0x0000ff00) << 16)) \
     / 100000.0f)
 
-    std::vector<Vec3> vertices;
+    std::vector<Vec3>& vertices = outData.vertices;
     for (uint32_t i = 0; i < w * h; ++i) {
         vertices.emplace_back(Vec3((float)(i % w),
                                     RGBA_TO_HEIGHT(data[i]),
                                     (float)(i / w)));
     }
 
-    std::vector<Vec2> texcoords;
+    std::vector<Vec2>& texcoords = outData.texcoords;
 
     // for now, let's use tiling only
     /*switch (texturingMode)
@@ -260,7 +402,8 @@ std::shared_ptr<Mesh> ResourceMgr::loadTerrain(const std::string& heightmap)
     }*/
 
     uint32_t numIndices = (w - 1) * (h - 1) * 6;
-    std::vector<uint32_t> indices(numIndices);
+    std::vector<uint32_t>& indices = outData.indices;
+    indices.resize(numIndices);
 
     for (uint32_t x = 0; x < (w - 2); ++x) {
         for (uint32_t y = 0; y < (h - 1); ++y) {
@@ -276,20 +419,382 @@ std::shared_ptr<Mesh> ResourceMgr::loadTerrain(const std::string& heightmap)
         }
     }
 
-    std::vector<Vec3> normals; // TODO
+    // TODO: normals
+}
+
+// unit cube with every vertex attribute, so that any shader can draw it
+std::shared_ptr<Mesh> makePlaceholderMesh()
+{
+    static const Vec3 FACE_NORMALS[] = {
+        {  1.f,  0.f,  0.f }, { -1.f,  0.f,  0.f },
+        {  0.f,  1.f,  0.f }, {  0.f, -1.f,  0.f },
+        {  0.f,  0.f,  1.f }, {  0.f,  0.f, -1.f }
+    };
+
+    MeshData cube;
+    for (const Vec3& normal: FACE_NORMALS) {
+        const Vec3 u = normal.y != 0.f ? Vec3(1.f, 0.f, 0.f) : Vec3(0.f, 1.f, 0.f);
+        const Vec3 v = normal.cross(u);
+        const uint32_t base = (uint32_t)cube.vertices.size();
+
+        for (uint32_t corner = 0; corner < 4; ++corner) {
+            const float su = (corner & 1) ? 0.5f : -0.5f;
+            const float sv = (corner & 2) ? 0.5f : -0.5f;
+
+            cube.vertices.push_back(Vec3(normal * 0.5f + u * su + v * sv));
+            cube.texcoords.push_back(Vec2(su + 0.5f, sv + 0.5f));
+            cube.colors.push_back(Color::White);
+            cube.normals.push_back(normal);
+        }
+
+        // (u, v, normal) is right-handed, so these face outwards
+        cube.indices.insert(cube.indices.end(), {
+            base, base + 1, base + 3,
+            base, base + 3, base + 2
+        });
+    }
+
+    return cube.create({});
+}
+
+// path itself if it is a KTX/DDS file, otherwise a .ktx or .dds file next to
+// it, as written by tools/texconv; false if there is none the GPU can sample
+bool loadCompressedImage(const ResourcePack& pack,
+                         const std::string& path,
+                         CompressedImage& outImage)
+{
+    std::vector<std::string> candidates;
+    if (CompressedImage::isCompressedFile(path)) {
+        candidates.push_back(path);
+    } else {
+        size_t dot = path.rfind('.');
+        size_t slash = path.rfind('/');
+        std::string base = (dot != std::string::npos
+                            && (slash == std::string::npos || dot > slash))
+                           ? path.substr(0, dot)
+                           : path;
+        candidates.push_back(base + ".ktx");
+        candidates.push_back(base + ".dds");
+    }
+
+    for (const std::string& candidate: candidates) {
+        const uint8_t* data;
+        size_t size;
+        const bool loaded = pack.find(candidate, data, size)
+                            ? outImage.loadFromMemory(data, size, candidate)
+                            : outImage.loadFromFile(candidate);
+        if (!loaded) {
+            continue;
+        }
+        if (CompressedImage::isFormatSupported(outImage.getFormat())) {
+            return true;
+        }
+
+        gLog.warn("%s: compressed format 0x%x not supported",
+                  candidate.c_str(), outImage.getFormat());
+    }
+
+    return false;
+}
+
+// from the resource pack if it has the file, from disk otherwise
+bool decodeImage(const ResourcePack& pack,
+                 const std::string& path,
+                 Image& outImage)
+{
+    const uint8_t* data;
+    size_t size;
+    if (pack.find(path, data, size)) {
+        return outImage.loadFromMemory(data, size, path);
+    }
+    return outImage.loadFromFile(path);
+}
+
+std::shared_ptr<Texture> makePlaceholderTexture()
+{
+    const uint32_t white = 0xffffffff;
+    auto texture = std::make_shared<Texture>(1, 1, Texture::Format::RGBA);
+    texture->upload(0, 0, 1, 1, &white);
+    return texture;
+}
+
+} // namespace
+
+SINGLETON_INSTANCE(ResourceMgr);
+
+std::shared_ptr<Texture> ResourceMgr::getDefaultTexture()
+{
+    return getTexture("default.png");
+}
+
+ResourceMgr::ResourceMgr(const std::string& basePath):
+    mBasePath(basePath),
+    mTextures(""),
+    mImages(mBasePath + "image/"),
+    mMeshes(mBasePath + "mesh/"),
+    mTerrains(""),
+    mFonts(mBasePath + "font/"),
+    mVertexShaders(mBasePath + "shader/"),
+    mFragmentShaders(mBasePath + "shader/"),
+    mGeometryShaders(mBasePath + "shader/"),
+    mShaderPrograms(),
+    mShaderDefs(),
+    mShaderVariants(),
+    mLightFeatures(),
+    mShaderPermutations(),
+    mProgramCache(ProgramCache::getDefaultDirectory()),
+    mMeshCache(MeshCache::getDefaultDirectory()),
+    mPack(),
+    mPendingShaders(),
+    mFrustumCullShader(),
+    mTextMeshes(),
+    mSpriteAtlas(),
+    mTextureLayers(),
+    mTextureArrayPages(),
+    mUploadsMutex(),
+    mUploadQueued(),
+    mUploads(),
+    mPendingLoads(0),
+    mUploadContext(nullptr),
+    mTextureStreamer(),
+    mLoaders()
+{
+    GLint maxTexSize;
+    GL_CHECK(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize));
+    gLog.trace("max texture size: %d\n", maxTexSize);
+
+    ilInit();
+    iluInit();
+
+    mTextures.setBudget(DEFAULT_TEXTURE_BUDGET_BYTES);
+    mImages.setBudget(DEFAULT_IMAGE_BUDGET_BYTES);
+    mMeshes.setBudget(DEFAULT_MESH_BUDGET_BYTES);
+    mTerrains.setBudget(DEFAULT_TERRAIN_BUDGET_BYTES);
+
+    std::string packPath = mBasePath;
+    if (!packPath.empty() && packPath[packPath.size() - 1] == '/') {
+        packPath.resize(packPath.size() - 1);
+    }
+    packPath += ".pack";
+    if (!mPack.open(packPath, mBasePath)) {
+        gLog.trace("no resource pack at %s, using loose files\n",
+                   packPath.c_str());
+    }
+
+    // let the driver use as many threads as it likes for getShaderAsync
+    if (GLEW_KHR_parallel_shader_compile) {
+        GL_CHECK(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    } else if (GLEW_ARB_parallel_shader_compile) {
+        GL_CHECK(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+    }
+
+    std::vector<Vec3> lineVertices {
+        { 0.f, 0.f, 0.f },
+        { 1.f, 1.f, 1.f }
+    };
+
+    std::vector<uint32_t> lineIndices { 0, 1 };
+
+    std::vector<Vec3> quadVertices {
+        { -1.f, -1.f, 0.f },
+        { -1.f,  1.f, 0.f },
+        {  1.f, -1.f, 0.f },
+        {  1.f,  1.f, 0.f }
+    };
+
+    std::vector<Vec2> quadTexcoords {
+        { 0.f, 0.f },
+        { 0.f, 1.f },
+        { 1.f, 0.f },
+        { 1.f, 1.f }
+    };
+
+    std::vector<uint32_t> quadIndices { 0, 1, 2, 3 };
+
+    auto line = std::make_shared<Mesh>(Mesh::Shape::Line,
+                                       lineVertices, std::vector<Vec2>(),
+                                       std::vector<Color>(), std::vector<Vec3>(),
+                                       lineIndices, std::shared_ptr<Texture>());
+    mMeshes.addSpecial("line", line);
+
+    auto quad = std::make_shared<Mesh>(Mesh::Shape::TriangleStrip,
+                                       quadVertices, quadTexcoords,
+                                       std::vector<Color>(), std::vector<Vec3>(),
+                                       quadIndices, std::shared_ptr<Texture>());
+    mMeshes.addSpecial("quad", quad);
+
+    addBuiltinShaders();
+}
+
+void ResourceMgr::addBuiltinShaders()
+{
+    struct BuiltinShader {
+        const char* name;
+        const char* code;
+    };
+
+    static const BuiltinShader VERTEX_SHADERS[] = {
+        { "debug.vert", builtin::DEBUG_VERT },
+        { "batch2d.vert", builtin::BATCH2D_VERT },
+        { "placeholder.vert", builtin::PLACEHOLDER_VERT },
+    };
+    static const BuiltinShader FRAGMENT_SHADERS[] = {
+        { "debug.frag", builtin::DEBUG_FRAG },
+        { "batch2d.frag", builtin::BATCH2D_FRAG },
+        { "placeholder.frag", builtin::PLACEHOLDER_FRAG },
+    };
+
+    for (const BuiltinShader& s: VERTEX_SHADERS) {
+        mVertexShaders.addSpecial(s.name, std::make_shared<ConcreteShader>(
+                GL_VERTEX_SHADER, mVertexShaders.makeSpecial(s.name), s.code));
+    }
+    for (const BuiltinShader& s: FRAGMENT_SHADERS) {
+        mFragmentShaders.addSpecial(s.name, std::make_shared<ConcreteShader>(
+                GL_FRAGMENT_SHADER, mFragmentShaders.makeSpecial(s.name), s.code));
+    }
+}
+
+void ResourceMgr::freeUnused()
+{
+    // users first, so that resources they hold become unused
+    mTextMeshes.clear();
+    mFonts.freeUnused();
+    mMeshes.freeUnused();
+    mTerrains.freeUnused();
+    mTextures.freeUnused();
+    mImages.freeUnused();
+}
+
+void ResourceMgr::setBudget(Category category,
+                            size_t budgetBytes)
+{
+    switch (category) {
+    case Category::Textures: mTextures.setBudget(budgetBytes); break;
+    case Category::Images: mImages.setBudget(budgetBytes); break;
+    case Category::Meshes: mMeshes.setBudget(budgetBytes); break;
+    case Category::Terrains: mTerrains.setBudget(budgetBytes); break;
+    }
+}
+
+std::vector<ResourceMgr::CategoryStats> ResourceMgr::getStats() const
+{
+    return {
+        { Category::Textures, "textures", mTextures.getNumResources(),
+          mTextures.getResidentSize(), mTextures.getBudget(),
+          mTextures.getNumEvicted() },
+        { Category::Images, "images", mImages.getNumResources(),
+          mImages.getResidentSize(), mImages.getBudget(),
+          mImages.getNumEvicted() },
+        { Category::Meshes, "meshes", mMeshes.getNumResources(),
+          mMeshes.getResidentSize(), mMeshes.getBudget(),
+          mMeshes.getNumEvicted() },
+        { Category::Terrains, "terrains", mTerrains.getNumResources(),
+          mTerrains.getResidentSize(), mTerrains.getBudget(),
+          mTerrains.getNumEvicted() },
+    };
+}
+
+void ResourceMgr::freeAll()
+{
+    mTextureStreamer.clear();
+    mTextMeshes.clear();
+    mSpriteAtlas.clear();
+    mTextureLayers.clear();
+    mTextureArrayPages.clear();
+    mTextures.freeAll();
+    mImages.freeAll();
+    mMeshes.freeAll();
+    mTerrains.freeAll();
+
+    mVertexShaders.freeAll();
+    mFragmentShaders.freeAll();
+    mGeometryShaders.freeAll();
+    mPendingShaders.clear();
+    mShaderVariants.clear();
+    mShaderPermutations.clear();
+    mFrustumCullShader.reset();
+
+    gLog.trace("all resources freed\n");
+}
+
+
+ResourceSize ResourceMgr::getTextureSize(const std::shared_ptr<Texture>& texture)
+{
+    return { 0, texture->getSizeBytes() };
+}
+
+ResourceSize ResourceMgr::getImageSize(const std::shared_ptr<Image>& image)
+{
+    return { image->getSizeBytes(), 0 };
+}
+
+ResourceSize ResourceMgr::getMeshSize(const std::shared_ptr<Mesh>& mesh)
+{
+    return { 0, mesh->getSizeBytes() };
+}
+
+std::shared_ptr<Image> ResourceMgr::loadImage(const std::string& name)
+{
+    std::shared_ptr<Image> img = std::make_shared<Image>();
+    if (decodeImage(gResourceMgr.mPack, name, *img)) {
+        return img;
+    }
+
+    gLog.err("cannot load image %s\n", name.c_str());
+    return std::make_shared<Image>();
+}
+
+std::shared_ptr<Texture> ResourceMgr::loadTexture(const std::string& name)
+{
+    gLog.trace("loading texture %s\n", name.c_str());
+
+    CompressedImage compressed;
+    if (loadCompressedImage(gResourceMgr.mPack,
+                            gResourceMgr.mImages.getBasePath() + name,
+                            compressed)) {
+        return std::make_shared<Texture>(compressed);
+    }
 
-    return std::make_shared<Mesh>(Mesh::Shape::Triangle,
-                                  vertices, texcoords,
-                                  std::vector<Color>(), normals,
-                                  indices, std::shared_ptr<Texture>());
+    return std::make_shared<Texture>(gResourceMgr.getImage(name));
+}
+
+std::shared_ptr<Mesh> ResourceMgr::loadMesh(const std::string& name)
+{
+    gLog.trace("loading mesh %s\n", name.c_str());
+
+    MeshData data;
+    if (!decodeMeshCached(gResourceMgr.mMeshCache, gResourceMgr.mPack,
+                          name, data)) {
+        return {};
+    }
+
+    std::shared_ptr<Texture> texture;
+    if (!data.textureName.empty()) {
+        texture = gResourceMgr.getTexture(data.textureName);
+    }
+
+    return data.create(texture);
+}
+
+std::shared_ptr<Mesh> ResourceMgr::loadTerrain(const std::string& heightmap)
+{
+    gLog.trace("loading terrain %s\n", heightmap.c_str());
+
+    MeshData data;
+    decodeTerrain(heightmap, *gResourceMgr.getImage(heightmap), data);
+    return data.create({});
 }
 
 std::shared_ptr<Font> ResourceMgr::loadFont(const std::string& path)
 {
     gLog.info("loading font: %s", path.c_str());
 
-    std::ifstream file(path);
-    sbAssert(file.is_open(), "cannot open font file");
+    std::string contents;
+    if (!gResourceMgr.mPack.read(path, contents)
+            && !utils::readFile(path, contents)) {
+        sbFail("cannot open font file %s", path.c_str());
+    }
+    std::istringstream file(contents);
 
     size_t charsLoaded = 0;
     uint32_t textureWidth = 0;
@@ -375,6 +880,231 @@ std::shared_ptr<Font> ResourceMgr::getFont(const std::string& name)
     return mFonts.get(name);
 }
 
+std::shared_ptr<Texture> ResourceMgr::getTextureAsync(const std::string& name)
+{
+    std::shared_ptr<Texture> texture = mTextures.find(name);
+    if (texture) {
+        return texture;
+    }
+
+    texture = makePlaceholderTexture();
+    mTextures.add(name, texture);
+
+    const std::string path = mImages.getBasePath() + name;
+    queueLoad([this, path, texture]() -> Upload {
+        // precompressed mip chains are only mapped here, never decoded
+        std::function<Texture*()> create;
+        auto compressed = std::make_shared<CompressedImage>();
+        if (loadCompressedImage(mPack, path, *compressed)) {
+            create = [compressed]() { return new Texture(*compressed); };
+        } else {
+            auto image = std::make_shared<Image>();
+            if (!decodeImage(mPack, path, *image)) {
+                gLog.err("cannot load image %s\n", path.c_str());
+                return []() {};
+            }
+            create = [image]() { return new Texture(image); };
+        }
+
+        return [this, create, texture]() {
+            if (!mUploadContext) {
+                std::unique_ptr<Texture> loaded(create());
+                texture->swap(*loaded);
+                return;
+            }
+
+            // texture uploads and mipmap generation happen on the upload
+            // thread; the load stays pending until the texture is swapped in
+            ++mPendingLoads;
+            auto loaded = std::make_shared<std::unique_ptr<Texture>>();
+            mUploadContext->submit(
+                [create, loaded]() {
+                    loaded->reset(create());
+                },
+                [this, texture, loaded]() {
+                    texture->swap(**loaded);
+                    --mPendingLoads;
+                });
+        };
+    });
+
+    return texture;
+}
+
+std::shared_ptr<Texture> ResourceMgr::getTextureStreamed(const std::string& name)
+{
+    if (!TextureStreamer::isSupported()) {
+        return getTextureAsync(name);
+    }
+
+    std::shared_ptr<Texture> texture = mTextures.find(name);
+    if (texture) {
+        return texture;
+    }
+
+    texture = makePlaceholderTexture();
+    mTextures.add(name, texture);
+
+    const std::string path = mImages.getBasePath() + name;
+    queueLoad([this, path, texture]() -> Upload {
+        // the whole mip chain is built here, so that the render thread only
+        // copies it
+        auto mips = std::make_shared<TextureMips>();
+        auto compressed = std::make_shared<CompressedImage>();
+        if (loadCompressedImage(mPack, path, *compressed)) {
+            *mips = TextureMips::fromCompressed(compressed);
+        } else {
+            Image image;
+            const void* rgba = decodeImage(mPack, path, image)
+                               ? image.getRGBAData()
+                               : nullptr;
+            if (!rgba) {
+                gLog.err("cannot load image %s\n", path.c_str());
+                return []() {};
+            }
+            *mips = TextureMips::fromRGBA(rgba, image.getWidth(),
+                                          image.getHeight());
+        }
+
+        return [this, mips, texture]() {
+            mTextureStreamer.add(texture, *mips);
+        };
+    });
+
+    return texture;
+}
+
+std::shared_ptr<Mesh> ResourceMgr::getMeshAsync(const std::string& name)
+{
+    std::shared_ptr<Mesh> mesh = mMeshes.find(name);
+    if (mesh) {
+        return mesh;
+    }
+
+    mesh = makePlaceholderMesh();
+    mMeshes.add(name, mesh);
+
+    const std::string path = mMeshes.getBasePath() + name;
+    queueLoad([this, path, mesh]() -> Upload {
+        auto data = std::make_shared<MeshData>();
+        if (!decodeMeshCached(mMeshCache, mPack, path, *data)) {
+            return []() {};
+        }
+
+        return [this, data, mesh]() {
+            std::shared_ptr<Texture> texture;
+            if (!data->textureName.empty()) {
+                texture = getTextureAsync(data->textureName);
+            }
+
+            mesh->swap(*data->create(texture));
+        };
+    });
+
+    return mesh;
+}
+
+std::shared_ptr<Mesh> ResourceMgr::getTerrainAsync(const std::string& heightmap)
+{
+    std::shared_ptr<Mesh> terrain = mTerrains.find(heightmap);
+    if (terrain) {
+        return terrain;
+    }
+
+    terrain = makePlaceholderMesh();
+    mTerrains.add(heightmap, terrain);
+
+    const std::string path = mImages.getBasePath() + heightmap;
+    queueLoad([this, heightmap, path, terrain]() -> Upload {
+        Image image;
+        auto data = std::make_shared<MeshData>();
+        if (!decodeImage(mPack, path, image)) {
+            gLog.err("cannot load image %s\n", path.c_str());
+            return []() {};
+        }
+        decodeTerrain(heightmap, image, *data);
+
+        return [data, terrain]() {
+            terrain->swap(*data->create({}));
+        };
+    });
+
+    return terrain;
+}
+
+void ResourceMgr::queueLoad(const std::function<Upload()>& decode)
+{
+    if (!mLoaders) {
+        mLoaders.reset(new ThreadPool());
+    }
+
+    ++mPendingLoads;
+    mLoaders->submit([this, decode]() {
+        Upload upload = decode();
+        {
+            std::lock_guard<std::mutex> lock(mUploadsMutex);
+            mUploads.push_back(upload);
+        }
+        mUploadQueued.notify_one();
+    });
+}
+
+void ResourceMgr::setUploadContext(UploadContext* context)
+{
+    // completions of in-flight jobs swap textures in and decrement
+    // mPendingLoads; dropping them would leave both wrong
+    if (mUploadContext && mUploadContext != context) {
+        mUploadContext->finish();
+    }
+
+    mUploadContext = context;
+}
+
+void ResourceMgr::processUploads(uint64_t budgetMicroseconds)
+{
+    if (mUploadContext) {
+        mUploadContext->poll();
+    }
+
+    Timer timer;
+
+    do {
+        Upload upload;
+        {
+            std::lock_guard<std::mutex> lock(mUploadsMutex);
+            if (mUploads.empty()) {
+                return;
+            }
+
+            upload = std::move(mUploads.front());
+            mUploads.pop_front();
+        }
+
+        upload();
+        --mPendingLoads;
+    } while (timer.getMicrosecondsElapsed() < budgetMicroseconds);
+}
+
+void ResourceMgr::waitForLoads()
+{
+    while (mPendingLoads > 0) {
+        processUploads(std::numeric_limits<uint64_t>::max());
+        if (mUploadContext) {
+            mUploadContext->finish();
+        }
+
+        if (mPendingLoads == 0) {
+            break;
+        }
+
+        // whatever is left is still being decoded
+        std::unique_lock<std::mutex> lock(mUploadsMutex);
+        mUploadQueued.wait(lock, [this]() { return !mUploads.empty(); });
+    }
+
+    mTextureStreamer.finish();
+}
+
 std::vector<std::string> extractAttributes(const std::string& filename)
 {
     std::ifstream file(filename);
@@ -414,14 +1144,130 @@ std::shared_ptr<Shader> ResourceMgr::getShader(
         const std::string& vertexShaderName,
         const std::string& fragmentShaderName,
         const std::string& geometryShaderName)
+{
+    return getShader(vertexShaderName, fragmentShaderName,
+                     ShaderFeatures(), geometryShaderName);
+}
+
+std::shared_ptr<Shader> ResourceMgr::getShader(
+        const std::string& vertexShaderName,
+        const std::string& fragmentShaderName,
+        const ShaderFeatures& features,
+        const std::string& geometryShaderName)
+{
+    std::shared_ptr<Shader> shader = getShaderProgram(vertexShaderName,
+                                                      fragmentShaderName,
+                                                      geometryShaderName,
+                                                      features, false);
+    // might have been requested with getShaderAsync before
+    if (shader && !shader->isReady()) {
+        shader->wait();
+    }
+
+    return shader;
+}
+
+std::shared_ptr<Shader> ResourceMgr::getShaderAsync(
+        const std::string& vertexShaderName,
+        const std::string& fragmentShaderName,
+        const std::string& geometryShaderName)
+{
+    return getShaderAsync(vertexShaderName, fragmentShaderName,
+                          ShaderFeatures(), geometryShaderName);
+}
+
+std::shared_ptr<Shader> ResourceMgr::getShaderAsync(
+        const std::string& vertexShaderName,
+        const std::string& fragmentShaderName,
+        const ShaderFeatures& features,
+        const std::string& geometryShaderName)
+{
+    return getShaderProgram(vertexShaderName, fragmentShaderName,
+                            geometryShaderName, features, true);
+}
+
+void ResourceMgr::setLightFeatures(const ShaderFeatures& features)
+{
+    if (features == mLightFeatures) {
+        return;
+    }
+
+    // permutations for other configurations stay in mShaderPrograms, so
+    // switching back does not compile them again
+    mLightFeatures = features;
+    mShaderPermutations.clear();
+}
+
+std::shared_ptr<Shader> ResourceMgr::getShaderPermutation(
+        const std::shared_ptr<Shader>& shader)
+{
+    auto it = mShaderPermutations.find(shader.get());
+    if (it == mShaderPermutations.end()) {
+        std::shared_ptr<Shader> permutation = shader;
+        auto defIt = mShaderDefs.find(shader.get());
+        if (defIt != mShaderDefs.end()) {
+            const ShaderProgramDef& def = defIt->second;
+
+            // skip defines the shader does not care about, so that it is
+            // not recompiled for every light configuration
+            ShaderFeatures relevant = mLightFeatures.filtered(
+                    [&def](const std::string& name) {
+                        return def.vertex->references(name)
+                                || def.fragment->references(name)
+                                || (def.geometry && def.geometry->references(name));
+                    });
+
+            if (!relevant.empty()) {
+                ShaderProgramDef permutationDef = def;
+                permutationDef.features = def.features.merged(relevant);
+                permutation = getShaderProgram(permutationDef, true);
+            }
+        }
+
+        it = mShaderPermutations.insert({ shader.get(), permutation }).first;
+    }
+
+    // the base shader handles any light counts as uniforms, so it is drawn
+    // with instead of the placeholder
+    return it->second->isReady() ? it->second : shader;
+}
+
+void ResourceMgr::pollShaders()
+{
+    for (auto it = mPendingShaders.begin(); it != mPendingShaders.end();) {
+        if (it->shader->poll()) {
+            storeCachedProgram(it->cacheKey, *it->shader);
+            it = mPendingShaders.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ResourceMgr::waitForShaders()
+{
+    for (PendingShader& pending: mPendingShaders) {
+        pending.shader->wait();
+    }
+
+    pollShaders();
+}
+
+std::shared_ptr<Shader> ResourceMgr::getShaderProgram(
+        const std::string& vertexShaderName,
+        const std::string& fragmentShaderName,
+        const std::string& geometryShaderName,
+        const ShaderFeatures& features,
+        bool async)
 {
     bool hasGeometryShader = (geometryShaderName.size() > 0);
 
-    gLog.trace("loading shader: %s, %s, %s\n",
+    gLog.trace("loading shader: %s, %s, %s [%s]\n",
                vertexShaderName.c_str(),
                fragmentShaderName.c_str(),
                hasGeometryShader ? geometryShaderName.c_str()
-                                 : "(no geometry shader)");
+                                 : "(no geometry shader)",
+               features.toString().c_str());
 
     auto vertexShader = mVertexShaders.get(vertexShaderName);
     auto fragmentShader = mFragmentShaders.get(fragmentShaderName);
@@ -436,21 +1282,145 @@ std::shared_ptr<Shader> ResourceMgr::getShader(
 
     ShaderProgramDef programDef { vertexShader,
                                   fragmentShader,
-                                  geometryShader ? geometryShader : nullptr };
+                                  geometryShader ? geometryShader : nullptr,
+                                  features };
+
+    return getShaderProgram(programDef, async);
+}
 
+std::shared_ptr<Shader> ResourceMgr::getShaderProgram(
+        const ShaderProgramDef& programDef,
+        bool async)
+{
     auto it = mShaderPrograms.find(programDef);
 
     if (it != mShaderPrograms.end()) {
         return it->second;
     }
 
-    Shader shader(vertexShader, fragmentShader, geometryShader);
-    auto shader_ptr = std::make_shared<Shader>(std::move(shader));
+    auto vertexShader = getShaderVariant(programDef.vertex, programDef.features);
+    auto fragmentShader = getShaderVariant(programDef.fragment,
+                                           programDef.features);
+    auto geometryShader = getShaderVariant(programDef.geometry,
+                                           programDef.features);
+
+    const uint64_t cacheKey = mProgramCache.makeKey({
+        vertexShader->getCode(),
+        fragmentShader->getCode(),
+        geometryShader ? geometryShader->getCode() : ""
+    });
+
+    std::shared_ptr<Shader> shader_ptr = loadCachedProgram(cacheKey);
+    if (!shader_ptr && async) {
+        shader_ptr.reset(new Shader(vertexShader, fragmentShader,
+                                    geometryShader, getPlaceholderShader()));
+        mPendingShaders.push_back({ cacheKey, shader_ptr });
+    } else if (!shader_ptr) {
+        Shader shader(vertexShader, fragmentShader, geometryShader);
+        shader_ptr = std::make_shared<Shader>(std::move(shader));
+        storeCachedProgram(cacheKey, *shader_ptr);
+    }
+
     mShaderPrograms.insert(std::make_pair(programDef, shader_ptr));
+    mShaderDefs.insert(std::make_pair(shader_ptr.get(), programDef));
 
     return shader_ptr;
 }
 
+std::shared_ptr<ConcreteShader> ResourceMgr::getShaderVariant(
+        const std::shared_ptr<ConcreteShader>& shader,
+        const ShaderFeatures& features)
+{
+    if (!shader || features.empty()) {
+        return shader;
+    }
+
+    const auto key = std::make_pair(shader, features);
+    auto it = mShaderVariants.find(key);
+    if (it != mShaderVariants.end()) {
+        return it->second;
+    }
+
+    auto variant = std::make_shared<ConcreteShader>(
+            shader->getType(),
+            shader->getFilename() + "[" + features.toString() + "]",
+            features.apply(shader->getCode()));
+    mShaderVariants.insert({ key, variant });
+    return variant;
+}
+
+std::shared_ptr<Shader> ResourceMgr::loadCachedProgram(uint64_t key)
+{
+    ProgramCache::Entry entry;
+    if (!mProgramCache.load(key, entry)) {
+        return {};
+    }
+
+    ProgramId program = Shader::loadBinary(entry.binaryFormat, entry.binary);
+    if (!program) {
+        gLog.info("cached program rejected by the driver, recompiling: %s",
+                  utils::join(entry.filenames, ", ").c_str());
+        mProgramCache.remove(key);
+        return {};
+    }
+
+    gLog.trace("loaded cached program: %s",
+               utils::join(entry.filenames, ", ").c_str());
+    return std::shared_ptr<Shader>(new Shader(program, entry.filenames,
+                                              entry.inputs, entry.uniforms));
+}
+
+void ResourceMgr::storeCachedProgram(uint64_t key,
+                                     const Shader& shader)
+{
+    if (!mProgramCache.isEnabled()) {
+        return;
+    }
+
+    ProgramCache::Entry entry;
+    if (!shader.getBinary(entry.binaryFormat, entry.binary)) {
+        return;
+    }
+
+    entry.filenames = shader.mFilenames;
+    entry.inputs = shader.mInputs;
+    entry.uniforms = shader.mUniforms;
+    mProgramCache.store(key, entry);
+}
+
+std::shared_ptr<Mesh> ResourceMgr::getTextMesh(const std::shared_ptr<Font>& font,
+                                               const std::string& text)
+{
+    return mTextMeshes.get(font, text);
+}
+
+TextureLayer ResourceMgr::getTextureLayer(const std::string& image)
+{
+    auto it = mTextureLayers.find(image);
+    if (it != mTextureLayers.end()) {
+        return it->second;
+    }
+
+    std::shared_ptr<Image> img = getImage(image);
+    std::pair<uint32_t, uint32_t> size(img->getWidth(), img->getHeight());
+
+    std::shared_ptr<TextureArray>& page = mTextureArrayPages[size];
+    if (!page || page->isFull()) {
+        gLog.trace("creating %ux%u texture array page\n", size.first, size.second);
+        page = std::make_shared<TextureArray>(size.first, size.second,
+                                              TEXTURE_ARRAY_PAGE_LAYERS);
+    }
+
+    TextureLayer layer { page, page->addLayer(img->getRGBAData()) };
+    mTextureLayers.insert(std::make_pair(image, layer));
+    return layer;
+}
+
+const TextureAtlas::Region& ResourceMgr::getAtlasRegion(const std::string& image)
+{
+    return mSpriteAtlas.getRegion(image, getImage(image));
+}
+
 std::shared_ptr<Mesh> ResourceMgr::getLine()
 {
     return getMesh("*line");
@@ -461,4 +1431,46 @@ std::shared_ptr<Mesh> ResourceMgr::getQuad()
     return getMesh("*quad");
 }
 
+std::shared_ptr<Shader> ResourceMgr::getDebugShader()
+{
+    return getShader("*debug.vert", "*debug.frag");
+}
+
+std::shared_ptr<Shader> ResourceMgr::getBatch2DShader()
+{
+    return getShader("*batch2d.vert", "*batch2d.frag");
+}
+
+std::shared_ptr<Shader> ResourceMgr::getStaticBatchShader(bool lit)
+{
+    // not compiled with other built-ins, as it would fail on GL 3.3
+    if (!mVertexShaders.getSpecial("static.vert")) {
+        mVertexShaders.addSpecial("static.vert", std::make_shared<ConcreteShader>(
+                GL_VERTEX_SHADER, mVertexShaders.makeSpecial("static.vert"),
+                builtin::STATIC_VERT));
+        mFragmentShaders.addSpecial("static.frag", std::make_shared<ConcreteShader>(
+                GL_FRAGMENT_SHADER, mFragmentShaders.makeSpecial("static.frag"),
+                builtin::STATIC_FRAG));
+    }
+
+    return lit ? getShader("*static.vert", "*static.frag", ShaderFeatures { "LIT" })
+               : getShader("*static.vert", "*static.frag");
+}
+
+std::shared_ptr<Shader> ResourceMgr::getFrustumCullShader()
+{
+    if (!mFrustumCullShader) {
+        auto compute = std::make_shared<ConcreteShader>(
+                GL_COMPUTE_SHADER, "*cull.comp", builtin::CULL_COMP);
+        mFrustumCullShader.reset(new Shader(compute));
+    }
+
+    return mFrustumCullShader;
+}
+
+std::shared_ptr<Shader> ResourceMgr::getPlaceholderShader()
+{
+    return getShader("*placeholder.vert", "*placeholder.frag");
+}
+
 } // namespace sb
@@ -0,0 +1,216 @@
+#include <sandbox/resources/resourcePack.h>
+
+#include <sandbox/utils/fileSystem.h>
+#include <sandbox/utils/hash.h>
+#include <sandbox/utils/logger.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace sb {
+namespace {
+
+const uint32_t MAGIC = 0x4b504253; // "SBPK"
+const uint32_t VERSION = 1;
+// file contents alignment, so that mapped data can be used in place
+const size_t DATA_ALIGNMENT = 16;
+
+// at the start of the pack; index entries follow right after it
+struct FileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t numEntries;
+    uint64_t namesOffset;
+    uint64_t namesBytes;
+};
+
+struct IndexEntry
+{
+    uint64_t pathHash;
+    uint64_t offset;
+    uint64_t sizeBytes;
+    // into the names block; not null-terminated
+    uint32_t nameOffset;
+    uint32_t nameBytes;
+    uint32_t compression;
+    uint32_t padding;
+};
+
+size_t alignUp(size_t value,
+               size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+ResourcePack::ResourcePack():
+    mFile(),
+    mMountPoint(),
+    mIndex(nullptr),
+    mNumEntries(0),
+    mNames(nullptr),
+    mNamesBytes(0)
+{
+}
+
+bool ResourcePack::open(const std::string& path,
+                        const std::string& mountPoint)
+{
+    close();
+
+    if (!mFile.open(path)) {
+        return false;
+    }
+
+    FileHeader header;
+    if (mFile.getSize() < sizeof(header)) {
+        gLog.warn("invalid resource pack: %s", path.c_str());
+        close();
+        return false;
+    }
+    memcpy(&header, mFile.getData(), sizeof(header));
+
+    const uint64_t indexBytes = header.numEntries * sizeof(IndexEntry);
+    if (header.magic != MAGIC
+            || header.version != VERSION
+            || sizeof(header) + indexBytes > mFile.getSize()
+            || header.namesOffset + header.namesBytes > mFile.getSize()) {
+        gLog.warn("invalid resource pack: %s", path.c_str());
+        close();
+        return false;
+    }
+
+    mMountPoint = mountPoint;
+    if (!mMountPoint.empty() && mMountPoint[mMountPoint.size() - 1] != '/') {
+        mMountPoint += "/";
+    }
+    mIndex = mFile.getData() + sizeof(header);
+    mNumEntries = header.numEntries;
+    mNames = (const char*)mFile.getData() + header.namesOffset;
+    mNamesBytes = header.namesBytes;
+
+    gLog.info("resource pack %s: %lu files mounted at %s", path.c_str(),
+              mNumEntries, mMountPoint.c_str());
+    return true;
+}
+
+void ResourcePack::close()
+{
+    mFile.close();
+    mMountPoint.clear();
+    mIndex = nullptr;
+    mNumEntries = 0;
+    mNames = nullptr;
+    mNamesBytes = 0;
+}
+
+bool ResourcePack::find(const std::string& path,
+                        const uint8_t*& outData,
+                        size_t& outSizeBytes) const
+{
+    if (!isOpen() || path.compare(0, mMountPoint.size(), mMountPoint) != 0) {
+        return false;
+    }
+
+    const std::string name = path.substr(mMountPoint.size());
+    const uint64_t hash = utils::fnv1a(name);
+
+    const IndexEntry* begin = (const IndexEntry*)mIndex;
+    const IndexEntry* end = begin + mNumEntries;
+    const IndexEntry* entry = std::lower_bound(
+            begin, end, hash,
+            [](const IndexEntry& e, uint64_t h) { return e.pathHash < h; });
+
+    // entries with colliding hashes are adjacent
+    for (; entry != end && entry->pathHash == hash; ++entry) {
+        if (entry->nameBytes != name.size()
+                || (uint64_t)entry->nameOffset + entry->nameBytes > mNamesBytes
+                || memcmp(mNames + entry->nameOffset, name.data(),
+                          name.size()) != 0) {
+            continue;
+        }
+
+        if (entry->offset + entry->sizeBytes > mFile.getSize()) {
+            gLog.warn("resource pack entry out of bounds: %s", path.c_str());
+            return false;
+        }
+        if (entry->compression != (uint32_t)Compression::Stored) {
+            gLog.warn("unsupported compression %u of packed %s",
+                      entry->compression, path.c_str());
+            return false;
+        }
+
+        outData = mFile.getData() + entry->offset;
+        outSizeBytes = entry->sizeBytes;
+        return true;
+    }
+
+    return false;
+}
+
+bool ResourcePack::read(const std::string& path,
+                        std::string& outData) const
+{
+    const uint8_t* data;
+    size_t size;
+    if (!find(path, data, size)) {
+        return false;
+    }
+
+    outData.assign((const char*)data, size);
+    return true;
+}
+
+bool ResourcePack::write(const std::string& path,
+                         const std::string& rootDirectory,
+                         const std::vector<std::string>& names)
+{
+    std::vector<IndexEntry> index(names.size());
+    std::string nameData;
+    for (size_t i = 0; i < names.size(); ++i) {
+        IndexEntry& entry = index[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.pathHash = utils::fnv1a(names[i]);
+        entry.nameOffset = (uint32_t)nameData.size();
+        entry.nameBytes = (uint32_t)names[i].size();
+        entry.compression = (uint32_t)Compression::Stored;
+        nameData += names[i];
+    }
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.numEntries = names.size();
+    header.namesOffset = sizeof(header) + index.size() * sizeof(IndexEntry);
+    header.namesBytes = nameData.size();
+
+    std::string data(header.namesOffset, '\0');
+    data += nameData;
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::string contents;
+        if (!utils::readFile(rootDirectory + "/" + names[i], contents)) {
+            gLog.err("cannot read %s/%s", rootDirectory.c_str(),
+                     names[i].c_str());
+            return false;
+        }
+
+        data.resize(alignUp(data.size(), DATA_ALIGNMENT), '\0');
+        index[i].offset = data.size();
+        index[i].sizeBytes = contents.size();
+        data += contents;
+    }
+
+    std::sort(index.begin(), index.end(),
+              [](const IndexEntry& a, const IndexEntry& b) {
+                  return a.pathHash < b.pathHash;
+              });
+
+    memcpy(&data[0], &header, sizeof(header));
+    memcpy(&data[sizeof(header)], index.data(), index.size() * sizeof(IndexEntry));
+    return utils::writeFileAtomic(path, data);
+}
+
+} // namespace sb
@@ -0,0 +1,123 @@
+#include <sandbox/resources/textMeshCache.h>
+
+#include <sandbox/resources/mesh.h>
+#include <sandbox/resources/font.h>
+
+#include <sandbox/utils/logger.h>
+
+#include <vector>
+
+namespace sb {
+namespace {
+
+const size_t VERTICES_PER_GLYPH = 4;
+const size_t INDICES_PER_GLYPH = 6;
+const size_t BYTES_PER_GLYPH = VERTICES_PER_GLYPH * (sizeof(Vec3) + sizeof(Vec2))
+                               + INDICES_PER_GLYPH * sizeof(uint32_t);
+
+std::shared_ptr<Mesh> makeMeshForText(const std::string& text,
+                                      const std::shared_ptr<Font>& font)
+{
+    std::vector<Vec3> vertices;
+    std::vector<Vec2> texcoords;
+    std::vector<uint32_t> indices;
+
+    vertices.reserve(text.size() * VERTICES_PER_GLYPH);
+    indices.reserve(text.size() * INDICES_PER_GLYPH);
+
+    uint32_t x = 0;
+    uint32_t y = 0;
+    for (char c: text) {
+        if (c == '\n') {
+            x = 0;
+            y += font->getLineHeightPixels();
+            continue;
+        }
+
+        const Font::Letter& l = font->getLetter((uint8_t)c);
+        size_t idxBase = vertices.size();
+
+        vertices.push_back(Vec3(x, y, 0.0f));
+        vertices.push_back(Vec3(x + l.widthPixels, y, 0.0f));
+        vertices.push_back(Vec3(x, y + l.heightPixels, 0.0f));
+        vertices.push_back(Vec3(x + l.widthPixels, y + l.heightPixels, 0.0f));
+
+        texcoords.push_back(l.texcoords.bottomLeft());
+        texcoords.push_back(l.texcoords.bottomRight);
+        texcoords.push_back(l.texcoords.topLeft);
+        texcoords.push_back(l.texcoords.topRight());
+
+        indices.push_back(idxBase);
+        indices.push_back(idxBase + 2);
+        indices.push_back(idxBase + 1);
+        indices.push_back(idxBase + 1);
+        indices.push_back(idxBase + 2);
+        indices.push_back(idxBase + 3);
+
+        x += l.widthPixels;
+    }
+
+    return std::make_shared<Mesh>(Mesh::Shape::Triangle,
+                                  vertices, texcoords,
+                                  std::vector<Color>(), std::vector<Vec3>(),
+                                  indices, font->getTexture());
+}
+
+} // namespace
+
+TextMeshCache::TextMeshCache(size_t capacityBytes):
+    mEntries(),
+    mIndex(),
+    mCapacityBytes(capacityBytes),
+    mSizeBytes(0)
+{}
+
+std::shared_ptr<Mesh> TextMeshCache::get(const std::shared_ptr<Font>& font,
+                                         const std::string& text)
+{
+    Key key(font.get(), text);
+
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        return it->second->mesh;
+    }
+
+    Entry entry {
+        key, font, makeMeshForText(text, font), text.size() * BYTES_PER_GLYPH
+    };
+
+    mEntries.push_front(entry);
+    mIndex[key] = mEntries.begin();
+    mSizeBytes += entry.sizeBytes;
+
+    evict();
+    return entry.mesh;
+}
+
+void TextMeshCache::setCapacity(size_t capacityBytes)
+{
+    mCapacityBytes = capacityBytes;
+    evict();
+}
+
+void TextMeshCache::clear()
+{
+    mIndex.clear();
+    mEntries.clear();
+    mSizeBytes = 0;
+}
+
+void TextMeshCache::evict()
+{
+    // always keep the most recent entry, even if it alone exceeds the cap
+    while (mSizeBytes > mCapacityBytes && mEntries.size() > 1) {
+        const Entry& lru = mEntries.back();
+
+        mSizeBytes -= lru.sizeBytes;
+        mIndex.erase(lru.key);
+        mEntries.pop_back();
+    }
+}
+
+} // namespace sb
@@ -0,0 +1,215 @@
+#include <sandbox/resources/textureAtlas.h>
+#include <sandbox/resources/image.h>
+#include <sandbox/rendering/texture.h>
+
+#include <sandbox/utils/logger.h>
+#include <sandbox/utils/debug.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace sb {
+namespace {
+
+// image surrounded by padding texels that repeat its edges, so that linear
+// filtering at region borders never picks up neighbouring regions or
+// uninitialized page memory
+std::vector<uint8_t> extrudeEdges(const uint8_t* rgba,
+                                  uint32_t width,
+                                  uint32_t height,
+                                  uint32_t padding)
+{
+    const uint32_t paddedWidth = width + 2 * padding;
+    const uint32_t paddedHeight = height + 2 * padding;
+    std::vector<uint8_t> result((size_t)paddedWidth * paddedHeight * 4);
+
+    for (uint32_t y = 0; y < paddedHeight; ++y) {
+        const uint32_t srcY = std::min(y - std::min(y, padding), height - 1);
+        const uint8_t* srcRow = rgba + (size_t)srcY * width * 4;
+        uint8_t* dstRow = &result[(size_t)y * paddedWidth * 4];
+
+        for (uint32_t x = 0; x < padding; ++x) {
+            memcpy(dstRow + x * 4, srcRow, 4);
+            memcpy(dstRow + (padding + width + x) * 4,
+                   srcRow + (width - 1) * 4, 4);
+        }
+        memcpy(dstRow + padding * 4, srcRow, (size_t)width * 4);
+    }
+
+    return result;
+}
+
+} // namespace
+
+TextureAtlas::SkylinePacker::SkylinePacker(uint32_t width,
+                                           uint32_t height):
+    mWidth(width),
+    mHeight(height),
+    mSkyline({ { 0, 0, width } })
+{}
+
+bool TextureAtlas::SkylinePacker::fitAt(size_t idx,
+                                        uint32_t width,
+                                        uint32_t height,
+                                        uint32_t& outY) const
+{
+    if (mSkyline[idx].x + width > mWidth) {
+        return false;
+    }
+
+    // the rect rests on the highest segment it spans
+    uint32_t y = 0;
+    uint32_t widthLeft = width;
+    for (size_t i = idx; widthLeft > 0; ++i) {
+        sbAssert(i < mSkyline.size(), "skyline does not cover atlas width");
+
+        y = std::max(y, mSkyline[i].y);
+        if (y + height > mHeight) {
+            return false;
+        }
+
+        widthLeft -= std::min(widthLeft, mSkyline[i].width);
+    }
+
+    outY = y;
+    return true;
+}
+
+bool TextureAtlas::SkylinePacker::insert(uint32_t width,
+                                         uint32_t height,
+                                         Vec2i& outPos)
+{
+    size_t bestIdx = mSkyline.size();
+    uint32_t bestY = std::numeric_limits<uint32_t>::max();
+    uint32_t bestWidth = std::numeric_limits<uint32_t>::max();
+
+    // bottom-left rule: lowest resulting top edge, then narrowest segment
+    for (size_t i = 0; i < mSkyline.size(); ++i) {
+        uint32_t y;
+        if (!fitAt(i, width, height, y)) {
+            continue;
+        }
+
+        if (y + height < bestY
+                || (y + height == bestY && mSkyline[i].width < bestWidth)) {
+            bestIdx = i;
+            bestY = y + height;
+            bestWidth = mSkyline[i].width;
+        }
+    }
+
+    if (bestIdx == mSkyline.size()) {
+        return false;
+    }
+
+    Segment placed { mSkyline[bestIdx].x, bestY, width };
+    outPos = Vec2i((int)placed.x, (int)(bestY - height));
+
+    mSkyline.insert(mSkyline.begin() + bestIdx, placed);
+
+    // shrink or remove segments now covered by the new one
+    for (size_t i = bestIdx + 1; i < mSkyline.size(); ++i) {
+        Segment& seg = mSkyline[i];
+        uint32_t placedEnd = placed.x + placed.width;
+        if (seg.x >= placedEnd) {
+            break;
+        }
+
+        uint32_t shrink = std::min(seg.width, placedEnd - seg.x);
+        seg.x += shrink;
+        seg.width -= shrink;
+        if (seg.width == 0) {
+            mSkyline.erase(mSkyline.begin() + i);
+            --i;
+        }
+    }
+
+    // merge neighbours at the same height
+    for (size_t i = 0; i + 1 < mSkyline.size(); ++i) {
+        if (mSkyline[i].y == mSkyline[i + 1].y) {
+            mSkyline[i].width += mSkyline[i + 1].width;
+            mSkyline.erase(mSkyline.begin() + i + 1);
+            --i;
+        }
+    }
+
+    return true;
+}
+
+TextureAtlas::TextureAtlas(uint32_t pageSize):
+    mPageSize(pageSize),
+    mPages(),
+    mRegions()
+{}
+
+const TextureAtlas::Region&
+TextureAtlas::getRegion(const std::string& name,
+                        const std::shared_ptr<Image>& image)
+{
+    auto it = mRegions.find(name);
+    if (it != mRegions.end()) {
+        return it->second;
+    }
+
+    uint32_t width = image->getWidth();
+    uint32_t height = image->getHeight();
+    uint32_t paddedWidth = width + 2 * PADDING;
+    uint32_t paddedHeight = height + 2 * PADDING;
+
+    Vec2i pos;
+    Page* page = nullptr;
+    for (Page& p: mPages) {
+        if (p.packer.insert(paddedWidth, paddedHeight, pos)) {
+            page = &p;
+            break;
+        }
+    }
+
+    if (!page) {
+        uint32_t pageWidth = std::max(mPageSize, paddedWidth);
+        uint32_t pageHeight = std::max(mPageSize, paddedHeight);
+
+        gLog.trace("texture atlas: creating %ux%u page %lu",
+                   pageWidth, pageHeight, mPages.size());
+        mPages.push_back({
+            std::make_shared<Texture>(pageWidth, pageHeight,
+                                      Texture::Format::RGBA),
+            SkylinePacker(pageWidth, pageHeight),
+            Vec2i((int)pageWidth, (int)pageHeight)
+        });
+
+        page = &mPages.back();
+        bool fits = page->packer.insert(paddedWidth, paddedHeight, pos);
+        sbAssert(fits, "image %s does not fit on an empty page", name.c_str());
+    }
+
+    const std::vector<uint8_t> padded =
+            extrudeEdges((const uint8_t*)image->getRGBAData(),
+                         width, height, PADDING);
+    page->texture->upload(pos.x, pos.y, paddedWidth, paddedHeight,
+                          padded.data());
+
+    Vec2i imagePos = pos + Vec2i((int)PADDING, (int)PADDING);
+
+    Vec2 pageSize((float)page->size.x, (float)page->size.y);
+    Region region {
+        page->texture,
+        Vec2((float)imagePos.x / pageSize.x,
+             (float)imagePos.y / pageSize.y),
+        Vec2((float)(imagePos.x + width) / pageSize.x,
+             (float)(imagePos.y + height) / pageSize.y),
+        Vec2i((int)width, (int)height)
+    };
+
+    return mRegions.insert(std::make_pair(name, region)).first->second;
+}
+
+void TextureAtlas::clear()
+{
+    mRegions.clear();
+    mPages.clear();
+}
+
+} // namespace sb
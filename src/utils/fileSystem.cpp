@@ -0,0 +1,156 @@
+#include <sandbox/utils/fileSystem.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace sb {
+namespace utils {
+
+bool makeDirectories(const std::string& path)
+{
+    for (size_t pos = path.find('/', 1);
+            pos != std::string::npos;
+            pos = path.find('/', pos + 1)) {
+        if (mkdir(path.substr(0, pos).c_str(), 0755) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+std::string getCacheDirectory(const std::string& name)
+{
+    const char* cacheHome = getenv("XDG_CACHE_HOME");
+    if (cacheHome && *cacheHome) {
+        return std::string(cacheHome) + "/sandbox/" + name;
+    }
+
+    const char* home = getenv("HOME");
+    if (home && *home) {
+        return std::string(home) + "/.cache/sandbox/" + name;
+    }
+
+    return "";
+}
+
+bool getFileInfo(const std::string& path,
+                 uint64_t& outModificationTimeNs,
+                 uint64_t& outSizeBytes)
+{
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;
+    }
+
+    outModificationTimeNs = (uint64_t)info.st_mtim.tv_sec * 1000000000ULL
+                            + (uint64_t)info.st_mtim.tv_nsec;
+    outSizeBytes = (uint64_t)info.st_size;
+    return true;
+}
+
+namespace {
+
+bool listFilesRecursive(const std::string& root,
+                        const std::string& prefix,
+                        std::vector<std::string>& outPaths)
+{
+    DIR* dir = opendir((root + "/" + prefix).c_str());
+    if (!dir) {
+        return false;
+    }
+
+    bool ok = true;
+    while (struct dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+
+        const std::string relative = prefix.empty() ? name : prefix + "/" + name;
+        struct stat info;
+        if (stat((root + "/" + relative).c_str(), &info) != 0) {
+            continue;
+        }
+
+        if (S_ISDIR(info.st_mode)) {
+            ok = listFilesRecursive(root, relative, outPaths) && ok;
+        } else if (S_ISREG(info.st_mode)) {
+            outPaths.push_back(relative);
+        }
+    }
+
+    closedir(dir);
+    return ok;
+}
+
+} // namespace
+
+bool listFiles(const std::string& directory,
+               std::vector<std::string>& outPaths)
+{
+    outPaths.clear();
+    if (!listFilesRecursive(directory, "", outPaths)) {
+        return false;
+    }
+
+    std::sort(outPaths.begin(), outPaths.end());
+    return true;
+}
+
+bool readFile(const std::string& path,
+              std::string& outData)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    outData.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+bool writeFileAtomic(const std::string& path,
+                     const std::string& data)
+{
+    // unique name, so that concurrent writers of the same path never write
+    // into each other's temporary file
+    std::string tmpPath = path + ".XXXXXX";
+    const int fd = mkstemp(&tmpPath[0]);
+    if (fd < 0) {
+        return false;
+    }
+
+    // mkstemp creates files readable only by the owner
+    bool ok = fchmod(fd, 0644) == 0;
+    for (size_t written = 0; ok && written < data.size();) {
+        const ssize_t result = ::write(fd, data.data() + written,
+                                       data.size() - written);
+        if (result < 0 && errno != EINTR) {
+            ok = false;
+        } else if (result > 0) {
+            written += (size_t)result;
+        }
+    }
+    ok = (close(fd) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        ::remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace utils
+} // namespace sb
@@ -0,0 +1,74 @@
+#include <sandbox/utils/mappedFile.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace sb {
+
+MappedFile::MappedFile():
+    mData(nullptr),
+    mSize(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& old):
+    mData(old.mData),
+    mSize(old.mSize)
+{
+    old.mData = nullptr;
+    old.mSize = 0;
+}
+
+MappedFile& MappedFile::operator =(MappedFile&& old)
+{
+    std::swap(mData, old.mData);
+    std::swap(mSize, old.mSize);
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    mData = (const uint8_t*)data;
+    mSize = (size_t)info.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (mData) {
+        munmap((void*)mData, mSize);
+        mData = nullptr;
+        mSize = 0;
+    }
+}
+
+} // namespace sb
@@ -0,0 +1,97 @@
+#include <sandbox/utils/rangeAllocator.h>
+#include <sandbox/utils/debug.h>
+
+#include <iterator>
+
+namespace sb {
+
+RangeAllocator::RangeAllocator(size_t capacity):
+    mFreeRanges(),
+    mCapacity(capacity),
+    mUsed(0)
+{
+    if (capacity > 0) {
+        mFreeRanges[0] = capacity;
+    }
+}
+
+size_t RangeAllocator::allocate(size_t size,
+                                size_t alignment)
+{
+    sbAssert(size > 0, "cannot allocate empty range");
+    sbAssert(alignment > 0, "invalid alignment");
+
+    for (auto it = mFreeRanges.begin(); it != mFreeRanges.end(); ++it) {
+        const size_t rangeStart = it->first;
+        const size_t rangeEnd = it->first + it->second;
+        const size_t offset = (rangeStart + alignment - 1) / alignment * alignment;
+
+        if (offset + size > rangeEnd) {
+            continue;
+        }
+
+        mFreeRanges.erase(it);
+        if (offset > rangeStart) {
+            mFreeRanges[rangeStart] = offset - rangeStart;
+        }
+        if (offset + size < rangeEnd) {
+            mFreeRanges[offset + size] = rangeEnd - (offset + size);
+        }
+
+        mUsed += size;
+        return offset;
+    }
+
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::free(size_t offset,
+                          size_t size)
+{
+    sbAssert(offset + size <= mCapacity, "freeing range out of bounds");
+    sbAssert(size <= mUsed, "freeing more than allocated");
+
+    mUsed -= size;
+    insertFreeRange(offset, size);
+}
+
+void RangeAllocator::grow(size_t newCapacity)
+{
+    sbAssert(newCapacity >= mCapacity, "range allocator cannot shrink");
+    if (newCapacity == mCapacity) {
+        return;
+    }
+
+    size_t oldCapacity = mCapacity;
+    mCapacity = newCapacity;
+    insertFreeRange(oldCapacity, newCapacity - oldCapacity);
+}
+
+void RangeAllocator::insertFreeRange(size_t offset,
+                                     size_t size)
+{
+    auto next = mFreeRanges.lower_bound(offset);
+    sbAssert(next == mFreeRanges.end() || offset + size <= next->first,
+             "freeing range that overlaps a free one");
+
+    if (next != mFreeRanges.begin()) {
+        auto prev = std::prev(next);
+        sbAssert(prev->first + prev->second <= offset,
+                 "freeing range that overlaps a free one");
+
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            mFreeRanges.erase(prev);
+        }
+    }
+
+    if (next != mFreeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        mFreeRanges.erase(next);
+    }
+
+    mFreeRanges[offset] = size;
+}
+
+} // namespace sb
@@ -0,0 +1,69 @@
+#include <sandbox/utils/threadPool.h>
+
+namespace sb {
+
+ThreadPool::ThreadPool(size_t numThreads):
+    mThreads(),
+    mJobs(),
+    mMutex(),
+    mJobAdded(),
+    mStopping(false)
+{
+    for (size_t i = 0; i < numThreads; ++i) {
+        mThreads.emplace_back(&ThreadPool::run, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+        mJobs.clear();
+    }
+
+    mJobAdded.notify_all();
+    for (std::thread& thread: mThreads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mJobs.push_back(std::move(job));
+    }
+
+    mJobAdded.notify_one();
+}
+
+size_t ThreadPool::getDefaultThreadCount()
+{
+    const size_t hardwareThreads = std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+}
+
+void ThreadPool::run()
+{
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobAdded.wait(lock, [this]() {
+                return mStopping || !mJobs.empty();
+            });
+
+            if (mStopping) {
+                return;
+            }
+
+            job = std::move(mJobs.front());
+            mJobs.pop_front();
+        }
+
+        job();
+    }
+}
+
+} // namespace sb
@@ -7,8 +7,6 @@
 #include <sandbox/resources/font.h>
 #include <sandbox/resources/resourceMgr.h>
 
-#include <sandbox/rendering/text.h>
-
 #include <X11/Xutil.h>
 #include <cstring>
 
@@ -35,6 +33,8 @@ namespace sb
 
     bool Window::create(unsigned width, unsigned height)
     {
+        // Renderer's upload thread makes its context current concurrently
+        XInitThreads();
         mDisplay = XOpenDisplay(0);
         if (!mDisplay)
             return false;
@@ -293,12 +293,12 @@ namespace sb
         }
 
         static std::shared_ptr<sb::Font> font = gResourceMgr.getFont("font.txt");
-        static std::shared_ptr<sb::Shader> shader = gResourceMgr.getShader("proj_texture.vert", "texture.frag");
 
-        sb::Text text(str, font, shader);
-        text.setPosition(topLeft.x,
-                         topLeft.y + lineNum * font->getLineHeightPixels(), 0.0f);
-        text.setColor(color);
-        draw(text);
+        // batched with all other strings drawn this frame
+        mRenderer.getTextBatch().add(
+                font, str,
+                Vec2(topLeft.x,
+                     topLeft.y + (float)(lineNum * font->getLineHeightPixels())),
+                color);
     }
 } // namespace sb
@@ -0,0 +1,40 @@
+// Resource pack builder: stores every file of a data directory in a single
+// pack, which ResourceMgr mounts instead of reading loose files.
+//
+// usage: sandbox_pack data_directory output.pack
+// ResourceMgr looks for the pack next to its base path, e.g. data.pack for
+// data/; delete the pack to go back to loose files during development
+
+#include <sandbox/resources/resourcePack.h>
+#include <sandbox/utils/fileSystem.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+int main(int argc,
+         char** argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s data_directory output.pack\n", argv[0]);
+        return 1;
+    }
+
+    const std::string directory = argv[1];
+    const std::string output = argv[2];
+
+    std::vector<std::string> names;
+    if (!sb::utils::listFiles(directory, names)) {
+        fprintf(stderr, "%s: cannot list files\n", directory.c_str());
+        return 1;
+    }
+
+    if (!sb::ResourcePack::write(output, directory, names)) {
+        fprintf(stderr, "%s: cannot write\n", output.c_str());
+        return 1;
+    }
+
+    printf("%s -> %s: %lu files\n", directory.c_str(), output.c_str(),
+           names.size());
+    return 0;
+}
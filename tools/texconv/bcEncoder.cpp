@@ -0,0 +1,221 @@
+#include "bcEncoder.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace texconv {
+namespace {
+
+struct Block
+{
+    // 4x4 RGBA8 pixels, row by row
+    uint8_t pixels[16][4];
+};
+
+// pixels past the right or bottom edge repeat the last column or row
+Block fetchBlock(const uint8_t* rgba,
+                 uint32_t width,
+                 uint32_t height,
+                 uint32_t blockX,
+                 uint32_t blockY)
+{
+    Block block;
+    for (uint32_t y = 0; y < 4; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+            uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+            uint32_t srcY = std::min(blockY * 4 + y, height - 1);
+            memcpy(block.pixels[y * 4 + x],
+                   rgba + ((size_t)srcY * width + srcX) * 4, 4);
+        }
+    }
+    return block;
+}
+
+uint16_t toRGB565(const int color[3])
+{
+    return (uint16_t)(((color[0] >> 3) << 11)
+                      | ((color[1] >> 2) << 5)
+                      | (color[2] >> 3));
+}
+
+void fromRGB565(uint16_t packed,
+                int outColor[3])
+{
+    int r = (packed >> 11) & 0x1f;
+    int g = (packed >> 5) & 0x3f;
+    int b = packed & 0x1f;
+    outColor[0] = (r << 3) | (r >> 2);
+    outColor[1] = (g << 2) | (g >> 4);
+    outColor[2] = (b << 3) | (b >> 2);
+}
+
+void put16(uint8_t* out,
+           uint16_t value)
+{
+    out[0] = (uint8_t)(value & 0xff);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+void encodeColorBlock(const Block& block,
+                      uint8_t* out)
+{
+    int min[3] = { 255, 255, 255 };
+    int max[3] = { 0, 0, 0 };
+    int mean[3] = { 0, 0, 0 };
+    for (const uint8_t* pixel: block.pixels) {
+        for (int c = 0; c < 3; ++c) {
+            min[c] = std::min(min[c], (int)pixel[c]);
+            max[c] = std::max(max[c], (int)pixel[c]);
+            mean[c] += pixel[c];
+        }
+    }
+    for (int c = 0; c < 3; ++c) {
+        mean[c] /= 16;
+    }
+
+    // pick the bounding box diagonal that follows the colors: flip red and
+    // blue extents if they decrease as green increases
+    int covRG = 0;
+    int covBG = 0;
+    for (const uint8_t* pixel: block.pixels) {
+        covRG += (pixel[0] - mean[0]) * (pixel[1] - mean[1]);
+        covBG += (pixel[2] - mean[2]) * (pixel[1] - mean[1]);
+    }
+    if (covRG < 0) {
+        std::swap(min[0], max[0]);
+    }
+    if (covBG < 0) {
+        std::swap(min[2], max[2]);
+    }
+
+    // inset by 1/16 of the range, so that endpoints are not wasted on
+    // outliers
+    for (int c = 0; c < 3; ++c) {
+        int inset = (max[c] - min[c]) / 16;
+        min[c] = std::max(0, std::min(255, min[c] + inset));
+        max[c] = std::max(0, std::min(255, max[c] - inset));
+    }
+
+    uint16_t color0 = toRGB565(max);
+    uint16_t color1 = toRGB565(min);
+    // color0 > color1 selects 4-color mode
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        fromRGB565(color0, palette[0]);
+        fromRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint32_t best = 0;
+            int bestDistance = -1;
+            for (uint32_t p = 0; p < 4; ++p) {
+                int distance = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = (int)block.pixels[i][c] - palette[p][c];
+                    distance += d * d;
+                }
+                if (bestDistance < 0 || distance < bestDistance) {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= best << (2 * i);
+        }
+    }
+
+    put16(out, color0);
+    put16(out + 2, color1);
+    for (int i = 0; i < 4; ++i) {
+        out[4 + i] = (uint8_t)(indices >> (8 * i));
+    }
+}
+
+void encodeAlphaBlock(const Block& block,
+                      uint8_t* out)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (const uint8_t* pixel: block.pixels) {
+        alpha0 = std::max(alpha0, (int)pixel[3]);
+        alpha1 = std::min(alpha1, (int)pixel[3]);
+    }
+
+    uint64_t indices = 0;
+    if (alpha0 != alpha1) {
+        // alpha0 > alpha1 selects the 8-value mode
+        int palette[8] = { alpha0, alpha1 };
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+
+        for (uint32_t i = 0; i < 16; ++i) {
+            uint64_t best = 0;
+            int bestDistance = 256;
+            for (uint32_t p = 0; p < 8; ++p) {
+                int distance = std::abs((int)block.pixels[i][3] - palette[p]);
+                if (distance < bestDistance) {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices |= best << (3 * i);
+        }
+    }
+
+    out[0] = (uint8_t)alpha0;
+    out[1] = (uint8_t)alpha1;
+    for (int i = 0; i < 6; ++i) {
+        out[2 + i] = (uint8_t)(indices >> (8 * i));
+    }
+}
+
+template<typename EncodeFunc>
+std::vector<uint8_t> encode(const uint8_t* rgba,
+                            uint32_t width,
+                            uint32_t height,
+                            size_t blockBytes,
+                            EncodeFunc encodeBlock)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+
+    std::vector<uint8_t> out((size_t)blocksX * blocksY * blockBytes);
+    for (uint32_t y = 0; y < blocksY; ++y) {
+        for (uint32_t x = 0; x < blocksX; ++x) {
+            encodeBlock(fetchBlock(rgba, width, height, x, y),
+                        &out[((size_t)y * blocksX + x) * blockBytes]);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeBC1(const uint8_t* rgba,
+                               uint32_t width,
+                               uint32_t height)
+{
+    return encode(rgba, width, height, 8, encodeColorBlock);
+}
+
+std::vector<uint8_t> encodeBC3(const uint8_t* rgba,
+                               uint32_t width,
+                               uint32_t height)
+{
+    return encode(rgba, width, height, 16,
+                  [](const Block& block, uint8_t* out) {
+                      encodeAlphaBlock(block, out);
+                      encodeColorBlock(block, out + 8);
+                  });
+}
+
+} // namespace texconv
@@ -0,0 +1,26 @@
+#ifndef TOOLS_TEXCONV_BCENCODER_H
+#define TOOLS_TEXCONV_BCENCODER_H
+
+#include <cstdint>
+#include <vector>
+
+namespace texconv {
+
+// Fast block compressor in the spirit of van Waveren's "Real-Time DXT
+// Compression": endpoints are the inset bounding box of block colors, along
+// the diagonal matching their covariance. Quality is below that of offline
+// compressors doing endpoint search, but it needs no dependencies.
+
+// BC1 (DXT1) in 4-color mode, alpha ignored; 8 bytes per 4x4 block
+std::vector<uint8_t> encodeBC1(const uint8_t* rgba,
+                               uint32_t width,
+                               uint32_t height);
+// BC3 (DXT5): BC1 color block preceded by an interpolated alpha block;
+// 16 bytes per 4x4 block
+std::vector<uint8_t> encodeBC3(const uint8_t* rgba,
+                               uint32_t width,
+                               uint32_t height);
+
+} // namespace texconv
+
+#endif // TOOLS_TEXCONV_BCENCODER_H
@@ -0,0 +1,184 @@
+// Offline texture converter: decodes images with DevIL, builds the full mip
+// chain and writes it BC1/BC3-compressed to a KTX file next to the source,
+// where ResourceMgr::getTexture picks it up instead of the original.
+//
+// usage: sandbox_texconv [--bc1 | --bc3] image...
+//   --bc1  always BC1, alpha dropped (4 bits per pixel)
+//   --bc3  always BC3 (8 bits per pixel)
+// by default, BC3 is used for images with any non-opaque pixel, BC1 otherwise
+
+#include <sandbox/rendering/includeGL.h>
+#include <sandbox/rendering/textureStreamer.h>
+#include <sandbox/resources/image.h>
+#include <sandbox/utils/fileSystem.h>
+
+#include <IL/il.h>
+#include <IL/ilu.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bcEncoder.h"
+
+namespace {
+
+enum class Format {
+    Auto,
+    BC1,
+    BC3
+};
+
+bool hasAlpha(const sb::TextureMips::Level& level)
+{
+    const uint8_t* rgba = (const uint8_t*)level.data;
+    for (size_t i = 3; i < level.sizeBytes; i += 4) {
+        if (rgba[i] != 0xff) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void put32(std::string& out,
+           uint32_t value)
+{
+    out.append((const char*)&value, sizeof(value));
+}
+
+// KTX 1.1 with one 2D image, no key/value data
+std::string makeKTX(GLenum internalFormat,
+                    GLenum baseInternalFormat,
+                    const sb::TextureMips& mips,
+                    const std::vector<std::vector<uint8_t>>& compressed)
+{
+    static const uint8_t IDENTIFIER[12] = {
+        0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+    };
+
+    std::string out((const char*)IDENTIFIER, sizeof(IDENTIFIER));
+    put32(out, 0x04030201);             // endianness
+    put32(out, 0);                      // glType: compressed
+    put32(out, 1);                      // glTypeSize
+    put32(out, 0);                      // glFormat: compressed
+    put32(out, internalFormat);
+    put32(out, baseInternalFormat);
+    put32(out, mips.levels[0].width);
+    put32(out, mips.levels[0].height);
+    put32(out, 0);                      // pixelDepth
+    put32(out, 0);                      // numberOfArrayElements
+    put32(out, 1);                      // numberOfFaces
+    put32(out, (uint32_t)mips.levels.size());
+    put32(out, 0);                      // bytesOfKeyValueData
+
+    for (const std::vector<uint8_t>& level: compressed) {
+        // block sizes are multiples of 4, so no mipPadding is needed
+        put32(out, (uint32_t)level.size());
+        out.append((const char*)level.data(), level.size());
+    }
+
+    return out;
+}
+
+std::string getOutputPath(const std::string& input)
+{
+    size_t dot = input.rfind('.');
+    size_t slash = input.rfind('/');
+    if (dot == std::string::npos
+            || (slash != std::string::npos && dot < slash)) {
+        return input + ".ktx";
+    }
+    return input.substr(0, dot) + ".ktx";
+}
+
+bool convert(const std::string& input,
+             Format format)
+{
+    sb::Image image;
+    if (!image.loadFromFile(input)) {
+        fprintf(stderr, "%s: cannot load image\n", input.c_str());
+        return false;
+    }
+
+    // keep DevIL's row order, so that the result maps like the image
+    const void* rgba = image.getRGBAData();
+    if (!rgba) {
+        fprintf(stderr, "%s: cannot convert to RGBA\n", input.c_str());
+        return false;
+    }
+    // same mip chain as streamed uncompressed textures get
+    const sb::TextureMips mips = sb::TextureMips::fromRGBA(rgba, image.getWidth(),
+                                                           image.getHeight());
+    const std::vector<sb::TextureMips::Level>& levels = mips.levels;
+
+    const bool useBC3 = format == Format::BC3
+                        || (format == Format::Auto && hasAlpha(levels[0]));
+
+    std::vector<std::vector<uint8_t>> compressed;
+    size_t compressedBytes = 0;
+    for (const sb::TextureMips::Level& level: levels) {
+        const uint8_t* data = (const uint8_t*)level.data;
+        compressed.push_back(useBC3
+                ? texconv::encodeBC3(data, level.width, level.height)
+                : texconv::encodeBC1(data, level.width, level.height));
+        compressedBytes += compressed.back().size();
+    }
+
+    const std::string output = getOutputPath(input);
+    const std::string data = useBC3
+            ? makeKTX(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, mips, compressed)
+            : makeKTX(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB, mips, compressed);
+    if (!sb::utils::writeFileAtomic(output, data)) {
+        fprintf(stderr, "%s: cannot write\n", output.c_str());
+        return false;
+    }
+
+    // RGBA8 with runtime-generated mipmaps takes 4/3 of the base level
+    const size_t uncompressedBytes = (size_t)levels[0].width * levels[0].height * 4 * 4 / 3;
+    printf("%s -> %s: %ux%u, %s, %lu levels, %lu KiB (%.1fx smaller)\n",
+           input.c_str(), output.c_str(), levels[0].width, levels[0].height,
+           useBC3 ? "BC3" : "BC1", levels.size(), compressedBytes / 1024,
+           (double)uncompressedBytes / (double)compressedBytes);
+    return true;
+}
+
+void printUsage(const char* program)
+{
+    fprintf(stderr, "usage: %s [--bc1 | --bc3] image...\n", program);
+}
+
+} // namespace
+
+int main(int argc,
+         char** argv)
+{
+    Format format = Format::Auto;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--bc1")) {
+            format = Format::BC1;
+        } else if (!strcmp(argv[i], "--bc3")) {
+            format = Format::BC3;
+        } else if (argv[i][0] == '-') {
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            inputs.push_back(argv[i]);
+        }
+    }
+
+    if (inputs.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ilInit();
+    iluInit();
+
+    bool ok = true;
+    for (const std::string& input: inputs) {
+        ok = convert(input, format) && ok;
+    }
+    return ok ? 0 : 1;
+}